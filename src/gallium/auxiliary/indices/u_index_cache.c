@@ -0,0 +1,92 @@
+/*
+ * Copyright 2009 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.  IN NO EVENT SHALL
+ * TUNGSTEN GRAPHICS AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "indices/u_index_cache.h"
+#include "util/u_inlines.h"
+
+
+/**
+ * Find the translated buffer for the given source range.
+ * \return a new reference to the buffer, or NULL on a miss
+ */
+struct pipe_resource *
+u_index_cache_lookup( struct u_index_cache *cache,
+                      u_translate_func translate,
+                      unsigned offset,
+                      unsigned nr )
+{
+   unsigned i;
+
+   for (i = 0; i < U_INDEX_CACHE_SIZE; i++) {
+      struct u_index_cache_entry *entry = &cache->entry[i];
+
+      if (entry->buffer &&
+          entry->translate == translate &&
+          entry->offset == offset &&
+          entry->nr == nr) {
+         struct pipe_resource *buffer = NULL;
+         pipe_resource_reference( &buffer, entry->buffer );
+         return buffer;
+      }
+   }
+
+   return NULL;
+}
+
+
+/**
+ * Remember a translated buffer, replacing the oldest entry.
+ * The cache takes its own reference to the buffer.
+ */
+void u_index_cache_insert( struct u_index_cache *cache,
+                           u_translate_func translate,
+                           unsigned offset,
+                           unsigned nr,
+                           struct pipe_resource *buffer )
+{
+   struct u_index_cache_entry *entry = &cache->entry[cache->next];
+
+   pipe_resource_reference( &entry->buffer, buffer );
+   entry->translate = translate;
+   entry->offset = offset;
+   entry->nr = nr;
+
+   cache->next = (cache->next + 1) % U_INDEX_CACHE_SIZE;
+}
+
+
+/**
+ * Drop all translated buffers, e.g. because the source was written to
+ * or is being destroyed.
+ */
+void u_index_cache_invalidate( struct u_index_cache *cache )
+{
+   unsigned i;
+
+   for (i = 0; i < U_INDEX_CACHE_SIZE; i++)
+      pipe_resource_reference( &cache->entry[i].buffer, NULL );
+
+   cache->next = 0;
+}
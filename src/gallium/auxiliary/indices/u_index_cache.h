@@ -0,0 +1,81 @@
+/*
+ * Copyright 2009 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.  IN NO EVENT SHALL
+ * TUNGSTEN GRAPHICS AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/**
+ * @file
+ * Small per-buffer cache of translated index buffers.
+ *
+ * Drivers which translate index buffers with u_index_translator() or
+ * u_unfilled_translator() can embed a struct u_index_cache in their
+ * buffer objects and keep the translated buffers there, so that static
+ * index buffers are translated only once.  The translate function
+ * identifies the primitive, the index sizes, the provoking vertex
+ * conversion and the fill mode, so the key is just the function plus
+ * the source range.  The driver must call u_index_cache_invalidate()
+ * whenever the source buffer may be written.
+ */
+
+#ifndef U_INDEX_CACHE_H
+#define U_INDEX_CACHE_H
+
+#include "pipe/p_compiler.h"
+#include "indices/u_indices.h"
+
+struct pipe_resource;
+
+
+#define U_INDEX_CACHE_SIZE 4
+
+struct u_index_cache_entry
+{
+   u_translate_func translate;
+   unsigned offset;
+   unsigned nr;
+   struct pipe_resource *buffer;
+};
+
+struct u_index_cache
+{
+   struct u_index_cache_entry entry[U_INDEX_CACHE_SIZE];
+   unsigned next;
+};
+
+
+struct pipe_resource *
+u_index_cache_lookup( struct u_index_cache *cache,
+                      u_translate_func translate,
+                      unsigned offset,
+                      unsigned nr );
+
+void u_index_cache_insert( struct u_index_cache *cache,
+                           u_translate_func translate,
+                           unsigned offset,
+                           unsigned nr,
+                           struct pipe_resource *buffer );
+
+void u_index_cache_invalidate( struct u_index_cache *cache );
+
+
+#endif
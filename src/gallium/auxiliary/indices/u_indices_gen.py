@@ -75,6 +75,7 @@ def prolog():
 #include "util/u_debug.h"
 #include "pipe/p_defines.h"
 #include "util/u_memory.h"
+#include "util/u_sse.h"
 
 
 static unsigned out_size_idx( unsigned index_size )
@@ -266,6 +267,72 @@ def emit_funcs():
                     quadstrip(intype, outtype, inpv, outpv)
                     polygon(intype, outtype, inpv, outpv)
 
+def emit_sse_funcs():
+    # Quads to triangles with ushort indices is the most common
+    # translation, so it gets a hand-written SSE2 version.  Only the case
+    # where the provoking vertex is unchanged is handled; each quad
+    # (a,b,c,d) becomes the dwords (a,b) (d,b) (c,d).
+    print r'''
+#if defined(PIPE_ARCH_SSE)
+
+static void translate_quads_ushort2ushort_sse2(
+    const void * _in,
+    unsigned nr,
+    void *_out )
+{
+  const ushort*in = (const ushort*)_in;
+  ushort *out = (ushort*)_out;
+  unsigned i, j;
+
+  /* Four quads per iteration: 16 indices in, 24 indices out.
+   * x = A0 A1 B0 B1, y = C0 C1 D0 D1 (dwords of index pairs),
+   * mx = Am Am Bm Bm, my = Cm Cm Dm Dm where Am = (A.d, A.b).
+   */
+  for (j = i = 0; j + 24 <= nr; j += 24, i += 16) {
+    __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+    __m128i y = _mm_loadu_si128((const __m128i *)(in + i + 8));
+    __m128i mx = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(1,3,1,3)),
+                                     _MM_SHUFFLE(1,3,1,3));
+    __m128i my = _mm_shufflehi_epi16(_mm_shufflelo_epi16(y, _MM_SHUFFLE(1,3,1,3)),
+                                     _MM_SHUFFLE(1,3,1,3));
+    __m128 fx = _mm_castsi128_ps(x);
+    __m128 fy = _mm_castsi128_ps(y);
+    __m128 fmx = _mm_castsi128_ps(mx);
+    __m128 fmy = _mm_castsi128_ps(my);
+    __m128 p = _mm_unpacklo_ps(fx, fmx);   /* A0 Am A1 Am */
+    __m128 q = _mm_unpackhi_ps(fmx, fx);   /* Bm B0 Bm B1 */
+    __m128 r = _mm_unpacklo_ps(fy, fmy);   /* C0 Cm C1 Cm */
+    __m128 s = _mm_unpackhi_ps(fmy, fy);   /* Dm D0 Dm D1 */
+
+    _mm_storeu_ps((float *)(out + j),
+                  _mm_shuffle_ps(p, fx, _MM_SHUFFLE(2,1,1,0)));
+    _mm_storeu_ps((float *)(out + j + 8),
+                  _mm_shuffle_ps(q, r, _MM_SHUFFLE(1,0,3,2)));
+    _mm_storeu_ps((float *)(out + j + 16),
+                  _mm_shuffle_ps(fy, s, _MM_SHUFFLE(3,2,2,1)));
+  }
+
+  for ( ; j < nr; j+=6, i+=4) { 
+      (out+j+0)[0] = (ushort)in[i+0];
+      (out+j+0)[1] = (ushort)in[i+1];
+      (out+j+0)[2] = (ushort)in[i+3];
+      (out+j+3)[0] = (ushort)in[i+1];
+      (out+j+3)[1] = (ushort)in[i+2];
+      (out+j+3)[2] = (ushort)in[i+3];
+   }
+}
+
+#endif /* PIPE_ARCH_SSE */
+'''
+
+def emit_sse_inits():
+    print '#if defined(PIPE_ARCH_SSE)'
+    for pv in PVS:
+        print ('  translate[IN_USHORT][OUT_USHORT][' + pv_idx[pv] + '][' +
+               pv_idx[pv] + '][PIPE_PRIM_QUADS] = ' +
+               'translate_quads_ushort2ushort_sse2;')
+    print '#endif'
+
 def init(intype, outtype, inpv, outpv, prim):
     if intype == GENERATE:
         print ('generate[' + 
@@ -299,6 +366,7 @@ def emit_init():
     print '  if (!firsttime) return;'
     print '  firsttime = 0;'
     emit_all_inits()
+    emit_sse_inits()
     print '}'
 
 
@@ -311,6 +379,7 @@ def epilog():
 def main():
     prolog()
     emit_funcs()
+    emit_sse_funcs()
     emit_init()
     epilog()
 
@@ -53,31 +53,379 @@
 
 /*
  * Allocate a large block of memory which can hold code then dole it out
- * in pieces by means of the generic memory manager code.
+ * in pieces by means of the generic memory manager code.  The heap is
+ * shared by all contexts and all code generators in the process.
+ *
+ * Where possible the heap is mapped twice from the same memory object:
+ * once writable, where the code generators emit their code, and once
+ * executable, from where it is run.  No page is ever both writable and
+ * executable.  The x86 and ppc emitters only generate position
+ * independent code, so code may run at a different address than it was
+ * written at; see rtasm_exec_code_ptr().  If the second mapping can't be
+ * made we fall back to a single RWX mapping as before.
+ *
+ * Unlike the private anonymous RWX mapping, the shared memory object
+ * would not be copied on write by fork(), and code emitted by either
+ * process would overwrite live code of the other.  So the dual mapping
+ * isn't inherited (MADV_DONTFORK) and the child gets a private copy of
+ * the code allocated at fork time, mapped at the same addresses; see
+ * exec_atfork_child().
+ *
+ * Environment variables:
+ *  GALLIUM_EXEC_WX=0         always use a single RWX mapping
+ *  GALLIUM_EXEC_HUGEPAGES=1  back the heap with 2MB pages if possible,
+ *                            to cut down on iTLB misses
+ *  GALLIUM_EXEC_STATS=1      print heap statistics whenever the heap
+ *                            becomes empty again or runs out of space
  */
 
 #include <unistd.h>
 #include <sys/mman.h>
+#include "util/u_math.h"
 #include "util/u_mm.h"
 
+#if defined(PIPE_OS_LINUX)
+#include <sys/syscall.h>
+#endif
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_HUGETLB
+#define MFD_HUGETLB 0x0004U
+#endif
+
 #define EXEC_HEAP_SIZE (10*1024*1024)
+#define EXEC_HUGE_PAGE_SIZE (2*1024*1024)
+#define EXEC_PAGE_SIZE 4096
+#define EXEC_MIN_ALLOC 32
+
+DEBUG_GET_ONCE_BOOL_OPTION(exec_wx, "GALLIUM_EXEC_WX", TRUE)
+DEBUG_GET_ONCE_BOOL_OPTION(exec_hugepages, "GALLIUM_EXEC_HUGEPAGES", FALSE)
+DEBUG_GET_ONCE_BOOL_OPTION(exec_stats, "GALLIUM_EXEC_STATS", FALSE)
 
 pipe_static_mutex(exec_mutex);
 
 static struct mem_block *exec_heap = NULL;
-static unsigned char *exec_mem = NULL;
+static unsigned char *exec_mem = NULL;   /**< writable view of the heap */
+static unsigned char *exec_code = NULL;  /**< executable view of the heap */
+static boolean exec_init_done = FALSE;
+
+static struct {
+   unsigned blocks;        /**< live allocations */
+   unsigned bytes;         /**< bytes in live allocations */
+   unsigned peak_bytes;
+   unsigned allocs;
+   unsigned failures;
+} exec_stats;
+
+
+/**
+ * Map size bytes at an address aligned to the huge page size, so that
+ * the kernel can back the mapping with huge pages.
+ */
+static unsigned char *
+map_aligned(size_t size, int prot, int flags, int fd)
+{
+   const size_t align = EXEC_HUGE_PAGE_SIZE;
+   unsigned char *reserve, *addr, *map;
+   size_t head;
+
+   reserve = (unsigned char *) mmap(0, size + align, PROT_NONE,
+                                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (reserve == MAP_FAILED)
+      return NULL;
+
+   addr = (unsigned char *)
+      (((uintptr_t) reserve + align - 1) & ~(uintptr_t) (align - 1));
+   head = addr - reserve;
+
+   map = (unsigned char *) mmap(addr, size, prot, flags | MAP_FIXED, fd, 0);
+   if (map == MAP_FAILED) {
+      munmap(reserve, size + align);
+      return NULL;
+   }
+
+   if (head)
+      munmap(reserve, head);
+   if (align - head)
+      munmap(addr + size, align - head);
+
+#ifdef MADV_HUGEPAGE
+   madvise(map, size, MADV_HUGEPAGE);
+#endif
 
+   return map;
+}
+
+
+#if defined(PIPE_OS_LINUX) && defined(SYS_memfd_create)
+
+/** Copy of the allocated code for the child, made while forking */
+static int exec_fork_fd = -1;
+
+
+/**
+ * Create a memory object for the heap.  Not backed by huge pages unless
+ * asked for.
+ */
+static int
+create_heap_fd(boolean huge)
+{
+   int fd = -1;
+
+   if (huge)
+      fd = syscall(SYS_memfd_create, "gallium-exec", MFD_CLOEXEC | MFD_HUGETLB);
+   if (fd < 0)
+      fd = syscall(SYS_memfd_create, "gallium-exec", MFD_CLOEXEC);
+   if (fd < 0)
+      return -1;
+
+   if (ftruncate(fd, EXEC_HEAP_SIZE) != 0) {
+      close(fd);
+      return -1;
+   }
 
+   return fd;
+}
+
+
+/**
+ * pthread_atfork() prepare handler: copy all allocated blocks into a new
+ * memory object for the child.  Holding the mutex keeps the heap from
+ * changing until the copy is mapped in the child.
+ */
 static void
-init_heap(void)
+exec_atfork_prepare(void)
 {
+   const struct mem_block *p;
+   boolean ok = TRUE;
+
+   pipe_mutex_lock(exec_mutex);
+
    if (!exec_heap)
+      return;
+
+   exec_fork_fd = create_heap_fd(FALSE);
+   if (exec_fork_fd < 0)
+      return;
+
+   for (p = exec_heap->next; p != exec_heap && ok; p = p->next) {
+      if (!p->free)
+         ok = pwrite(exec_fork_fd, exec_mem + p->ofs, p->size, p->ofs) ==
+              (ssize_t) p->size;
+   }
+
+   if (!ok) {
+      close(exec_fork_fd);
+      exec_fork_fd = -1;
+   }
+}
+
+
+static void
+exec_atfork_parent(void)
+{
+   if (exec_fork_fd >= 0) {
+      close(exec_fork_fd);
+      exec_fork_fd = -1;
+   }
+
+   pipe_mutex_unlock(exec_mutex);
+}
+
+
+/**
+ * pthread_atfork() child handler: the heap mappings weren't inherited, so
+ * map the private copy in their place.  If that fails the heap is dropped;
+ * new allocations then fail and the code generators fall back to their
+ * non-generated paths.
+ */
+static void
+exec_atfork_child(void)
+{
+   if (exec_heap) {
+      unsigned char *mem = MAP_FAILED, *code = MAP_FAILED;
+
+      if (exec_fork_fd >= 0) {
+         mem = (unsigned char *) mmap(exec_mem, EXEC_HEAP_SIZE,
+                                      PROT_READ | PROT_WRITE,
+                                      MAP_SHARED | MAP_FIXED,
+                                      exec_fork_fd, 0);
+         code = (unsigned char *) mmap(exec_code, EXEC_HEAP_SIZE,
+                                       PROT_READ | PROT_EXEC,
+                                       MAP_SHARED | MAP_FIXED,
+                                       exec_fork_fd, 0);
+      }
+
+      if (mem == MAP_FAILED || code == MAP_FAILED) {
+         if (mem != MAP_FAILED)
+            munmap(mem, EXEC_HEAP_SIZE);
+         if (code != MAP_FAILED)
+            munmap(code, EXEC_HEAP_SIZE);
+         u_mmDestroy(exec_heap);
+         exec_heap = NULL;
+         exec_mem = exec_code = NULL;
+      }
+   }
+
+   exec_atfork_parent();
+}
+
+#endif
+
+
+/**
+ * Map the heap twice, writable and executable.
+ */
+static boolean
+init_dual_mapping(boolean huge)
+{
+#if defined(PIPE_OS_LINUX) && defined(SYS_memfd_create)
+   static boolean atfork_done = FALSE;
+   int fd;
+
+   fd = create_heap_fd(huge);
+   if (fd < 0)
+      return FALSE;
+
+   if (huge) {
+      exec_mem = map_aligned(EXEC_HEAP_SIZE, PROT_READ | PROT_WRITE,
+                             MAP_SHARED, fd);
+      exec_code = map_aligned(EXEC_HEAP_SIZE, PROT_READ | PROT_EXEC,
+                              MAP_SHARED, fd);
+   }
+   else {
+      exec_mem = (unsigned char *) mmap(0, EXEC_HEAP_SIZE,
+                                        PROT_READ | PROT_WRITE,
+                                        MAP_SHARED, fd, 0);
+      exec_code = (unsigned char *) mmap(0, EXEC_HEAP_SIZE,
+                                         PROT_READ | PROT_EXEC,
+                                         MAP_SHARED, fd, 0);
+      if (exec_mem == MAP_FAILED)
+         exec_mem = NULL;
+      if (exec_code == MAP_FAILED)
+         exec_code = NULL;
+   }
+
+   close(fd);
+
+   if (!exec_mem || !exec_code) {
+      if (exec_mem)
+         munmap(exec_mem, EXEC_HEAP_SIZE);
+      if (exec_code)
+         munmap(exec_code, EXEC_HEAP_SIZE);
+      exec_mem = exec_code = NULL;
+      return FALSE;
+   }
+
+   if (madvise(exec_mem, EXEC_HEAP_SIZE, MADV_DONTFORK) != 0 ||
+       madvise(exec_code, EXEC_HEAP_SIZE, MADV_DONTFORK) != 0 ||
+       (!atfork_done &&
+        pthread_atfork(exec_atfork_prepare, exec_atfork_parent,
+                       exec_atfork_child) != 0)) {
+      munmap(exec_mem, EXEC_HEAP_SIZE);
+      munmap(exec_code, EXEC_HEAP_SIZE);
+      exec_mem = exec_code = NULL;
+      return FALSE;
+   }
+   atfork_done = TRUE;
+
+   return TRUE;
+#else
+   (void) huge;
+   return FALSE;
+#endif
+}
+
+
+/**
+ * Map the heap once, writable and executable.
+ */
+static boolean
+init_single_mapping(boolean huge)
+{
+   if (huge) {
+      exec_mem = map_aligned(EXEC_HEAP_SIZE,
+                             PROT_EXEC | PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1);
+   }
+   else {
+      exec_mem = (unsigned char *) mmap(0, EXEC_HEAP_SIZE,
+                                        PROT_EXEC | PROT_READ | PROT_WRITE,
+                                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (exec_mem == MAP_FAILED)
+         exec_mem = NULL;
+   }
+
+   exec_code = exec_mem;
+   return exec_mem != NULL;
+}
+
+
+static void
+init_heap(void)
+{
+   boolean huge;
+
+   if (exec_init_done)
+      return;
+   exec_init_done = TRUE;
+
+   huge = debug_get_option_exec_hugepages();
+
+   if (!debug_get_option_exec_wx() ||
+       (!init_dual_mapping(huge) && !(huge && init_dual_mapping(FALSE))))
+      init_single_mapping(huge);
+
+   if (exec_mem)
       exec_heap = u_mmInit( 0, EXEC_HEAP_SIZE );
-   
-   if (!exec_mem)
-      exec_mem = (unsigned char *) mmap(0, EXEC_HEAP_SIZE, 
-					PROT_EXEC | PROT_READ | PROT_WRITE, 
-					MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+}
+
+
+/**
+ * Round the allocation size up to its size class: powers of two below
+ * a page and whole pages above.  Freed blocks then fit later requests of
+ * the same class exactly, which keeps the heap from fragmenting as
+ * shaders and vertex paths of varying sizes come and go.
+ */
+static unsigned
+size_class(size_t size)
+{
+   if (size <= EXEC_MIN_ALLOC)
+      return EXEC_MIN_ALLOC;
+   if (size < EXEC_PAGE_SIZE)
+      return util_next_power_of_two((unsigned) size);
+   return align((int) size, EXEC_PAGE_SIZE);
+}
+
+
+static void
+dump_stats_locked(void)
+{
+   unsigned free_bytes = 0, free_blocks = 0, largest_free = 0;
+
+   if (exec_heap) {
+      const struct mem_block *p;
+
+      for (p = exec_heap->next_free; p != exec_heap; p = p->next_free) {
+         free_bytes += p->size;
+         free_blocks++;
+         if ((unsigned) p->size > largest_free)
+            largest_free = p->size;
+      }
+   }
+
+   debug_printf("rtasm_execmem: %s mapping, %u blocks, %u bytes used, "
+                "%u peak, %u allocations, %u failed\n",
+                exec_code != exec_mem ? "W^X" : "RWX",
+                exec_stats.blocks, exec_stats.bytes,
+                exec_stats.peak_bytes, exec_stats.allocs,
+                exec_stats.failures);
+   debug_printf("rtasm_execmem: %u bytes free in %u blocks, "
+                "largest %u (%u%% fragmented)\n",
+                free_bytes, free_blocks, largest_free,
+                free_bytes ? 100 - largest_free * 100 / free_bytes : 0);
 }
 
 
@@ -92,14 +440,30 @@ rtasm_exec_malloc(size_t size)
    init_heap();
 
    if (exec_heap) {
-      size = (size + 31) & ~31;  /* next multiple of 32 bytes */
-      block = u_mmAllocMem( exec_heap, size, 5, 0 ); /* 5 -> 32-byte alignment */
+      unsigned alloc_size = size_class(size);
+
+      /* 32-byte alignment, which also keeps the blocks of the small size
+       * classes from straddling cache lines needlessly.
+       */
+      block = u_mmAllocMem( exec_heap, alloc_size, 5, 0 );
+
+      if (block) {
+         exec_stats.blocks++;
+         exec_stats.bytes += block->size;
+         exec_stats.allocs++;
+         if (exec_stats.bytes > exec_stats.peak_bytes)
+            exec_stats.peak_bytes = exec_stats.bytes;
+      }
    }
 
    if (block)
       addr = exec_mem + block->ofs;
-   else 
+   else {
+      exec_stats.failures++;
       debug_printf("rtasm_exec_malloc failed\n");
+      if (debug_get_option_exec_stats())
+         dump_stats_locked();
+   }
    
    pipe_mutex_unlock(exec_mutex);
    
@@ -115,14 +479,41 @@ rtasm_exec_free(void *addr)
    if (exec_heap) {
       struct mem_block *block = u_mmFindBlock(exec_heap, (unsigned char *)addr - exec_mem);
    
-      if (block)
+      if (block) {
+         exec_stats.blocks--;
+         exec_stats.bytes -= block->size;
 	 u_mmFreeMem(block);
+
+         if (exec_stats.blocks == 0 && debug_get_option_exec_stats())
+            dump_stats_locked();
+      }
    }
 
    pipe_mutex_unlock(exec_mutex);
 }
 
 
+void *
+rtasm_exec_code_ptr(void *addr)
+{
+   if (!addr || !exec_mem ||
+       (unsigned char *)addr < exec_mem ||
+       (unsigned char *)addr >= exec_mem + EXEC_HEAP_SIZE)
+      return addr;
+
+   return exec_code + ((unsigned char *)addr - exec_mem);
+}
+
+
+void
+rtasm_exec_dump_stats(void)
+{
+   pipe_mutex_lock(exec_mutex);
+   dump_stats_locked();
+   pipe_mutex_unlock(exec_mutex);
+}
+
+
 #elif defined(PIPE_OS_WINDOWS)
 
 
@@ -144,6 +535,19 @@ rtasm_exec_free(void *addr)
 }
 
 
+void *
+rtasm_exec_code_ptr(void *addr)
+{
+   return addr;
+}
+
+
+void
+rtasm_exec_dump_stats(void)
+{
+}
+
+
 #else
 
 
@@ -165,4 +569,17 @@ rtasm_exec_free(void *addr)
 }
 
 
+void *
+rtasm_exec_code_ptr(void *addr)
+{
+   return addr;
+}
+
+
+void
+rtasm_exec_dump_stats(void)
+{
+}
+
+
 #endif
@@ -42,4 +42,17 @@ extern void
 rtasm_exec_free( void *addr );
 
 
+/**
+ * Return the address from which the code written at addr (as returned by
+ * rtasm_exec_malloc()) can be executed.  This differs from addr when the
+ * heap is mapped twice, writable and executable.
+ */
+extern void *
+rtasm_exec_code_ptr( void *addr );
+
+
+extern void
+rtasm_exec_dump_stats( void );
+
+
 #endif
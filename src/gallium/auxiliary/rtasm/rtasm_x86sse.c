@@ -2206,7 +2206,7 @@ x86_func x86_get_func( struct x86_function *p )
    if (p->store == p->error_overflow)
       return voidptr_to_x86_func(NULL);
    else
-      return voidptr_to_x86_func(p->store);
+      return voidptr_to_x86_func(rtasm_exec_code_ptr(p->store));
 }
 
 #else
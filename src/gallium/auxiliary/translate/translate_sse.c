@@ -1425,6 +1425,8 @@ static void translate_sse_release( struct translate *translate )
 
    x86_release_func( &p->linear_func );
    x86_release_func( &p->elt_func );
+   x86_release_func( &p->elt16_func );
+   x86_release_func( &p->elt8_func );
 
    os_free_aligned(p);
 }
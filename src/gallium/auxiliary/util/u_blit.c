@@ -49,6 +49,7 @@
 #include "util/u_simple_shaders.h"
 
 #include "cso_cache/cso_context.h"
+#include "cso_cache/cso_hash.h"
 
 
 struct blit_state
@@ -69,6 +70,7 @@ struct blit_state
    void *vs;
    void *fs[TGSI_WRITEMASK_XYZW + 1];
    void *fs_depth;
+   struct cso_hash *fs_swizzle;  /**< swizzling shaders, keyed by swizzle */
 
    struct pipe_resource *vbuf;  /**< quad vertices */
    unsigned vbuf_slot;
@@ -179,6 +181,15 @@ util_destroy_blit(struct blit_state *ctx)
    if (ctx->fs_depth)
       pipe->delete_fs_state(pipe, ctx->fs_depth);
 
+   if (ctx->fs_swizzle) {
+      struct cso_hash_iter iter = cso_hash_first_node(ctx->fs_swizzle);
+      while (!cso_hash_iter_is_null(iter)) {
+         pipe->delete_fs_state(pipe, cso_hash_iter_data(iter));
+         iter = cso_hash_iter_next(iter);
+      }
+      cso_hash_delete(ctx->fs_swizzle);
+   }
+
    pipe_resource_reference(&ctx->vbuf, NULL);
 
    FREE(ctx);
@@ -278,28 +289,67 @@ regions_overlap(int srcX0, int srcY0,
 }
 
 
+static INLINE boolean
+is_identity_swizzle(const unsigned char swizzle[4])
+{
+   return (swizzle[0] == PIPE_SWIZZLE_RED &&
+           swizzle[1] == PIPE_SWIZZLE_GREEN &&
+           swizzle[2] == PIPE_SWIZZLE_BLUE &&
+           swizzle[3] == PIPE_SWIZZLE_ALPHA);
+}
+
+
 /**
- * Copy pixel block from src surface to dst surface.
- * Overlapping regions are acceptable.
- * Flipping and stretching are supported.
- * \param filter  one of PIPE_TEX_MIPFILTER_NEAREST/LINEAR
- * \param writemask  controls which channels in the dest surface are sourced
- *                   from the src surface.  Disabled channels are sourced
- *                   from (0,0,0,1).
- * XXX need some control over blitting stencil.
+ * Get (or create) the fragment shader which rearranges the src texel
+ * channels according to the given swizzle.
  */
-void
-util_blit_pixels_writemask(struct blit_state *ctx,
-                           struct pipe_resource *src_tex,
-                           unsigned src_level,
-                           int srcX0, int srcY0,
-                           int srcX1, int srcY1,
-                           int srcZ0,
-                           struct pipe_surface *dst,
-                           int dstX0, int dstY0,
-                           int dstX1, int dstY1,
-                           float z, uint filter,
-                           uint writemask)
+static void *
+get_swizzle_fs(struct blit_state *ctx, const unsigned char swizzle[4])
+{
+   const unsigned key = (swizzle[0] |
+                         (swizzle[1] << 3) |
+                         (swizzle[2] << 6) |
+                         (swizzle[3] << 9));
+   struct cso_hash_iter iter;
+   void *fs;
+
+   if (!ctx->fs_swizzle) {
+      ctx->fs_swizzle = cso_hash_create();
+      if (!ctx->fs_swizzle)
+         return NULL;
+   }
+
+   iter = cso_hash_find(ctx->fs_swizzle, key);
+   if (!cso_hash_iter_is_null(iter))
+      return cso_hash_iter_data(iter);
+
+   fs = util_make_fragment_tex_shader_swizzle(ctx->pipe, TGSI_TEXTURE_2D,
+                                              TGSI_INTERPOLATE_LINEAR,
+                                              swizzle);
+   if (fs)
+      cso_hash_insert(ctx->fs_swizzle, key, fs);
+
+   return fs;
+}
+
+
+/**
+ * Common code for the util_blit_pixels_x() functions.
+ * If swizzle is non-NULL it takes precedence over the writemask.
+ */
+static void
+blit_pixels(struct blit_state *ctx,
+            struct pipe_resource *src_tex,
+            unsigned src_level,
+            int srcX0, int srcY0,
+            int srcX1, int srcY1,
+            int srcZ0,
+            struct pipe_surface *dst,
+            int dstX0, int dstY0,
+            int dstX1, int dstY1,
+            float z, uint filter,
+            uint writemask,
+            const unsigned char *swizzle)
 {
    struct pipe_context *pipe = ctx->pipe;
    struct pipe_screen *screen = pipe->screen;
@@ -312,6 +362,7 @@ util_blit_pixels_writemask(struct blit_state *ctx,
    boolean overlap, dst_is_depth;
    float s0, t0, s1, t1;
    boolean normalized;
+   void *swizzle_fs = NULL;
 
    assert(filter == PIPE_TEX_MIPFILTER_NEAREST ||
           filter == PIPE_TEX_MIPFILTER_LINEAR);
@@ -331,6 +382,7 @@ util_blit_pixels_writemask(struct blit_state *ctx,
     * Filter mode should not matter since there's no stretching.
     */
    if (dst->format == src_tex->format &&
+       (!swizzle || is_identity_swizzle(swizzle)) &&
        srcX0 < srcX1 &&
        dstX0 < dstX1 &&
        srcY0 < srcY1 &&
@@ -468,6 +520,18 @@ util_blit_pixels_writemask(struct blit_state *ctx,
                                       dst->texture->nr_samples,
                                       dst_is_depth ? PIPE_BIND_DEPTH_STENCIL :
                                                      PIPE_BIND_RENDER_TARGET, 0));
+
+   /* get the swizzle shader before touching any state, so the blit can be
+    * skipped if it can't be created
+    */
+   if (!dst_is_depth && swizzle && !is_identity_swizzle(swizzle)) {
+      swizzle_fs = get_swizzle_fs(ctx, swizzle);
+      if (!swizzle_fs) {
+         pipe_sampler_view_reference(&sampler_view, NULL);
+         return;
+      }
+   }
+
    /* save state (restored below) */
    cso_save_blend(ctx->cso);
    cso_save_depth_stencil_alpha(ctx->cso);
@@ -521,6 +585,8 @@ util_blit_pixels_writemask(struct blit_state *ctx,
                                                      TGSI_INTERPOLATE_LINEAR);
 
       cso_set_fragment_shader_handle(ctx->cso, ctx->fs_depth);
+   } else if (swizzle_fs) {
+      cso_set_fragment_shader_handle(ctx->cso, swizzle_fs);
    } else {
       if (ctx->fs[writemask] == NULL)
          ctx->fs[writemask] =
@@ -576,6 +642,63 @@ util_blit_pixels_writemask(struct blit_state *ctx,
 }
 
 
+/**
+ * Copy pixel block from src surface to dst surface.
+ * Overlapping regions are acceptable.
+ * Flipping and stretching are supported.
+ * \param filter  one of PIPE_TEX_MIPFILTER_NEAREST/LINEAR
+ * \param writemask  controls which channels in the dest surface are sourced
+ *                   from the src surface.  Disabled channels are sourced
+ *                   from (0,0,0,1).
+ * XXX need some control over blitting stencil.
+ */
+void
+util_blit_pixels_writemask(struct blit_state *ctx,
+                           struct pipe_resource *src_tex,
+                           unsigned src_level,
+                           int srcX0, int srcY0,
+                           int srcX1, int srcY1,
+                           int srcZ0,
+                           struct pipe_surface *dst,
+                           int dstX0, int dstY0,
+                           int dstX1, int dstY1,
+                           float z, uint filter,
+                           uint writemask)
+{
+   blit_pixels(ctx, src_tex, src_level,
+               srcX0, srcY0, srcX1, srcY1, srcZ0,
+               dst, dstX0, dstY0, dstX1, dstY1,
+               z, filter, writemask, NULL);
+}
+
+
+/**
+ * Like util_blit_pixels_writemask(), but with format conversion between
+ * src and dst described by a swizzle: dest channel i is taken from src
+ * channel swizzle[i], or is 0 / 1 for PIPE_SWIZZLE_ZERO / ONE.  This
+ * covers luminance, intensity and alpha conversions as well as forcing
+ * A=1 when the src has no alpha.  Ignored for depth/stencil destinations.
+ */
+void
+util_blit_pixels_swizzle(struct blit_state *ctx,
+                         struct pipe_resource *src_tex,
+                         unsigned src_level,
+                         int srcX0, int srcY0,
+                         int srcX1, int srcY1,
+                         int srcZ0,
+                         struct pipe_surface *dst,
+                         int dstX0, int dstY0,
+                         int dstX1, int dstY1,
+                         float z, uint filter,
+                         const unsigned char swizzle[4])
+{
+   blit_pixels(ctx, src_tex, src_level,
+               srcX0, srcY0, srcX1, srcY1, srcZ0,
+               dst, dstX0, dstY0, dstX1, dstY1,
+               z, filter, TGSI_WRITEMASK_XYZW, swizzle);
+}
+
+
 void
 util_blit_pixels(struct blit_state *ctx,
                  struct pipe_resource *src_tex,
@@ -76,6 +76,19 @@ util_blit_pixels_writemask(struct blit_state *ctx,
                            float z, uint filter,
                            uint writemask);
 
+void
+util_blit_pixels_swizzle(struct blit_state *ctx,
+                         struct pipe_resource *src_tex,
+                         unsigned src_level,
+                         int srcX0, int srcY0,
+                         int srcX1, int srcY1,
+                         int srcZ0,
+                         struct pipe_surface *dst,
+                         int dstX0, int dstY0,
+                         int dstX1, int dstY1,
+                         float z, uint filter,
+                         const unsigned char swizzle[4]);
+
 extern void
 util_blit_pixels_tex(struct blit_state *ctx,
                      struct pipe_sampler_view *src_sampler_view,
@@ -152,6 +152,78 @@ util_make_fragment_tex_shader(struct pipe_context *pipe, unsigned tex_target,
 }
 
 
+/**
+ * Make a fragment texture shader which rearranges the texel channels:
+ *  IMM {0,1,0,0}
+ *  TEX TEMP[0], IN[0], SAMP[0], 2D;
+ *  MOV OUT[0].x, TEMP[0].swizzle[0];     // or IMM[0].x/y for ZERO/ONE
+ *  ...
+ *  MOV OUT[0].w, TEMP[0].swizzle[3];
+ *  END;
+ *
+ * \param swizzle  four PIPE_SWIZZLE_x values, one per output channel
+ */
+void *
+util_make_fragment_tex_shader_swizzle(struct pipe_context *pipe,
+                                      unsigned tex_target,
+                                      unsigned interp_mode,
+                                      const unsigned char swizzle[4])
+{
+   struct ureg_program *ureg;
+   struct ureg_src sampler;
+   struct ureg_src tex;
+   struct ureg_src imm;
+   struct ureg_dst out;
+   struct ureg_dst temp;
+   unsigned i;
+
+   assert(interp_mode == TGSI_INTERPOLATE_LINEAR ||
+          interp_mode == TGSI_INTERPOLATE_PERSPECTIVE);
+
+   ureg = ureg_create( TGSI_PROCESSOR_FRAGMENT );
+   if (ureg == NULL)
+      return NULL;
+
+   sampler = ureg_DECL_sampler( ureg, 0 );
+
+   tex = ureg_DECL_fs_input( ureg,
+                             TGSI_SEMANTIC_GENERIC, 0,
+                             interp_mode );
+
+   out = ureg_DECL_output( ureg,
+                           TGSI_SEMANTIC_COLOR,
+                           0 );
+
+   temp = ureg_DECL_temporary( ureg );
+   imm = ureg_imm4f( ureg, 0, 1, 0, 0 );
+
+   ureg_TEX( ureg, temp, tex_target, tex, sampler );
+
+   for (i = 0; i < 4; i++) {
+      struct ureg_src src;
+
+      switch (swizzle[i]) {
+      case PIPE_SWIZZLE_ZERO:
+         src = ureg_scalar(imm, TGSI_SWIZZLE_X);
+         break;
+      case PIPE_SWIZZLE_ONE:
+         src = ureg_scalar(imm, TGSI_SWIZZLE_Y);
+         break;
+      default:
+         assert(swizzle[i] <= PIPE_SWIZZLE_ALPHA);
+         src = ureg_scalar(ureg_src(temp), swizzle[i]);
+         break;
+      }
+
+      ureg_MOV( ureg, ureg_writemask(out, 1 << i), src );
+   }
+
+   ureg_END( ureg );
+
+   return ureg_create_shader_and_destroy( ureg, pipe );
+}
+
+
 /**
  * Make a simple fragment texture shader which reads an X component from
  * a texture and writes it as depth.
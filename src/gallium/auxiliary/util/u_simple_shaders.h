@@ -59,6 +59,12 @@ extern void *
 util_make_fragment_tex_shader(struct pipe_context *pipe, unsigned tex_target,
                               unsigned interp_mode);
 
+extern void *
+util_make_fragment_tex_shader_swizzle(struct pipe_context *pipe,
+                                      unsigned tex_target,
+                                      unsigned interp_mode,
+                                      const unsigned char swizzle[4]);
+
 
 extern void *
 util_make_fragment_tex_shader_writedepth(struct pipe_context *pipe,
@@ -182,8 +182,11 @@ llvmpipe_displaytarget_layout(struct llvmpipe_screen *screen,
 {
    struct sw_winsys *winsys = screen->winsys;
 
-   /* Round up the surface size to a multiple of the tile size to
-    * avoid tile clipping.
+   /* The tile layout covers the surface size rounded up to a multiple of
+    * the tile size, but the winsys memory only needs to hold the surface
+    * itself: edge tiles are clipped when converted to/from linear (see
+    * linear_tile_size()).  This allows rendering straight into memory
+    * provided by the winsys' client.
     */
    const unsigned width = align(lpr->base.width0, TILE_SIZE);
    const unsigned height = align(lpr->base.height0, TILE_SIZE);
@@ -201,7 +204,8 @@ llvmpipe_displaytarget_layout(struct llvmpipe_screen *screen,
    lpr->dt = winsys->displaytarget_create(winsys,
                                           lpr->base.bind,
                                           lpr->base.format,
-                                          width, height,
+                                          lpr->base.width0,
+                                          lpr->base.height0,
                                           16,
                                           &lpr->row_stride[0] );
 
@@ -961,6 +965,27 @@ alloc_image_data(struct llvmpipe_resource *lpr, unsigned level,
 
 
 
+/**
+ * Compute the size of the part of the tile at (x, y) which is backed by
+ * the linear image.  Display target memory comes from the winsys and
+ * isn't padded to whole tiles, so conversions must stop at its edges.
+ */
+static INLINE void
+linear_tile_size(const struct llvmpipe_resource *lpr, unsigned level,
+                 unsigned x, unsigned y, unsigned *w, unsigned *h)
+{
+   if (lpr->dt) {
+      assert(level == 0);
+      *w = MIN2(TILE_SIZE, lpr->base.width0 - x);
+      *h = MIN2(TILE_SIZE, lpr->base.height0 - y);
+   }
+   else {
+      *w = TILE_SIZE;
+      *h = TILE_SIZE;
+   }
+}
+
+
 /**
  * Return pointer to texture image data (either linear or tiled layout)
  * for a particular cube face or 3D texture slice.
@@ -1069,10 +1094,15 @@ llvmpipe_get_texture_image(struct llvmpipe_resource *lpr,
             layout_logic(cur_layout, layout, usage, &new_layout, &convert);
 
             if (convert && other_data && target_data) {
+               unsigned tw, th;
+
+               linear_tile_size(lpr, level, x * TILE_SIZE, y * TILE_SIZE,
+                                &tw, &th);
+
                if (layout == LP_TEX_LAYOUT_TILED) {
                   lp_linear_to_tiled(other_data, target_data,
                                      x * TILE_SIZE, y * TILE_SIZE,
-                                     TILE_SIZE, TILE_SIZE,
+                                     tw, th,
                                      lpr->base.format,
                                      lpr->row_stride[level],
                                      lpr->tiles_per_row[level]);
@@ -1081,7 +1111,7 @@ llvmpipe_get_texture_image(struct llvmpipe_resource *lpr,
                   assert(layout == LP_TEX_LAYOUT_LINEAR);
                   lp_tiled_to_linear(other_data, target_data,
                                      x * TILE_SIZE, y * TILE_SIZE,
-                                     TILE_SIZE, TILE_SIZE,
+                                     tw, th,
                                      lpr->base.format,
                                      lpr->row_stride[level],
                                      lpr->tiles_per_row[level]);
@@ -1170,8 +1200,11 @@ llvmpipe_get_texture_tile_linear(struct llvmpipe_resource *lpr,
                 &new_layout, &convert);
 
    if (convert && tiled_image && linear_image) {
+      unsigned tw, th;
+
+      linear_tile_size(lpr, level, x, y, &tw, &th);
       lp_tiled_to_linear(tiled_image, linear_image,
-                         x, y, TILE_SIZE, TILE_SIZE, lpr->base.format,
+                         x, y, tw, th, lpr->base.format,
                          lpr->row_stride[level],
                          lpr->tiles_per_row[level]);
    }
@@ -1219,8 +1252,11 @@ llvmpipe_get_texture_tile(struct llvmpipe_resource *lpr,
 
    layout_logic(cur_layout, LP_TEX_LAYOUT_TILED, usage, &new_layout, &convert);
    if (convert && linear_image && tiled_image) {
+      unsigned tw, th;
+
+      linear_tile_size(lpr, level, x, y, &tw, &th);
       lp_linear_to_tiled(linear_image, tiled_image,
-                         x, y, TILE_SIZE, TILE_SIZE, lpr->base.format,
+                         x, y, tw, th, lpr->base.format,
                          lpr->row_stride[level],
                          lpr->tiles_per_row[level]);
    }
@@ -1269,7 +1305,10 @@ llvmpipe_unswizzle_cbuf_tile(struct llvmpipe_resource *lpr,
       uint ii = x, jj = y;
       uint tile_offset = jj / TILE_SIZE + ii / TILE_SIZE;
       uint byte_offset = tile_offset * TILE_SIZE * TILE_SIZE * 4;
+      unsigned tw, th;
       
+      linear_tile_size(lpr, level, x, y, &tw, &th);
+
       /* Note that lp_tiled_to_linear expects the tile parameter to
        * point at the first tile in a whole-image sized array.  In
        * this code, we have only a single tile and have to do some
@@ -1277,7 +1316,7 @@ llvmpipe_unswizzle_cbuf_tile(struct llvmpipe_resource *lpr,
        * started.
        */
       lp_tiled_to_linear(tile - byte_offset, linear_image,
-                         x, y, TILE_SIZE, TILE_SIZE,
+                         x, y, tw, th,
                          lpr->base.format,
                          lpr->row_stride[level],
                          1);       /* tiles per row */
@@ -1311,6 +1350,9 @@ llvmpipe_swizzle_cbuf_tile(struct llvmpipe_resource *lpr,
       uint ii = x, jj = y;
       uint tile_offset = jj / TILE_SIZE + ii / TILE_SIZE;
       uint byte_offset = tile_offset * TILE_SIZE * TILE_SIZE * 4;
+      unsigned tw, th;
+
+      linear_tile_size(lpr, level, x, y, &tw, &th);
 
       /* Note that lp_linear_to_tiled expects the tile parameter to
        * point at the first tile in a whole-image sized array.  In
@@ -1319,7 +1361,7 @@ llvmpipe_swizzle_cbuf_tile(struct llvmpipe_resource *lpr,
        * started.
        */
       lp_linear_to_tiled(linear_image, tile - byte_offset,
-                         x, y, TILE_SIZE, TILE_SIZE,
+                         x, y, tw, th,
                          lpr->base.format,
                          lpr->row_stride[level],
                          1);       /* tiles per row */
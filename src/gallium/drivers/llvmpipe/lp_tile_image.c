@@ -33,6 +33,8 @@
 
 
 #include "util/u_format.h"
+#include "util/u_math.h"
+#include "util/u_rect.h"
 #include "lp_tile_soa.h"
 #include "lp_tile_image.h"
 
@@ -120,8 +122,49 @@ tile_4_4_uint16(const uint16_t *src, uint16_t *dst, unsigned src_stride)
 
 
 
+/**
+ * Untile a color tile of which only the top-left w x h pixels lie inside
+ * the linear image, going through a temporary linear tile.
+ */
+static void
+untile_partial_color_tile(const uint8_t *src_tile, void *dst,
+                          unsigned dst_stride, unsigned x, unsigned y,
+                          unsigned w, unsigned h, enum pipe_format format)
+{
+   PIPE_ALIGN_VAR(16) uint8_t tmp[TILE_SIZE * TILE_SIZE * 16];
+   const unsigned tmp_stride = TILE_SIZE * util_format_get_blocksize(format);
+
+   lp_tile_unswizzle_4ub(format, src_tile, tmp, tmp_stride, 0, 0);
+
+   util_copy_rect(dst, format, dst_stride, x, y, w, h,
+                  tmp, tmp_stride, 0, 0);
+}
+
+
+/**
+ * Counterpart of untile_partial_color_tile().  The pixels of the tile
+ * outside the linear image are left undefined.
+ */
+static void
+tile_partial_color_tile(const void *src, uint8_t *dst_tile,
+                        unsigned src_stride, unsigned x, unsigned y,
+                        unsigned w, unsigned h, enum pipe_format format)
+{
+   PIPE_ALIGN_VAR(16) uint8_t tmp[TILE_SIZE * TILE_SIZE * 16];
+   const unsigned tmp_stride = TILE_SIZE * util_format_get_blocksize(format);
+
+   util_copy_rect(tmp, format, tmp_stride, 0, 0, w, h,
+                  src, src_stride, x, y);
+
+   lp_tile_swizzle_4ub(format, dst_tile, tmp, tmp_stride, 0, 0);
+}
+
+
 /**
  * Convert a tiled image into a linear image.
+ * Color images don't need to be a whole number of tiles in size: when
+ * width or height isn't a multiple of TILE_SIZE, only the covered part of
+ * the last tile column/row is written.
  * \param dst_stride  dest row stride in bytes
  */
 void
@@ -201,10 +244,16 @@ lp_tiled_to_linear(const void *src, void *dst,
             uint byte_offset = tile_offset * bytes_per_tile;
             const uint8_t *src_tile = (uint8_t *) src + byte_offset;
 
-            lp_tile_unswizzle_4ub(format,
-                              src_tile,
-                              dst, dst_stride,
-                              ii, jj);
+            if (i + tile_w <= width && j + tile_h <= height)
+               lp_tile_unswizzle_4ub(format,
+                                 src_tile,
+                                 dst, dst_stride,
+                                 ii, jj);
+            else
+               untile_partial_color_tile(src_tile, dst, dst_stride, ii, jj,
+                                         MIN2(tile_w, width - i),
+                                         MIN2(tile_h, height - j),
+                                         format);
          }
       }
    }
@@ -213,6 +262,7 @@ lp_tiled_to_linear(const void *src, void *dst,
 
 /**
  * Convert a linear image into a tiled image.
+ * As with lp_tiled_to_linear(), color images may end in partial tiles.
  * \param src_stride  source row stride in bytes
  */
 void
@@ -290,10 +340,16 @@ lp_linear_to_tiled(const void *src, void *dst,
             uint byte_offset = tile_offset * bytes_per_tile;
             uint8_t *dst_tile = (uint8_t *) dst + byte_offset;
 
-            lp_tile_swizzle_4ub(format,
-                             dst_tile,
-                             src, src_stride,
-                             ii, jj);
+            if (i + tile_w <= width && j + tile_h <= height)
+               lp_tile_swizzle_4ub(format,
+                                dst_tile,
+                                src, src_stride,
+                                ii, jj);
+            else
+               tile_partial_color_tile(src, dst_tile, src_stride, ii, jj,
+                                       MIN2(tile_w, width - i),
+                                       MIN2(tile_h, height - j),
+                                       format);
          }
       }
    }
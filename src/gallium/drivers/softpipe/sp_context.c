@@ -88,6 +88,13 @@ softpipe_destroy( struct pipe_context *pipe )
    struct softpipe_context *softpipe = softpipe_context( pipe );
    uint i;
 
+   if (softpipe->dump_stats) {
+      debug_printf("softpipe: %llu quads shaded, %llu quads rejected by "
+                   "hierarchical Z\n",
+                   (unsigned long long) softpipe->stats.quads_shaded,
+                   (unsigned long long) softpipe->stats.quads_hiz_rejected);
+   }
+
    if (softpipe->draw)
       draw_destroy( softpipe->draw );
 
@@ -95,6 +102,7 @@ softpipe_destroy( struct pipe_context *pipe )
    softpipe->quad.depth_test->destroy( softpipe->quad.depth_test );
    softpipe->quad.blend->destroy( softpipe->quad.blend );
    softpipe->quad.pstipple->destroy( softpipe->quad.pstipple );
+   softpipe->quad.fused->destroy( softpipe->quad.fused );
 
    for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++) {
       sp_destroy_tile_cache(softpipe->cbuf_cache[i]);
@@ -221,6 +229,8 @@ softpipe_create_context( struct pipe_screen *screen,
 
    softpipe->dump_fs = debug_get_bool_option( "GALLIUM_DUMP_FS", FALSE );
    softpipe->dump_gs = debug_get_bool_option( "SOFTPIPE_DUMP_GS", FALSE );
+   softpipe->no_fused_quads = debug_get_bool_option( "SOFTPIPE_NO_FUSED", FALSE );
+   softpipe->dump_stats = debug_get_bool_option( "SOFTPIPE_DUMP_STATS", FALSE );
 
    softpipe->pipe.winsys = NULL;
    softpipe->pipe.screen = screen;
@@ -274,6 +284,7 @@ softpipe_create_context( struct pipe_screen *screen,
    softpipe->quad.depth_test = sp_quad_depth_test_stage(softpipe);
    softpipe->quad.blend = sp_quad_blend_stage(softpipe);
    softpipe->quad.pstipple = sp_quad_polygon_stipple_stage(softpipe);
+   softpipe->quad.fused = sp_quad_fused_stage(softpipe);
 
 
    /*
@@ -298,6 +309,10 @@ softpipe_create_context( struct pipe_screen *screen,
    if (debug_get_bool_option( "SP_NO_RAST", FALSE ))
       softpipe->no_rast = TRUE;
 
+   /* Rasterize triangles a scanline pair at a time rather than in blocks */
+   softpipe->scanline_rast = debug_get_bool_option( "SOFTPIPE_SCANLINE_RAST",
+                                                    FALSE );
+
    softpipe->vbuf_backend = sp_create_vbuf_backend(softpipe);
    if (!softpipe->vbuf_backend)
       goto fail;
@@ -107,6 +107,15 @@ struct softpipe_context {
    uint64_t occlusion_count;
    unsigned active_query_count;
 
+   /** Quads run through the fragment shader vs. quads discarded by the
+    * coarse depth test in setup, printed on exit if SOFTPIPE_DUMP_STATS
+    * is set.
+    */
+   struct {
+      uint64_t quads_shaded;
+      uint64_t quads_hiz_rejected;
+   } stats;
+
    /** Mapped vertex buffers */
    ubyte *mapped_vbuffer[PIPE_MAX_ATTRIBS];
 
@@ -149,6 +158,7 @@ struct softpipe_context {
       struct quad_stage *depth_test;
       struct quad_stage *blend;
       struct quad_stage *pstipple;
+      struct quad_stage *fused;  /**< depth+shade+blend in one stage */
       struct quad_stage *first; /**< points to one of the above stages */
    } quad;
 
@@ -180,8 +190,11 @@ struct softpipe_context {
 
    unsigned use_sse : 1;
    unsigned dump_fs : 1;
+   unsigned no_fused_quads : 1;
    unsigned dump_gs : 1;
    unsigned no_rast : 1;
+   unsigned scanline_rast : 1;
+   unsigned dump_stats : 1;
 };
 
 
@@ -226,6 +226,8 @@ write_depth_stencil_values( struct depth_data *data,
    struct softpipe_cached_tile *tile = data->tile;
    unsigned j;
 
+   sp_tile_zbounds_dirty(tile, quad->input.x0, quad->input.y0);
+
    /* put updated Z values back into cached tile */
    switch (data->format) {
    case PIPE_FORMAT_Z16_UNORM:
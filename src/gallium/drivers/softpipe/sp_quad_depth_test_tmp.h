@@ -44,6 +44,9 @@
  * NOTE: there's no guarantee that the quads are sequentially side by
  * side.  The fragment shader may have culled some quads, etc.  Sliver
  * triangles may generate non-sequential quads.
+ *
+ * A batch may span several rows of quads (see flush_blocks() in
+ * sp_setup.c).  The Z stepping restarts at the first quad of each row.
  */
 static void
 NAME(struct quad_stage *qs, 
@@ -51,32 +54,41 @@ NAME(struct quad_stage *qs,
      unsigned nr)
 {
    unsigned i, pass = 0;
-   const unsigned ix = quads[0]->input.x0;
-   const unsigned iy = quads[0]->input.y0;
-   const float fx = (float) ix;
-   const float fy = (float) iy;
+   unsigned ix = quads[0]->input.x0;
+   unsigned iy = ~0U;
    const float dzdx = quads[0]->posCoef->dadx[2];
    const float dzdy = quads[0]->posCoef->dady[2];
-   const float z0 = quads[0]->posCoef->a0[2] + dzdx * fx + dzdy * fy;
    struct softpipe_cached_tile *tile;
    ushort (*depth16)[TILE_SIZE];
-   ushort init_idepth[4], idepth[4], depth_step;
+   ushort init_idepth[4] = { 0, 0, 0, 0 }, idepth[4], depth_step;
    const float scale = 65535.0;
 
-   /* compute scaled depth of the four pixels in first quad */
-   init_idepth[0] = (ushort)((z0) * scale);
-   init_idepth[1] = (ushort)((z0 + dzdx) * scale);
-   init_idepth[2] = (ushort)((z0 + dzdy) * scale);
-   init_idepth[3] = (ushort)((z0 + dzdx + dzdy) * scale);
-
    depth_step = (ushort)(dzdx * scale);
 
-   tile = sp_get_cached_tile(qs->softpipe->zsbuf_cache, ix, iy);
+   tile = sp_get_cached_tile(qs->softpipe->zsbuf_cache, ix, quads[0]->input.y0);
 
    for (i = 0; i < nr; i++) {
       const unsigned outmask = quads[i]->inout.mask;
-      const int dx = quads[i]->input.x0 - ix;
+      int dx;
       unsigned mask = 0;
+
+      if (quads[i]->input.y0 != iy) {
+         float fx, fy, z0;
+
+         ix = quads[i]->input.x0;
+         iy = quads[i]->input.y0;
+         fx = (float) ix;
+         fy = (float) iy;
+         z0 = quads[i]->posCoef->a0[2] + dzdx * fx + dzdy * fy;
+
+         /* compute scaled depth of the four pixels in first quad */
+         init_idepth[0] = (ushort)((z0) * scale);
+         init_idepth[1] = (ushort)((z0 + dzdx) * scale);
+         init_idepth[2] = (ushort)((z0 + dzdy) * scale);
+         init_idepth[3] = (ushort)((z0 + dzdx + dzdy) * scale);
+      }
+
+      dx = quads[i]->input.x0 - ix;
       
       /* compute depth for this quad */
       idepth[0] = init_idepth[0] + dx * depth_step;
@@ -132,6 +144,9 @@ NAME(struct quad_stage *qs,
 
       depth16 = (ushort (*)[TILE_SIZE]) &depth16[0][2];
 
+      if (mask)
+         sp_tile_zbounds_dirty(tile, quads[i]->input.x0, quads[i]->input.y0);
+
       quads[i]->inout.mask = mask;
       if (quads[i]->inout.mask)
          quads[pass++] = quads[i];
@@ -117,6 +117,8 @@ shade_quads(struct quad_stage *qs,
 
    machine->InterpCoefs = quads[0]->coef;
 
+   softpipe->stats.quads_shaded += nr;
+
    for (i = 0; i < nr; i++) {
       if (!shade_quad(qs, quads[i]))
          continue; /* quad totally culled/killed */
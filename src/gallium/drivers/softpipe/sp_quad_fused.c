@@ -0,0 +1,324 @@
+/**************************************************************************
+ *
+ * Copyright 2011 VMware, Inc.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * Fused quad stage: early depth test, fragment shading and color write /
+ * blend in a single pass over the quads, with the depth and color tiles
+ * looked up once per batch.
+ *
+ * The variants are instantiated from sp_quad_fused_tmp.h for the most
+ * common depth/blend combinations.  sp_quad_fused_choose() picks one for
+ * the current state, or returns FALSE in which case the pipeline is built
+ * from the generic shade/depth_test/blend stages instead.
+ */
+
+#include "pipe/p_defines.h"
+#include "util/u_memory.h"
+#include "tgsi/tgsi_exec.h"
+#include "sp_context.h"
+#include "sp_quad.h"
+#include "sp_quad_pipe.h"
+#include "sp_state.h"
+#include "sp_tile_cache.h"
+
+
+#define FUSED_BLEND_REPLACE                  0
+#define FUSED_BLEND_ONE_ONE                  1
+#define FUSED_BLEND_SRC_ALPHA_INV_SRC_ALPHA  2
+
+
+struct quad_fused_stage
+{
+   struct quad_stage stage;  /**< base class */
+
+   unsigned zshift;   /**< position of the 24 Z bits in the depth word */
+   unsigned zkeep;    /**< depth word bits to preserve when writing Z */
+};
+
+
+/** cast wrapper */
+static INLINE struct quad_fused_stage *
+quad_fused_stage(struct quad_stage *qs)
+{
+   return (struct quad_fused_stage *) qs;
+}
+
+
+/* No depth test */
+
+#define NAME fused_replace
+#define BLEND FUSED_BLEND_REPLACE
+#include "sp_quad_fused_tmp.h"
+
+#define NAME fused_one_one
+#define BLEND FUSED_BLEND_ONE_ONE
+#include "sp_quad_fused_tmp.h"
+
+#define NAME fused_src_alpha
+#define BLEND FUSED_BLEND_SRC_ALPHA_INV_SRC_ALPHA
+#include "sp_quad_fused_tmp.h"
+
+
+/* GL_LESS */
+
+#define NAME fused_less_replace
+#define OPERATOR <
+#define DEPTH_WRITE 0
+#define BLEND FUSED_BLEND_REPLACE
+#include "sp_quad_fused_tmp.h"
+
+#define NAME fused_less_one_one
+#define OPERATOR <
+#define DEPTH_WRITE 0
+#define BLEND FUSED_BLEND_ONE_ONE
+#include "sp_quad_fused_tmp.h"
+
+#define NAME fused_less_src_alpha
+#define OPERATOR <
+#define DEPTH_WRITE 0
+#define BLEND FUSED_BLEND_SRC_ALPHA_INV_SRC_ALPHA
+#include "sp_quad_fused_tmp.h"
+
+#define NAME fused_less_write_replace
+#define OPERATOR <
+#define DEPTH_WRITE 1
+#define BLEND FUSED_BLEND_REPLACE
+#include "sp_quad_fused_tmp.h"
+
+#define NAME fused_less_write_one_one
+#define OPERATOR <
+#define DEPTH_WRITE 1
+#define BLEND FUSED_BLEND_ONE_ONE
+#include "sp_quad_fused_tmp.h"
+
+#define NAME fused_less_write_src_alpha
+#define OPERATOR <
+#define DEPTH_WRITE 1
+#define BLEND FUSED_BLEND_SRC_ALPHA_INV_SRC_ALPHA
+#include "sp_quad_fused_tmp.h"
+
+
+/* GL_LEQUAL */
+
+#define NAME fused_lequal_replace
+#define OPERATOR <=
+#define DEPTH_WRITE 0
+#define BLEND FUSED_BLEND_REPLACE
+#include "sp_quad_fused_tmp.h"
+
+#define NAME fused_lequal_one_one
+#define OPERATOR <=
+#define DEPTH_WRITE 0
+#define BLEND FUSED_BLEND_ONE_ONE
+#include "sp_quad_fused_tmp.h"
+
+#define NAME fused_lequal_src_alpha
+#define OPERATOR <=
+#define DEPTH_WRITE 0
+#define BLEND FUSED_BLEND_SRC_ALPHA_INV_SRC_ALPHA
+#include "sp_quad_fused_tmp.h"
+
+#define NAME fused_lequal_write_replace
+#define OPERATOR <=
+#define DEPTH_WRITE 1
+#define BLEND FUSED_BLEND_REPLACE
+#include "sp_quad_fused_tmp.h"
+
+#define NAME fused_lequal_write_one_one
+#define OPERATOR <=
+#define DEPTH_WRITE 1
+#define BLEND FUSED_BLEND_ONE_ONE
+#include "sp_quad_fused_tmp.h"
+
+#define NAME fused_lequal_write_src_alpha
+#define OPERATOR <=
+#define DEPTH_WRITE 1
+#define BLEND FUSED_BLEND_SRC_ALPHA_INV_SRC_ALPHA
+#include "sp_quad_fused_tmp.h"
+
+
+typedef void (*fused_func)(struct quad_stage *qs,
+                           struct quad_header *quads[],
+                           unsigned nr);
+
+/** Indexed by [depth write][blend] */
+static const fused_func fused_less[2][3] = {
+   { fused_less_replace, fused_less_one_one, fused_less_src_alpha },
+   { fused_less_write_replace, fused_less_write_one_one,
+     fused_less_write_src_alpha }
+};
+
+static const fused_func fused_lequal[2][3] = {
+   { fused_lequal_replace, fused_lequal_one_one, fused_lequal_src_alpha },
+   { fused_lequal_write_replace, fused_lequal_write_one_one,
+     fused_lequal_write_src_alpha }
+};
+
+static const fused_func fused_nodepth[3] = {
+   fused_replace, fused_one_one, fused_src_alpha
+};
+
+
+/**
+ * Map the blend state onto one of the FUSED_BLEND_x modes.
+ * \return -1 if the state isn't handled by the fused functions
+ */
+static int
+choose_fused_blend(const struct softpipe_context *sp)
+{
+   const struct pipe_blend_state *blend = sp->blend;
+   const struct pipe_rt_blend_state *rt = &blend->rt[0];
+
+   if (sp->framebuffer.nr_cbufs != 1 ||
+       !sp->framebuffer.cbufs[0] ||
+       blend->logicop_enable ||
+       rt->colormask != 0xf)
+      return -1;
+
+   if (!rt->blend_enable)
+      return FUSED_BLEND_REPLACE;
+
+   if (rt->rgb_src_factor != rt->alpha_src_factor ||
+       rt->rgb_dst_factor != rt->alpha_dst_factor ||
+       rt->rgb_func != PIPE_BLEND_ADD ||
+       rt->alpha_func != PIPE_BLEND_ADD)
+      return -1;
+
+   if (rt->rgb_src_factor == PIPE_BLENDFACTOR_ONE &&
+       rt->rgb_dst_factor == PIPE_BLENDFACTOR_ONE)
+      return FUSED_BLEND_ONE_ONE;
+
+   if (rt->rgb_src_factor == PIPE_BLENDFACTOR_SRC_ALPHA &&
+       rt->rgb_dst_factor == PIPE_BLENDFACTOR_INV_SRC_ALPHA)
+      return FUSED_BLEND_SRC_ALPHA_INV_SRC_ALPHA;
+
+   return -1;
+}
+
+
+/**
+ * Select the fused function for the current state.
+ * \return FALSE if the generic stage chain must be used
+ */
+boolean
+sp_quad_fused_choose(struct quad_stage *qs)
+{
+   struct quad_fused_stage *fused = quad_fused_stage(qs);
+   const struct softpipe_context *sp = qs->softpipe;
+   const struct pipe_depth_stencil_alpha_state *dsa = sp->depth_stencil;
+   const struct sp_fragment_shader *fs = sp->fs;
+   boolean depth = dsa->depth.enabled && sp->framebuffer.zsbuf;
+   boolean depthwrite = dsa->depth.writemask;
+   int blend;
+
+   if (sp->no_fused_quads ||
+       dsa->alpha.enabled ||
+       dsa->stencil[0].enabled ||
+       sp->active_query_count)
+      return FALSE;
+
+   blend = choose_fused_blend(sp);
+   if (blend < 0)
+      return FALSE;
+
+   if (!depth) {
+      qs->run = fused_nodepth[blend];
+      return TRUE;
+   }
+
+   /* The depth test must be done before shading. */
+   if (fs->info.uses_kill ||
+       fs->info.writes_z ||
+       fs->info.writes_stencil)
+      return FALSE;
+
+   switch (sp->framebuffer.zsbuf->format) {
+   case PIPE_FORMAT_Z24X8_UNORM:
+      fused->zshift = 0;
+      fused->zkeep = 0;
+      break;
+   case PIPE_FORMAT_Z24_UNORM_S8_USCALED:
+      fused->zshift = 0;
+      fused->zkeep = 0xff000000;
+      break;
+   case PIPE_FORMAT_X8Z24_UNORM:
+      fused->zshift = 8;
+      fused->zkeep = 0;
+      break;
+   case PIPE_FORMAT_S8_USCALED_Z24_UNORM:
+      fused->zshift = 8;
+      fused->zkeep = 0xff;
+      break;
+   default:
+      return FALSE;
+   }
+
+   switch (dsa->depth.func) {
+   case PIPE_FUNC_LESS:
+      qs->run = fused_less[depthwrite][blend];
+      return TRUE;
+   case PIPE_FUNC_LEQUAL:
+      qs->run = fused_lequal[depthwrite][blend];
+      return TRUE;
+   default:
+      return FALSE;
+   }
+}
+
+
+static void
+fused_begin(struct quad_stage *qs)
+{
+   struct softpipe_context *softpipe = qs->softpipe;
+
+   softpipe->fs->prepare( softpipe->fs,
+			  softpipe->fs_machine,
+			  (struct tgsi_sampler **)
+                             softpipe->tgsi.frag_samplers_list );
+}
+
+
+static void
+fused_destroy(struct quad_stage *qs)
+{
+   FREE( qs );
+}
+
+
+struct quad_stage *
+sp_quad_fused_stage( struct softpipe_context *softpipe )
+{
+   struct quad_fused_stage *stage = CALLOC_STRUCT(quad_fused_stage);
+   if (!stage)
+      return NULL;
+
+   stage->stage.softpipe = softpipe;
+   stage->stage.begin = fused_begin;
+   stage->stage.run = fused_replace;
+   stage->stage.destroy = fused_destroy;
+
+   return &stage->stage;
+}
@@ -0,0 +1,174 @@
+/**************************************************************************
+ *
+ * Copyright 2011 VMware, Inc.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/*
+ * Template for generating fused depth/shade/blend quad functions.
+ *
+ * NAME      - the function name
+ * OPERATOR  - depth compare operator; leave undefined for no depth test
+ * DEPTH_WRITE - 1 if passing Z values are written back
+ * BLEND     - one of the FUSED_BLEND_x values
+ *
+ * Only 24-bit Z in a 32-bit word is handled; the position of the Z bits
+ * and the bits to preserve come from the stage (zshift, zkeep).
+ * The arithmetic matches interpolate_quad_depth(), convert_quad_depth()
+ * and the single-cbuf blend fast paths exactly.
+ */
+
+
+#ifndef NAME
+#error "NAME is not defined!"
+#endif
+
+#ifndef BLEND
+#error "BLEND is not defined!"
+#endif
+
+
+static void
+NAME(struct quad_stage *qs,
+     struct quad_header *quads[],
+     unsigned nr)
+{
+   struct softpipe_context *softpipe = qs->softpipe;
+   struct sp_fragment_shader *fs = softpipe->fs;
+   struct tgsi_exec_machine *machine = softpipe->fs_machine;
+   struct softpipe_cached_tile *ctile
+      = sp_get_cached_tile(softpipe->cbuf_cache[0],
+                           quads[0]->input.x0,
+                           quads[0]->input.y0);
+#ifdef OPERATOR
+   const struct quad_fused_stage *fused = quad_fused_stage(qs);
+   const unsigned zshift = fused->zshift;
+#if DEPTH_WRITE
+   const unsigned zkeep = fused->zkeep;
+#endif
+   struct softpipe_cached_tile *ztile
+      = sp_get_cached_tile(softpipe->zsbuf_cache,
+                           quads[0]->input.x0,
+                           quads[0]->input.y0);
+   const float dzdx = quads[0]->posCoef->dadx[2];
+   const float dzdy = quads[0]->posCoef->dady[2];
+   const float a0z = quads[0]->posCoef->a0[2];
+   const float scale = (float) ((1 << 24) - 1);
+#endif
+   unsigned i, j, q;
+
+   tgsi_exec_set_constant_buffers(machine, PIPE_MAX_CONSTANT_BUFFERS,
+                         softpipe->mapped_constants[PIPE_SHADER_FRAGMENT],
+                         softpipe->const_buffer_size[PIPE_SHADER_FRAGMENT]);
+
+   machine->InterpCoefs = quads[0]->coef;
+
+   for (q = 0; q < nr; q++) {
+      struct quad_header *quad = quads[q];
+      float (*quadColor)[4] = quad->output.color[0];
+      const int itx = (quad->input.x0 & (TILE_SIZE-1));
+      const int ity = (quad->input.y0 & (TILE_SIZE-1));
+
+#ifdef OPERATOR
+      {
+         const float fx = (float) quad->input.x0;
+         const float fy = (float) quad->input.y0;
+         const float z0 = a0z + dzdx * fx + dzdy * fy;
+         float depth[QUAD_SIZE];
+         unsigned zmask = 0;
+
+         depth[0] = z0;
+         depth[1] = z0 + dzdx;
+         depth[2] = z0 + dzdy;
+         depth[3] = z0 + dzdx + dzdy;
+
+         for (j = 0; j < QUAD_SIZE; j++) {
+            const uint word = ztile->data.depth32[ity + (j >> 1)][itx + (j & 1)];
+            const unsigned qz = (unsigned) (depth[j] * scale);
+            const unsigned bz = (word >> zshift) & 0xffffff;
+
+            if (qz OPERATOR bz) {
+               zmask |= 1 << j;
+            }
+         }
+
+         quad->inout.mask &= zmask;
+         if (quad->inout.mask == 0)
+            continue;
+
+#if DEPTH_WRITE
+         /* Like write_depth_stencil_values(), rewrite all four words so
+          * that unused bits end up the same as with the generic path.
+          */
+         for (j = 0; j < QUAD_SIZE; j++) {
+            uint *word = &ztile->data.depth32[ity + (j >> 1)][itx + (j & 1)];
+            unsigned z = (*word >> zshift) & 0xffffff;
+
+            if (quad->inout.mask & (1 << j))
+               z = (unsigned) (depth[j] * scale);
+
+            *word = (z << zshift) | (*word & zkeep);
+         }
+         sp_tile_zbounds_dirty(ztile, quad->input.x0, quad->input.y0);
+#endif
+      }
+#endif /* OPERATOR */
+
+      softpipe->stats.quads_shaded++;
+
+      if (!fs->run( fs, machine, quad ))
+         continue; /* quad totally culled/killed */
+
+      for (j = 0; j < QUAD_SIZE; j++) {
+         if (quad->inout.mask & (1 << j)) {
+            float *dest = ctile->data.color[ity + (j >> 1)][itx + (j & 1)];
+#if BLEND == FUSED_BLEND_SRC_ALPHA_INV_SRC_ALPHA
+            const float alpha = quadColor[3][j];
+            const float one_minus_alpha = 1.0f - alpha;
+#endif
+
+            for (i = 0; i < 4; i++) {
+#if BLEND == FUSED_BLEND_REPLACE
+               dest[i] = quadColor[i][j];
+#else
+#if BLEND == FUSED_BLEND_ONE_ONE
+               float c = quadColor[i][j] + dest[i];
+#else
+               float c = quadColor[i][j] * alpha + dest[i] * one_minus_alpha;
+#endif
+               if (c > 1.0f)
+                  c = 1.0f;
+               dest[i] = c;
+#endif
+            }
+         }
+      }
+   }
+}
+
+
+#undef NAME
+#undef OPERATOR
+#undef DEPTH_WRITE
+#undef BLEND
@@ -42,21 +42,28 @@ sp_push_quad_first( struct softpipe_context *sp,
 void
 sp_build_quad_pipeline(struct softpipe_context *sp)
 {
+   /* Depth/stencil testing before shading gives the same results whenever
+    * the shader can't change the outcome.
+    */
    boolean early_depth_test =
-      sp->depth_stencil->depth.enabled &&
+      (sp->depth_stencil->depth.enabled ||
+       sp->depth_stencil->stencil[0].enabled) &&
       sp->framebuffer.zsbuf &&
       !sp->depth_stencil->alpha.enabled &&
       !sp->fs->info.uses_kill &&
       !sp->fs->info.writes_z &&
       !sp->fs->info.writes_stencil;
 
-   sp->quad.first = sp->quad.blend;
-
-   if (early_depth_test) {
+   if (sp_quad_fused_choose(sp->quad.fused)) {
+      sp->quad.first = sp->quad.fused;
+   }
+   else if (early_depth_test) {
+      sp->quad.first = sp->quad.blend;
       sp_push_quad_first( sp, sp->quad.shade );
       sp_push_quad_first( sp, sp->quad.depth_test );
    }
    else {
+      sp->quad.first = sp->quad.blend;
       sp_push_quad_first( sp, sp->quad.depth_test );
       sp_push_quad_first( sp, sp->quad.shade );
    }
@@ -31,6 +31,8 @@
 #ifndef SP_QUAD_PIPE_H
 #define SP_QUAD_PIPE_H
 
+#include "pipe/p_compiler.h"
+
 
 struct softpipe_context;
 struct quad_header;
@@ -66,6 +68,9 @@ struct quad_stage *sp_quad_coverage_stage( struct softpipe_context *softpipe );
 struct quad_stage *sp_quad_blend_stage( struct softpipe_context *softpipe );
 struct quad_stage *sp_quad_colormask_stage( struct softpipe_context *softpipe );
 struct quad_stage *sp_quad_output_stage( struct softpipe_context *softpipe );
+struct quad_stage *sp_quad_fused_stage( struct softpipe_context *softpipe );
+
+boolean sp_quad_fused_choose(struct quad_stage *qs);
 
 void sp_build_quad_pipeline(struct softpipe_context *sp);
 
@@ -37,6 +37,7 @@
 #include "sp_quad_pipe.h"
 #include "sp_setup.h"
 #include "sp_state.h"
+#include "sp_tile_cache.h"
 #include "draw/draw_context.h"
 #include "draw/draw_vertex.h"
 #include "pipe/p_shader_tokens.h"
@@ -60,12 +61,19 @@ struct edge {
 };
 
 
+/**
+ * Width and height in pixels of the blocks that triangles are rasterized
+ * in.  Span coverage masks are computed BLOCK_SIZE pixels at a time; this
+ * can't be arbitrarily increased since we depend on some 32-bit bitmasks
+ * (two bits per quad).  A block must not straddle a cached tile.
+ */
+#define BLOCK_SIZE 16
+
+
 /**
  * Max number of quads (2x2 pixel blocks) to process per batch.
- * This can't be arbitrarily increased since we depend on some 32-bit
- * bitmasks (two bits per quad).
  */
-#define MAX_QUADS 16
+#define MAX_QUADS ((BLOCK_SIZE / 2) * (BLOCK_SIZE / 2))
 
 
 /**
@@ -101,10 +109,16 @@ struct setup_context {
    struct tgsi_interp_coef posCoef;  /* For Z, W */
 
    struct {
-      int left[2];   /**< [0] = row0, [1] = row1 */
-      int right[2];
+      int left[BLOCK_SIZE];   /**< one entry per row, starting at y */
+      int right[BLOCK_SIZE];
       int y;
    } span;
+   int span_rows;   /**< 2 for scanline rasterization, else BLOCK_SIZE */
+
+   /** Depth func for the coarse per-block depth test, or
+    * PIPE_FUNC_ALWAYS if it can't be used with the current state.
+    */
+   unsigned hiz_func;
 
 #if DEBUG_FRAGS
    uint numFragsEmitted;  /**< per primitive */
@@ -183,7 +197,37 @@ block(int x)
 static INLINE int
 block_x(int x)
 {
-   return x & ~(16-1);
+   return x & ~(BLOCK_SIZE-1);
+}
+
+
+static void
+reset_spans(struct setup_context *setup)
+{
+   int i;
+
+   setup->span.y = 0;
+   for (i = 0; i < BLOCK_SIZE; i++) {
+      setup->span.right[i] = 0;
+      setup->span.left[i] = 1000000;     /* greater than right[i] */
+   }
+}
+
+
+/**
+ * Coverage bits of the span [left, right) within the BLOCK_SIZE pixels
+ * starting at x.
+ */
+static INLINE unsigned
+span_mask(int left, int right, int x)
+{
+   const int step = BLOCK_SIZE;
+   unsigned skip_left = CLAMP(left - x, 0, step);
+   unsigned skip_right = CLAMP(x + step - right, 0, step);
+   unsigned skipmask_left = (1U << skip_left) - 1U;
+   unsigned skipmask_right = ~0U << (unsigned)(step - skip_right);
+
+   return ~skipmask_left & ~skipmask_right;
 }
 
 
@@ -193,7 +237,7 @@ block_x(int x)
 static void
 flush_spans(struct setup_context *setup)
 {
-   const int step = MAX_QUADS;
+   const int step = BLOCK_SIZE;
    const int xleft0 = setup->span.left[0];
    const int xleft1 = setup->span.left[1];
    const int xright0 = setup->span.right[0];
@@ -244,12 +288,126 @@ flush_spans(struct setup_context *setup)
       }
    }
 
+   reset_spans(setup);
+}
 
-   setup->span.y = 0;
-   setup->span.right[0] = 0;
-   setup->span.right[1] = 0;
-   setup->span.left[0] = 1000000;     /* greater than right[0] */
-   setup->span.left[1] = 1000000;     /* greater than right[1] */
+
+/**
+ * Coarse depth test of the whole block at x, y against the Z range of
+ * the block in the depth tile.
+ * \return TRUE if every fragment of the triangle in the block is
+ * certain to fail the depth test
+ */
+static boolean
+hiz_reject_block(struct setup_context *setup, int x, int y)
+{
+   struct softpipe_tile_cache *zcache = setup->softpipe->zsbuf_cache;
+   struct softpipe_cached_tile *tile = sp_get_cached_tile(zcache, x, y);
+   const float scale = (float) ((1 << 24) - 1);
+   const double a0 = setup->posCoef.a0[2];
+   const double dzdx = setup->posCoef.dadx[2];
+   const double dzdy = setup->posCoef.dady[2];
+   const double x1 = x + BLOCK_SIZE - 1;
+   const double y1 = y + BLOCK_SIZE - 1;
+   double zlo, zhi, eps;
+   uint zmin, zmax;
+
+   if (!sp_tile_cache_get_zbounds(zcache, tile, x, y, &zmin, &zmax))
+      return FALSE;
+
+   /* Plane equation range over the block, widened to cover the rounding
+    * of the float interpolation done by the depth test stages.
+    */
+   eps = (fabs(a0) + fabs(dzdx) * x1 + fabs(dzdy) * y1) * 2e-6;
+   zlo = a0 + MIN2(dzdx * x, dzdx * x1) + MIN2(dzdy * y, dzdy * y1) - eps;
+   zhi = a0 + MAX2(dzdx * x, dzdx * x1) + MAX2(dzdy * y, dzdy * y1) + eps;
+
+   switch (setup->hiz_func) {
+   case PIPE_FUNC_LESS:
+      return zlo >= 0.0 && zlo <= 1.0 &&
+             (unsigned) ((float) zlo * scale) >= zmax;
+   case PIPE_FUNC_LEQUAL:
+      return zlo >= 0.0 && zlo <= 1.0 &&
+             (unsigned) ((float) zlo * scale) > zmax;
+   case PIPE_FUNC_GREATER:
+      return zhi >= 0.0 && zhi <= 1.0 &&
+             (unsigned) ((float) zhi * scale) <= zmin;
+   case PIPE_FUNC_GEQUAL:
+      return zhi >= 0.0 && zhi <= 1.0 &&
+             (unsigned) ((float) zhi * scale) < zmin;
+   default:
+      return FALSE;
+   }
+}
+
+
+/**
+ * Render the spans of a BLOCK_SIZE-high band of rows, one
+ * BLOCK_SIZE x BLOCK_SIZE block at a time.  Each block is passed down
+ * the quad pipeline as a single batch of up to MAX_QUADS quads, row by
+ * row.  The quads and coverage masks are exactly those that
+ * flush_spans() would produce for the same rows.
+ */
+static void
+flush_blocks(struct setup_context *setup)
+{
+   struct quad_stage *pipe = setup->softpipe->quad.first;
+   int minleft = 1000000, maxright = 0;
+   int x, row;
+
+   for (row = 0; row < BLOCK_SIZE; row++) {
+      if (setup->span.left[row] < setup->span.right[row]) {
+         minleft = MIN2(minleft, setup->span.left[row]);
+         maxright = MAX2(maxright, setup->span.right[row]);
+      }
+   }
+
+   for (x = block_x(minleft); x < maxright; x += BLOCK_SIZE) {
+      unsigned q = 0;
+
+      for (row = 0; row < BLOCK_SIZE; row += 2) {
+         unsigned mask0 = span_mask(setup->span.left[row],
+                                    setup->span.right[row], x);
+         unsigned mask1 = span_mask(setup->span.left[row + 1],
+                                    setup->span.right[row + 1], x);
+         unsigned lx = x;
+
+         while (mask0 | mask1) {
+            unsigned quadmask = (mask0 & 3) | ((mask1 & 3) << 2);
+            if (quadmask) {
+               setup->quad[q].input.x0 = lx;
+               setup->quad[q].input.y0 = setup->span.y + row;
+               setup->quad[q].input.facing = setup->facing;
+               setup->quad[q].inout.mask = quadmask;
+               setup->quad_ptrs[q] = &setup->quad[q];
+               q++;
+            }
+            mask0 >>= 2;
+            mask1 >>= 2;
+            lx += 2;
+         }
+      }
+
+      if (q) {
+         if (setup->hiz_func != PIPE_FUNC_ALWAYS &&
+             hiz_reject_block(setup, x, setup->span.y))
+            setup->softpipe->stats.quads_hiz_rejected += q;
+         else
+            pipe->run( pipe, setup->quad_ptrs, q );
+      }
+   }
+
+   reset_spans(setup);
+}
+
+
+static INLINE void
+flush_rows(struct setup_context *setup)
+{
+   if (setup->span_rows == 2)
+      flush_spans(setup);
+   else
+      flush_blocks(setup);
 }
 
 
@@ -747,13 +905,14 @@ subtriangle(struct setup_context *setup,
 
       if (left < right) {
          int _y = sy + y;
-         if (block(_y) != setup->span.y) {
-            flush_spans(setup);
-            setup->span.y = block(_y);
+         int band = _y & ~(setup->span_rows - 1);
+         if (band != setup->span.y) {
+            flush_rows(setup);
+            setup->span.y = band;
          }
 
-         setup->span.left[_y&1] = left;
-         setup->span.right[_y&1] = right;
+         setup->span.left[_y & (setup->span_rows - 1)] = left;
+         setup->span.right[_y & (setup->span_rows - 1)] = right;
       }
    }
 
@@ -827,9 +986,7 @@ sp_setup_tri(struct setup_context *setup,
 
    assert(setup->softpipe->reduced_prim == PIPE_PRIM_TRIANGLES);
 
-   setup->span.y = 0;
-   setup->span.right[0] = 0;
-   setup->span.right[1] = 0;
+   reset_spans(setup);
    /*   setup->span.z_mode = tri_z_mode( setup->ctx ); */
 
    /*   init_constant_attribs( setup ); */
@@ -847,7 +1004,7 @@ sp_setup_tri(struct setup_context *setup,
       subtriangle( setup, &setup->etop, &setup->emaj, setup->etop.lines );
    }
 
-   flush_spans( setup );
+   flush_rows( setup );
 
 #if DEBUG_FRAGS
    printf("Tri: %u frags emitted, %u written\n",
@@ -1404,6 +1561,27 @@ sp_setup_prepare(struct setup_context *setup)
 
    sp->quad.first->begin( sp->quad.first );
 
+   /* The coarse depth test needs the Z plane of the triangle and the same
+    * integer Z conversion as the depth test stages, so only 24-bit Z
+    * without stencil updates qualifies.
+    */
+   setup->hiz_func = PIPE_FUNC_ALWAYS;
+   if (sp->depth_stencil->depth.enabled &&
+       sp->framebuffer.zsbuf &&
+       !sp->depth_stencil->stencil[0].enabled &&
+       !sp->fs->info.writes_z) {
+      switch (sp->framebuffer.zsbuf->format) {
+      case PIPE_FORMAT_Z24X8_UNORM:
+      case PIPE_FORMAT_Z24_UNORM_S8_USCALED:
+      case PIPE_FORMAT_X8Z24_UNORM:
+      case PIPE_FORMAT_S8_USCALED_Z24_UNORM:
+         setup->hiz_func = sp->depth_stencil->depth.func;
+         break;
+      default:
+         break;
+      }
+   }
+
    if (sp->reduced_api_prim == PIPE_PRIM_TRIANGLES &&
        sp->rasterizer->fill_front == PIPE_POLYGON_MODE_FILL &&
        sp->rasterizer->fill_back == PIPE_POLYGON_MODE_FILL) {
@@ -1434,14 +1612,14 @@ sp_setup_create_context(struct softpipe_context *softpipe)
    unsigned i;
 
    setup->softpipe = softpipe;
+   setup->span_rows = softpipe->scanline_rast ? 2 : BLOCK_SIZE;
 
    for (i = 0; i < MAX_QUADS; i++) {
       setup->quad[i].coef = setup->coef;
       setup->quad[i].posCoef = &setup->posCoef;
    }
 
-   setup->span.left[0] = 1000000;     /* greater than right[0] */
-   setup->span.left[1] = 1000000;     /* greater than right[1] */
+   reset_spans(setup);
 
    return setup;
 }
@@ -34,8 +34,11 @@
 
 #include "util/u_inlines.h"
 #include "util/u_format.h"
+#include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_tile.h"
+#include "sp_screen.h"
+#include "sp_texture.h"
 #include "sp_tile_cache.h"
 
 static struct softpipe_cached_tile *
@@ -340,6 +343,9 @@ sp_tile_cache_flush_clear(struct softpipe_tile_cache *tc)
    /* reset all clear flags to zero */
    memset(tc->clear_flags, 0, sizeof(tc->clear_flags));
 
+   if (numCleared)
+      tc->written = TRUE;
+
 #if 0
    debug_printf("num cleared: %u\n", numCleared);
 #endif
@@ -364,6 +370,7 @@ sp_flush_tile(struct softpipe_tile_cache* tc, unsigned pos)
                             (float *) tc->entries[pos]->data.color);
       }
       tc->tile_addrs[pos].bits.invalid = 1;  /* mark as empty */
+      tc->written = TRUE;
    }
 }
 
@@ -395,6 +402,17 @@ sp_flush_tile_cache(struct softpipe_tile_cache *tc)
 
 
       tc->last_tile_addr.bits.invalid = 1;
+
+      if (tc->written) {
+         /* Expire the texture tile caches of all contexts sampling from the
+          * resource, e.g. through an EGLImage sibling.  Any tile put to the
+          * surface counts, including cleared ones and tiles evicted before
+          * this flush.
+          */
+         softpipe_resource(pt->resource)->timestamp++;
+         softpipe_screen(tc->pipe->screen)->timestamp++;
+         tc->written = FALSE;
+      }
    }
 
 #if 0
@@ -435,6 +453,102 @@ sp_alloc_tile(struct softpipe_tile_cache *tc)
    return tile;
 }
 
+/**
+ * Extract the Z value from a packed depth/stencil value.
+ * \return FALSE if the format has no depth
+ */
+static boolean
+unpack_z(enum pipe_format format, uint value, uint *z)
+{
+   switch (format) {
+   case PIPE_FORMAT_Z16_UNORM:
+      *z = value & 0xffff;
+      return TRUE;
+   case PIPE_FORMAT_Z32_UNORM:
+      *z = value;
+      return TRUE;
+   case PIPE_FORMAT_Z24X8_UNORM:
+   case PIPE_FORMAT_Z24_UNORM_S8_USCALED:
+      *z = value & 0xffffff;
+      return TRUE;
+   case PIPE_FORMAT_X8Z24_UNORM:
+   case PIPE_FORMAT_S8_USCALED_Z24_UNORM:
+      *z = value >> 8;
+      return TRUE;
+   default:
+      return FALSE;
+   }
+}
+
+
+/**
+ * Set the Z range of all blocks of a tile which was just cleared.
+ */
+static void
+clear_tile_zbounds(struct softpipe_cached_tile *tile,
+                   enum pipe_format format,
+                   uint clear_value)
+{
+   uint z, i;
+
+   if (!unpack_z(format, clear_value, &z)) {
+      tile->zbounds_dirty = ~0;
+      return;
+   }
+
+   for (i = 0; i < TILE_ZBLOCKS * TILE_ZBLOCKS; i++) {
+      tile->zmin[i] = z;
+      tile->zmax[i] = z;
+   }
+   tile->zbounds_dirty = 0;
+}
+
+
+/**
+ * Return the range of the Z values in the TILE_ZBLOCK_SIZE block of a
+ * depth tile containing pixel x, y.  The range is recomputed from the
+ * tile data if the block was modified since the last call.
+ * \return FALSE if the surface has no depth values
+ */
+boolean
+sp_tile_cache_get_zbounds(struct softpipe_tile_cache *tc,
+                          struct softpipe_cached_tile *tile,
+                          int x, int y, uint *zmin, uint *zmax)
+{
+   const enum pipe_format format = tc->transfer->resource->format;
+   const unsigned block = tile_zblock(x, y);
+
+   if (tile->zbounds_dirty & (1 << block)) {
+      const uint bx = (x % TILE_SIZE) & ~(TILE_ZBLOCK_SIZE - 1);
+      const uint by = (y % TILE_SIZE) & ~(TILE_ZBLOCK_SIZE - 1);
+      uint lo = ~0, hi = 0, z;
+      uint i, j;
+
+      if (!unpack_z(format, 0, &z))
+         return FALSE;
+
+      for (i = by; i < by + TILE_ZBLOCK_SIZE; i++) {
+         for (j = bx; j < bx + TILE_ZBLOCK_SIZE; j++) {
+            if (format == PIPE_FORMAT_Z16_UNORM)
+               z = tile->data.depth16[i][j];
+            else
+               unpack_z(format, tile->data.depth32[i][j], &z);
+            lo = MIN2(lo, z);
+            hi = MAX2(hi, z);
+         }
+      }
+
+      tile->zmin[block] = lo;
+      tile->zmax[block] = hi;
+      tile->zbounds_dirty &= ~(1 << block);
+   }
+
+   *zmin = tile->zmin[block];
+   *zmax = tile->zmax[block];
+   return TRUE;
+}
+
+
 /**
  * Get a tile from the cache.
  * \param x, y  position of tile, in pixels
@@ -474,6 +588,7 @@ sp_find_cached_tile(struct softpipe_tile_cache *tc,
                                TILE_SIZE, TILE_SIZE,
                                (float *) tile->data.color);
          }
+         tc->written = TRUE;
       }
 
       tc->tile_addrs[pos] = addr;
@@ -482,6 +597,7 @@ sp_find_cached_tile(struct softpipe_tile_cache *tc,
          /* don't get tile from framebuffer, just clear it */
          if (tc->depth_stencil) {
             clear_tile(tile, pt->resource->format, tc->clear_val);
+            clear_tile_zbounds(tile, pt->resource->format, tc->clear_val);
          }
          else {
             clear_tile_rgba(tile, pt->resource->format, tc->clear_color);
@@ -496,6 +612,7 @@ sp_find_cached_tile(struct softpipe_tile_cache *tc,
                               tc->tile_addrs[pos].bits.y * TILE_SIZE,
                               TILE_SIZE, TILE_SIZE,
                               tile->data.depth32, 0/*STRIDE*/);
+            tile->zbounds_dirty = ~0;
          }
          else {
             pipe_get_tile_rgba(tc->pipe, pt,
@@ -46,6 +46,14 @@ struct softpipe_tile_cache;
 #define TILE_ADDR_BITS (SP_MAX_TEXTURE_2D_LEVELS - 1 - TILE_SIZE_LOG2)
 
 
+/**
+ * Depth tiles keep the Z range of each TILE_ZBLOCK_SIZE x TILE_ZBLOCK_SIZE
+ * block of pixels, for coarse (hierarchical) depth testing in setup.
+ */
+#define TILE_ZBLOCK_SIZE 16
+#define TILE_ZBLOCKS (TILE_SIZE / TILE_ZBLOCK_SIZE)
+
+
 /**
  * Surface tile address as a union for fast compares.
  */
@@ -70,6 +78,12 @@ struct softpipe_cached_tile
       ubyte stencil8[TILE_SIZE][TILE_SIZE];
       ubyte any[1];
    } data;
+
+   /** Z range of each block, in Z buffer units */
+   uint zmin[TILE_ZBLOCKS * TILE_ZBLOCKS];
+   uint zmax[TILE_ZBLOCKS * TILE_ZBLOCKS];
+   /** Bitmask of the blocks whose zmin/zmax need to be recomputed */
+   unsigned zbounds_dirty;
 };
 
 #define NUM_ENTRIES 50
@@ -88,6 +102,8 @@ struct softpipe_tile_cache
    float clear_color[4];  /**< for color bufs */
    uint clear_val;        /**< for z+stencil */
    boolean depth_stencil; /**< Is the surface a depth/stencil format? */
+   boolean written;       /**< tiles were put to the surface since the
+                           *   last sp_flush_tile_cache() */
 
    struct softpipe_cached_tile *tile;  /**< scratch tile for clears */
 
@@ -126,6 +142,11 @@ extern struct softpipe_cached_tile *
 sp_find_cached_tile(struct softpipe_tile_cache *tc, 
                     union tile_address addr );
 
+extern boolean
+sp_tile_cache_get_zbounds(struct softpipe_tile_cache *tc,
+                          struct softpipe_cached_tile *tile,
+                          int x, int y, uint *zmin, uint *zmax);
+
 
 static INLINE union tile_address
 tile_address( unsigned x,
@@ -155,6 +176,23 @@ sp_get_cached_tile(struct softpipe_tile_cache *tc,
 }
 
 
+static INLINE unsigned
+tile_zblock(int x, int y)
+{
+   return ((y % TILE_SIZE) / TILE_ZBLOCK_SIZE) * TILE_ZBLOCKS +
+          (x % TILE_SIZE) / TILE_ZBLOCK_SIZE;
+}
+
+/**
+ * Must be called after changing Z values in the block containing x, y.
+ */
+static INLINE void
+sp_tile_zbounds_dirty(struct softpipe_cached_tile *tile, int x, int y)
+{
+   tile->zbounds_dirty |= 1 << tile_zblock(x, y);
+}
+
+
 
 
 #endif /* SP_TILE_CACHE_H */
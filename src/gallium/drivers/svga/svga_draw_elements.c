@@ -26,6 +26,7 @@
 #include "util/u_inlines.h"
 #include "util/u_upload_mgr.h"
 #include "indices/u_indices.h"
+#include "indices/u_index_cache.h"
 
 #include "svga_cmd.h"
 #include "svga_draw.h"
@@ -212,22 +213,40 @@ svga_hwtnl_draw_range_elements( struct svga_hwtnl *hwtnl,
    else {
       struct pipe_resource *gen_buf = NULL;
 
+      struct u_index_cache *cache = NULL;
+
       /* Need to allocate a new index buffer and run the translate
-       * func to populate it.  Could potentially cache this translated
-       * index buffer with the original to avoid future
-       * re-translations.  Not much point if we're just accelerating
-       * GL though, as index buffers are typically used only once
-       * there.
+       * func to populate it.  The result is cached with the original
+       * buffer, which drops it again when the original is written, so
+       * static index buffers are only translated once.  User buffers
+       * can change behind our back and are always translated.
        */
-      ret = translate_indices( hwtnl,
-                               index_buffer,
-                               start * index_size,
-                               gen_nr,
-                               gen_size,
-                               gen_func,
-                               &gen_buf );
-      if (ret)
-         goto done;
+      if (!svga_buffer_is_user_buffer(index_buffer)) {
+         cache = &svga_buffer(index_buffer)->translated;
+         gen_buf = u_index_cache_lookup( cache,
+                                         gen_func,
+                                         start * index_size,
+                                         gen_nr );
+      }
+
+      if (gen_buf == NULL) {
+         ret = translate_indices( hwtnl,
+                                  index_buffer,
+                                  start * index_size,
+                                  gen_nr,
+                                  gen_size,
+                                  gen_func,
+                                  &gen_buf );
+         if (ret)
+            goto done;
+
+         if (cache)
+            u_index_cache_insert( cache,
+                                  gen_func,
+                                  start * index_size,
+                                  gen_nr,
+                                  gen_buf );
+      }
 
       ret = svga_hwtnl_simple_draw_range_elements( hwtnl,
                                                    gen_buf,
@@ -129,6 +129,7 @@ svga_buffer_map_range( struct pipe_screen *screen,
 
       if (usage & PIPE_TRANSFER_WRITE) {
          assert(sbuf->map.count <= 1);
+         u_index_cache_invalidate(&sbuf->translated);
          sbuf->map.writing = TRUE;
          if (usage & PIPE_TRANSFER_FLUSH_EXPLICIT)
             sbuf->map.flush_explicit = TRUE;
@@ -208,6 +209,8 @@ svga_buffer_destroy( struct pipe_screen *screen,
    if(sbuf->uploaded.buffer)
       pipe_resource_reference(&sbuf->uploaded.buffer, NULL);
 
+   u_index_cache_invalidate(&sbuf->translated);
+
    if(sbuf->hwbuf)
       svga_buffer_destroy_hw_storage(ss, sbuf);
    
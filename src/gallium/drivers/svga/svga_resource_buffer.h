@@ -30,6 +30,7 @@
 #include "pipe/p_compiler.h"
 #include "pipe/p_state.h"
 #include "util/u_transfer.h"
+#include "indices/u_index_cache.h"
 
 #include "util/u_double_list.h"
 
@@ -177,6 +178,13 @@ struct svga_buffer
       struct svga_context *svga;
    } dma;
 
+   /**
+    * Translated copies of this buffer's indices, for primitives the
+    * hardware can't draw directly.  Dropped whenever the buffer is mapped
+    * for writing.  Never used for user buffers.
+    */
+   struct u_index_cache translated;
+
    /**
     * Linked list head, used to gather all buffers with pending dma uploads on
     * a context. It is only valid if the dma.pending is set above.
@@ -0,0 +1,23 @@
+#ifndef OSMESA_SW_WINSYS_H
+#define OSMESA_SW_WINSYS_H
+
+#include "state_tracker/sw_winsys.h"
+
+
+/* Software winsys whose display targets can live in application memory,
+ * for the OSMesa state tracker.
+ */
+struct sw_winsys *
+osmesa_create_sw_winsys( void );
+
+/* The next display target created uses the given memory, with rows
+ * 'stride' bytes apart, instead of allocating its own.  If the memory
+ * isn't suitably aligned for the driver a private image is rendered to
+ * and copied into it on every displaytarget_display().
+ */
+void
+osmesa_sw_winsys_set_user_memory( struct sw_winsys *winsys,
+                                  void *data, unsigned stride );
+
+
+#endif
@@ -255,6 +255,13 @@ struct st_framebuffer_iface
     */
    const struct st_visual *visual;
 
+   /**
+    * Whether the first row of the attachments is the bottom row of the
+    * framebuffer, as with client memory in glDrawPixels order.  Window
+    * system buffers normally start with the top row.
+    */
+   boolean y_0_bottom;
+
    /**
     * Flush the front buffer.
     *
@@ -302,6 +309,11 @@ struct st_context_iface
    void *st_context_private;
    void *st_manager_private;
 
+   /**
+    * The pipe context the rendering context draws with.
+    */
+   struct pipe_context *pipe;
+
    /**
     * Destroy the context.
     */
@@ -356,6 +368,9 @@ struct st_context_iface
    /**
     * Look up and return the info of a resource for EGLImage.
     *
+    * The context must be current in the calling thread, as the resource
+    * may be validated and the context flushed.
+    *
     * This function is optional.
     */
    boolean (*get_resource_for_egl_image)(struct st_context_iface *stctxi,
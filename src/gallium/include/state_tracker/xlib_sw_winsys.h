@@ -17,6 +17,12 @@ struct xlib_drawable {
    Visual *visual;
    int depth;
    Drawable drawable;
+
+   /* Damaged region to push to the window on the next flush, in window
+    * coordinates.  When num_damage is zero the whole image is presented.
+    */
+   const XRectangle *damage;
+   int num_damage;
 };
 
 
@@ -549,6 +549,15 @@ egl_g3d_initialize(_EGLDriver *drv, _EGLDisplay *dpy,
    dpy->Extensions.KHR_image_base = EGL_TRUE;
    if (gdpy->native->get_param(gdpy->native, NATIVE_PARAM_USE_NATIVE_BUFFER))
       dpy->Extensions.KHR_image_pixmap = EGL_TRUE;
+   if (dpy->ClientAPIsMask &
+       (EGL_OPENGL_BIT | EGL_OPENGL_ES_BIT | EGL_OPENGL_ES2_BIT)) {
+      dpy->Extensions.KHR_gl_texture_2D_image = EGL_TRUE;
+      dpy->Extensions.KHR_gl_texture_cubemap_image = EGL_TRUE;
+      dpy->Extensions.KHR_gl_texture_3D_image = EGL_TRUE;
+      dpy->Extensions.KHR_gl_renderbuffer_image = EGL_TRUE;
+   }
+   if (dpy->ClientAPIsMask & EGL_OPENVG_BIT)
+      dpy->Extensions.KHR_vg_parent_image = EGL_TRUE;
 
    dpy->Extensions.KHR_reusable_sync = EGL_TRUE;
    dpy->Extensions.KHR_fence_sync = EGL_TRUE;
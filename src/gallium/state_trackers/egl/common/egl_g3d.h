@@ -45,6 +45,9 @@
 #include "egl_g3d_st.h"
 #include "egl_g3d_loader.h"
 
+/* upper limit of EGL_MAX_FRAMES_IN_FLIGHT */
+#define EGL_G3D_MAX_FRAMES_IN_FLIGHT 8
+
 struct egl_g3d_driver {
    _EGLDriver base;
    const struct egl_g3d_loader *loader;
@@ -81,6 +84,10 @@ struct egl_g3d_surface {
    EGLClientBuffer client_buffer;
 
    unsigned int sequence_number;
+
+   /* fences of the frames still in flight, oldest at frame_fence_index */
+   struct pipe_fence_handle *frame_fences[EGL_G3D_MAX_FRAMES_IN_FLIGHT];
+   unsigned int frame_fence_index;
 };
 
 struct egl_g3d_config {
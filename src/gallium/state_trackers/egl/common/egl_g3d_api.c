@@ -28,6 +28,7 @@
 #include "egllog.h"
 
 #include "pipe/p_screen.h"
+#include "util/u_debug.h"
 #include "util/u_memory.h"
 #include "util/u_inlines.h"
 #include "util/u_box.h"
@@ -40,6 +41,8 @@
 #include "egl_g3d_loader.h"
 #include "native.h"
 
+DEBUG_GET_ONCE_NUM_OPTION(max_frames_in_flight, "EGL_MAX_FRAMES_IN_FLIGHT", 2)
+
 /**
  * Return the state tracker for the given context.
  */
@@ -488,11 +491,19 @@ static void
 destroy_surface(_EGLDisplay *dpy, _EGLSurface *surf)
 {
    struct egl_g3d_surface *gsurf = egl_g3d_surface(surf);
+   int i;
 
    /* FIXME a surface might live longer than its display */
    if (!dpy->Initialized)
       _eglLog(_EGL_FATAL, "destroy a surface with an unitialized display");
 
+   for (i = 0; i < EGL_G3D_MAX_FRAMES_IN_FLIGHT; i++) {
+      if (gsurf->frame_fences[i]) {
+         struct pipe_screen *screen = egl_g3d_display(dpy)->native->screen;
+         screen->fence_reference(screen, &gsurf->frame_fences[i], NULL);
+      }
+   }
+
    pipe_resource_reference(&gsurf->render_texture, NULL);
    egl_g3d_destroy_st_framebuffer(gsurf->stfbi);
    if (gsurf->native)
@@ -584,6 +595,38 @@ egl_g3d_make_current(_EGLDriver *drv, _EGLDisplay *dpy,
    return ok;
 }
 
+/**
+ * Keep at most EGL_MAX_FRAMES_IN_FLIGHT frames of the surface queued in
+ * the driver.  The fence of the frame just flushed replaces the oldest
+ * one, which is waited for first.  This bounds the latency and memory
+ * use of drivers that queue work, without the full stall of glFinish.
+ */
+static void
+egl_g3d_throttle_frames(_EGLDisplay *dpy, struct egl_g3d_surface *gsurf,
+                        struct pipe_fence_handle *fence)
+{
+   struct egl_g3d_display *gdpy = egl_g3d_display(dpy);
+   struct pipe_screen *screen = gdpy->native->screen;
+   long max_frames = debug_get_option_max_frames_in_flight();
+   struct pipe_fence_handle **oldest;
+
+   if (max_frames > EGL_G3D_MAX_FRAMES_IN_FLIGHT)
+      max_frames = EGL_G3D_MAX_FRAMES_IN_FLIGHT;
+
+   oldest = &gsurf->frame_fences[gsurf->frame_fence_index];
+   if (*oldest) {
+      /* unlock display lock while waiting, as for fence syncs */
+      _eglUnlockMutex(&dpy->Mutex);
+      screen->fence_finish(screen, *oldest, 0x0);
+      _eglLockMutex(&dpy->Mutex);
+
+      screen->fence_reference(screen, oldest, NULL);
+   }
+
+   *oldest = fence;
+   gsurf->frame_fence_index = (gsurf->frame_fence_index + 1) % max_frames;
+}
+
 static EGLBoolean
 egl_g3d_swap_buffers(_EGLDriver *drv, _EGLDisplay *dpy, _EGLSurface *surf)
 {
@@ -605,8 +648,17 @@ egl_g3d_swap_buffers(_EGLDriver *drv, _EGLDisplay *dpy, _EGLSurface *surf)
 
    /* flush if the surface is current */
    if (gctx) {
-      gctx->stctxi->flush(gctx->stctxi,
-            PIPE_FLUSH_RENDER_CACHE | PIPE_FLUSH_FRAME, NULL);
+      if (debug_get_option_max_frames_in_flight() > 0) {
+         struct pipe_fence_handle *fence = NULL;
+
+         gctx->stctxi->flush(gctx->stctxi,
+               PIPE_FLUSH_RENDER_CACHE | PIPE_FLUSH_FRAME, &fence);
+         egl_g3d_throttle_frames(dpy, gsurf, fence);
+      }
+      else {
+         gctx->stctxi->flush(gctx->stctxi,
+               PIPE_FLUSH_RENDER_CACHE | PIPE_FLUSH_FRAME, NULL);
+      }
    }
 
    return gsurf->native->present(gsurf->native,
@@ -935,6 +987,7 @@ egl_g3d_init_driver_api(_EGLDriver *drv)
    drv->API.DestroySyncKHR = egl_g3d_destroy_sync;
    drv->API.ClientWaitSyncKHR = egl_g3d_client_wait_sync;
    drv->API.SignalSyncKHR = egl_g3d_signal_sync;
+   drv->API.GetSyncAttribKHR = egl_g3d_get_sync_attrib;
 #endif
 
 #ifdef EGL_MESA_screen_surface
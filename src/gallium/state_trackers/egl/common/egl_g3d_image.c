@@ -71,6 +71,94 @@ egl_g3d_reference_native_pixmap(_EGLDisplay *dpy, EGLNativePixmapType pix)
    return textures[natt];
 }
 
+/**
+ * Reference and return the resource of a GL texture or renderbuffer, or of
+ * a VGImage.  The image aliases the resource; the state tracker flushes the
+ * context so that its rendering to the resource is seen by the siblings.
+ */
+static struct pipe_resource *
+egl_g3d_reference_client_resource(_EGLDisplay *dpy, _EGLContext *ctx,
+                                  EGLenum target, EGLClientBuffer buffer,
+                                  const EGLint *attribs,
+                                  unsigned *level, unsigned *layer)
+{
+   struct egl_g3d_context *gctx = egl_g3d_context(ctx);
+   struct st_context_resource stres;
+   _EGLImageAttribs attrs;
+   EGLBoolean is_vg;
+
+   if (!gctx) {
+      _eglError(EGL_BAD_CONTEXT, "eglCreateEGLImageKHR");
+      return NULL;
+   }
+
+   is_vg = (target == EGL_VG_PARENT_IMAGE_KHR);
+   if (is_vg != (ctx->ClientAPI == EGL_OPENVG_API) ||
+       !gctx->stctxi->get_resource_for_egl_image) {
+      _eglError(EGL_BAD_MATCH, "eglCreateEGLImageKHR");
+      return NULL;
+   }
+
+   /* the source context's pipe is not thread-safe; only use it from the
+    * thread it is current in
+    */
+   if (_eglGetAPIContext(ctx->ClientAPI) != ctx) {
+      _eglError(EGL_BAD_ACCESS, "eglCreateEGLImageKHR");
+      return NULL;
+   }
+
+   if (_eglParseImageAttribList(&attrs, dpy, attribs) != EGL_SUCCESS)
+      return NULL;
+
+   if (!buffer || attrs.GLTextureLevel < 0 || attrs.GLTextureZOffset < 0) {
+      _eglError(EGL_BAD_PARAMETER, "eglCreateEGLImageKHR");
+      return NULL;
+   }
+
+   memset(&stres, 0, sizeof(stres));
+   stres.resource = (void *) buffer;
+   *level = 0;
+   *layer = 0;
+
+   switch (target) {
+   case EGL_GL_TEXTURE_2D_KHR:
+      stres.type = ST_CONTEXT_RESOURCE_OPENGL_TEXTURE_2D;
+      *level = attrs.GLTextureLevel;
+      break;
+   case EGL_GL_TEXTURE_3D_KHR:
+      stres.type = ST_CONTEXT_RESOURCE_OPENGL_TEXTURE_3D;
+      *level = attrs.GLTextureLevel;
+      *layer = attrs.GLTextureZOffset;
+      break;
+   case EGL_GL_TEXTURE_CUBE_MAP_POSITIVE_X_KHR:
+   case EGL_GL_TEXTURE_CUBE_MAP_NEGATIVE_X_KHR:
+   case EGL_GL_TEXTURE_CUBE_MAP_POSITIVE_Y_KHR:
+   case EGL_GL_TEXTURE_CUBE_MAP_NEGATIVE_Y_KHR:
+   case EGL_GL_TEXTURE_CUBE_MAP_POSITIVE_Z_KHR:
+   case EGL_GL_TEXTURE_CUBE_MAP_NEGATIVE_Z_KHR:
+      *layer = target - EGL_GL_TEXTURE_CUBE_MAP_POSITIVE_X_KHR;
+      stres.type = ST_CONTEXT_RESOURCE_OPENGL_TEXTURE_CUBE_MAP_POSITIVE_X +
+         *layer;
+      *level = attrs.GLTextureLevel;
+      break;
+   case EGL_GL_RENDERBUFFER_KHR:
+      stres.type = ST_CONTEXT_RESOURCE_OPENGL_RENDERBUFFER;
+      break;
+   case EGL_VG_PARENT_IMAGE_KHR:
+      stres.type = ST_CONTEXT_RESOURCE_OPENVG_PARENT_IMAGE;
+      break;
+   default:
+      return NULL;
+   }
+
+   if (!gctx->stctxi->get_resource_for_egl_image(gctx->stctxi, &stres)) {
+      _eglError(EGL_BAD_PARAMETER, "eglCreateEGLImageKHR");
+      return NULL;
+   }
+
+   return stres.texture;
+}
+
 #ifdef EGL_MESA_drm_image
 
 static struct pipe_resource *
@@ -216,6 +304,19 @@ egl_g3d_create_image(_EGLDriver *drv, _EGLDisplay *dpy, _EGLContext *ctx,
             (EGLint) buffer, &gimg->base, attribs);
       break;
 #endif
+   case EGL_GL_TEXTURE_2D_KHR:
+   case EGL_GL_TEXTURE_3D_KHR:
+   case EGL_GL_TEXTURE_CUBE_MAP_POSITIVE_X_KHR:
+   case EGL_GL_TEXTURE_CUBE_MAP_NEGATIVE_X_KHR:
+   case EGL_GL_TEXTURE_CUBE_MAP_POSITIVE_Y_KHR:
+   case EGL_GL_TEXTURE_CUBE_MAP_NEGATIVE_Y_KHR:
+   case EGL_GL_TEXTURE_CUBE_MAP_POSITIVE_Z_KHR:
+   case EGL_GL_TEXTURE_CUBE_MAP_NEGATIVE_Z_KHR:
+   case EGL_GL_RENDERBUFFER_KHR:
+   case EGL_VG_PARENT_IMAGE_KHR:
+      ptex = egl_g3d_reference_client_resource(dpy, ctx,
+            target, buffer, attribs, &level, &layer);
+      break;
    default:
       ptex = NULL;
       break;
@@ -228,13 +329,13 @@ egl_g3d_create_image(_EGLDriver *drv, _EGLDisplay *dpy, _EGLContext *ctx,
 
    if (level > ptex->last_level) {
       _eglError(EGL_BAD_MATCH, "eglCreateEGLImageKHR");
-      pipe_resource_reference(&gimg->texture, NULL);
+      pipe_resource_reference(&ptex, NULL);
       FREE(gimg);
       return NULL;
    }
    if (layer >= (u_minify(ptex->depth0, level) + ptex->array_size - 1)) {
       _eglError(EGL_BAD_PARAMETER, "eglCreateEGLImageKHR");
-      pipe_resource_reference(&gimg->texture, NULL);
+      pipe_resource_reference(&ptex, NULL);
       FREE(gimg);
       return NULL;
    }
@@ -33,6 +33,7 @@
 #include "util/u_dl.h"
 #include "egldriver.h"
 #include "eglimage.h"
+#include "eglcurrent.h"
 #include "eglmutex.h"
 
 #include "egl_g3d.h"
@@ -122,7 +123,29 @@ egl_g3d_st_framebuffer_flush_front_pbuffer(struct st_framebuffer_iface *stfbi,
 static void
 pbuffer_reference_openvg_image(struct egl_g3d_surface *gsurf)
 {
-   /* TODO */
+   struct egl_g3d_context *gctx =
+      egl_g3d_context(_eglGetAPIContext(EGL_OPENVG_API));
+   struct st_context_resource stres;
+
+   if (!gctx || !gctx->stctxi->get_resource_for_egl_image)
+      return;
+
+   memset(&stres, 0, sizeof(stres));
+   stres.type = ST_CONTEXT_RESOURCE_OPENVG_PARENT_IMAGE;
+   stres.resource = (void *) gsurf->client_buffer;
+
+   if (!gctx->stctxi->get_resource_for_egl_image(gctx->stctxi, &stres))
+      return;
+
+   /* render directly to the VGImage */
+   if (stres.texture->format != gsurf->stvis.color_format) {
+      pipe_resource_reference(&stres.texture, NULL);
+      return;
+   }
+
+   gsurf->base.Width = stres.texture->width0;
+   gsurf->base.Height = stres.texture->height0;
+   gsurf->render_texture = stres.texture;
 }
 
 static void
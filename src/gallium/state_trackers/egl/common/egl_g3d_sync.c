@@ -28,7 +28,9 @@
 
 #include "util/u_memory.h"
 #include "util/u_atomic.h"
+#include "util/u_math.h"
 #include "os/os_thread.h"
+#include "os/os_time.h"
 #include "eglsync.h"
 #include "eglcurrent.h"
 
@@ -91,6 +93,48 @@ egl_g3d_insert_fence_sync(struct egl_g3d_sync *gsync)
    return EGL_SUCCESS;
 }
 
+/**
+ * Wait for a pipe fence for at most timeout nanoseconds.
+ */
+static EGLint
+egl_g3d_wait_fence(struct pipe_screen *screen,
+                   struct pipe_fence_handle *fence, EGLTimeKHR timeout)
+{
+   int64_t end;
+
+   /* there is no timed fence_finish; poll unless the wait is unbounded */
+   if (timeout == EGL_FOREVER_KHR || timeout / 1000 > (EGLTimeKHR) 1 << 52) {
+      screen->fence_finish(screen, fence, 0x0);
+      return EGL_CONDITION_SATISFIED_KHR;
+   }
+
+   end = os_time_get() + (int64_t) (timeout / 1000);
+   while (screen->fence_signalled(screen, fence, 0x0) != 0) {
+      int64_t now = os_time_get();
+
+      if (now >= end)
+         return EGL_TIMEOUT_EXPIRED_KHR;
+      os_time_sleep(MIN2(end - now, 100));
+   }
+
+   return EGL_CONDITION_SATISFIED_KHR;
+}
+
+/**
+ * Mark the fence sync signaled and wake up the other waiters.
+ */
+static void
+egl_g3d_signal_fence_sync(struct egl_g3d_sync *gsync,
+                          struct pipe_screen *screen)
+{
+   if (gsync->base.SyncStatus != EGL_SIGNALED_KHR) {
+      gsync->base.SyncStatus = EGL_SIGNALED_KHR;
+      if (gsync->fence)
+         screen->fence_reference(screen, &gsync->fence, NULL);
+      egl_g3d_signal_sync_condvar(gsync);
+   }
+}
+
 /**
  * Wait for the fence sync to be signaled.
  */
@@ -103,20 +147,19 @@ egl_g3d_wait_fence_sync(struct egl_g3d_sync *gsync, EGLTimeKHR timeout)
       _EGLDisplay *dpy = gsync->base.Resource.Display;
       struct egl_g3d_display *gdpy = egl_g3d_display(dpy);
       struct pipe_screen *screen = gdpy->native->screen;
-      struct pipe_fence_handle *fence = gsync->fence;
+      struct pipe_fence_handle *fence = NULL;
 
-      gsync->fence = NULL;
+      /* waiters may time out, so each holds its own reference */
+      screen->fence_reference(screen, &fence, gsync->fence);
 
       _eglUnlockMutex(&dpy->Mutex);
-      /* no timed finish? */
-      screen->fence_finish(screen, fence, 0x0);
-      ret = EGL_CONDITION_SATISFIED_KHR;
+      ret = egl_g3d_wait_fence(screen, fence, timeout);
       _eglLockMutex(&dpy->Mutex);
 
-      gsync->base.SyncStatus = EGL_SIGNALED_KHR;
+      if (ret == EGL_CONDITION_SATISFIED_KHR)
+         egl_g3d_signal_fence_sync(gsync, screen);
 
       screen->fence_reference(screen, &fence, NULL);
-      egl_g3d_signal_sync_condvar(gsync);
    }
    else {
       ret = egl_g3d_wait_sync_condvar(gsync, timeout);
@@ -237,20 +280,17 @@ egl_g3d_client_wait_sync(_EGLDriver *drv, _EGLDisplay *dpy, _EGLSync *sync,
             gctx->stctxi->flush(gctx->stctxi, PIPE_FLUSH_RENDER_CACHE , NULL);
       }
 
-      if (timeout) {
+      if (gsync->base.Type == EGL_SYNC_FENCE_KHR && gsync->fence) {
          /* reference the sync object in case it is destroyed while waiting */
          egl_g3d_ref_sync(gsync);
-
-         switch (gsync->base.Type) {
-         case EGL_SYNC_REUSABLE_KHR:
-            ret = egl_g3d_wait_sync_condvar(gsync, timeout);
-            break;
-         case EGL_SYNC_FENCE_KHR:
-            ret = egl_g3d_wait_fence_sync(gsync, timeout);
-         default:
-            break;
-         }
-
+         /* a zero timeout polls the fence */
+         ret = egl_g3d_wait_fence_sync(gsync, timeout);
+         egl_g3d_unref_sync(gsync);
+      }
+      else if (timeout) {
+         /* reference the sync object in case it is destroyed while waiting */
+         egl_g3d_ref_sync(gsync);
+         ret = egl_g3d_wait_sync_condvar(gsync, timeout);
          egl_g3d_unref_sync(gsync);
       }
       else {
@@ -280,4 +320,21 @@ egl_g3d_signal_sync(_EGLDriver *drv, _EGLDisplay *dpy, _EGLSync *sync,
    return EGL_TRUE;
 }
 
+EGLBoolean
+egl_g3d_get_sync_attrib(_EGLDriver *drv, _EGLDisplay *dpy, _EGLSync *sync,
+                        EGLint attribute, EGLint *value)
+{
+   struct egl_g3d_sync *gsync = egl_g3d_sync(sync);
+
+   /* update the status of fence syncs without waiting */
+   if (attribute == EGL_SYNC_STATUS_KHR && gsync->fence) {
+      struct pipe_screen *screen = egl_g3d_display(dpy)->native->screen;
+
+      if (screen->fence_signalled(screen, gsync->fence, 0x0) == 0)
+         egl_g3d_signal_fence_sync(gsync, screen);
+   }
+
+   return _eglGetSyncAttribKHR(drv, dpy, sync, attribute, value);
+}
+
 #endif /* EGL_KHR_reusable_sync */
@@ -48,6 +48,10 @@ EGLBoolean
 egl_g3d_signal_sync(_EGLDriver *drv, _EGLDisplay *dpy, _EGLSync *sync,
                     EGLenum mode);
 
+EGLBoolean
+egl_g3d_get_sync_attrib(_EGLDriver *drv, _EGLDisplay *dpy, _EGLSync *sync,
+                        EGLint attribute, EGLint *value);
+
 #endif /* EGL_KHR_reusable_sync */
 
 #endif /* _EGL_G3D_SYNC_H_ */
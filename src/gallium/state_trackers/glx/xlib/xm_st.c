@@ -357,6 +357,21 @@ xmesa_copy_st_framebuffer(struct st_framebuffer_iface *stfbi,
                           int x, int y, int w, int h)
 {
    xmesa_st_framebuffer_copy_textures(stfbi, src, dst, x, y, w, h);
-   if (dst == ST_ATTACHMENT_FRONT_LEFT)
+   if (dst == ST_ATTACHMENT_FRONT_LEFT) {
+      struct xmesa_st_framebuffer *xstfb = xmesa_st_framebuffer(stfbi);
+      XRectangle damage;
+
+      /* only the copied region needs to be pushed to the window */
+      damage.x = x;
+      damage.y = y;
+      damage.width = w;
+      damage.height = h;
+      xstfb->buffer->ws.damage = &damage;
+      xstfb->buffer->ws.num_damage = 1;
+
       xmesa_st_framebuffer_display(stfbi, dst);
+
+      xstfb->buffer->ws.damage = NULL;
+      xstfb->buffer->ws.num_damage = 0;
+   }
 }
@@ -0,0 +1,848 @@
+/**************************************************************************
+ * 
+ * Copyright 2011 VMware, Inc.
+ * All Rights Reserved.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE 
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ * 
+ **************************************************************************/
+
+
+/**
+ * @file
+ * Off-screen Mesa on top of a gallium software rasterizer.
+ *
+ * The color buffer is a display target created from the memory passed to
+ * OSMesaMakeCurrent(), so the rasterizer writes the image straight into
+ * the application's buffer.  Nothing is copied on MakeCurrent, glFlush or
+ * glFinish, unless the memory is not aligned well enough for the driver
+ * (see osmesa_sw_winsys_set_user_memory()).
+ *
+ * With OSMESA_Y_UP the first row in memory is the bottom row of the image,
+ * which the framebuffer reports through st_framebuffer_iface::y_0_bottom.
+ */
+
+
+#include <string.h>
+
+#include "GL/osmesa.h"
+#include "glapi/glapi.h"
+#include "main/context.h"
+#include "main/blend.h"
+
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "os/os_thread.h"
+#include "util/u_format.h"
+#include "util/u_inlines.h"
+#include "state_tracker/st_api.h"
+#include "state_tracker/osmesa_sw_winsys.h"
+
+#include "osmesa_public.h"
+
+
+/**
+ * The drawable of an OSMesa context.  A new one is created whenever the
+ * color format or the row order changes, as the state tracker only looks
+ * at those when it first sees a framebuffer.
+ */
+struct osmesa_buffer
+{
+   struct st_framebuffer_iface stfbi;
+   struct st_visual visual;
+
+   void *map;           /**< application color memory */
+   unsigned stride;     /**< in bytes */
+   unsigned width, height;
+
+   struct pipe_resource *textures[ST_ATTACHMENT_COUNT];
+};
+
+
+struct osmesa_context
+{
+   struct st_context_iface *stctx;
+   struct st_visual visual;     /**< visual of the context */
+   struct osmesa_buffer *buffer;
+
+   GLenum format;               /**< OSMESA_x */
+   GLenum type;                 /**< from OSMesaMakeCurrent */
+   void *map;
+   GLsizei width, height;
+   GLint user_row_length;
+   GLboolean y_up;
+
+   /** depth buffer mapping returned by OSMesaGetDepthBuffer() */
+   struct pipe_transfer *zs_transfer;
+};
+
+
+static struct osmesa_driver driver;
+
+static struct st_api *stapi;
+static struct st_manager *smapi;
+static struct sw_winsys *winsys;
+
+/** Serializes osmesa_sw_winsys_set_user_memory() and resource_create() */
+pipe_static_mutex(osmesa_mutex);
+
+
+void osmesa_set_driver( const struct osmesa_driver *templ )
+{
+   driver = *templ;
+}
+
+
+static int
+osmesa_get_param(struct st_manager *smapi,
+                 enum st_manager_param param)
+{
+   return 0;
+}
+
+
+/**
+ * Create the screen and the state tracker on first use.
+ */
+static boolean
+osmesa_init(void)
+{
+   boolean ret;
+
+   pipe_mutex_lock(osmesa_mutex);
+
+   if (!smapi && driver.create_pipe_screen) {
+      struct pipe_screen *screen = NULL;
+
+      winsys = osmesa_create_sw_winsys();
+      if (winsys)
+         screen = driver.create_pipe_screen(winsys);
+
+      if (screen) {
+         smapi = CALLOC_STRUCT(st_manager);
+         if (smapi) {
+            smapi->screen = screen;
+            smapi->get_param = osmesa_get_param;
+            stapi = driver.create_st_api();
+         }
+         else {
+            screen->destroy(screen);
+         }
+      }
+      else if (winsys) {
+         winsys->destroy(winsys);
+      }
+   }
+
+   ret = (smapi && stapi);
+
+   pipe_mutex_unlock(osmesa_mutex);
+
+   return ret;
+}
+
+
+/**
+ * Map an OSMesa format and OSMesaMakeCurrent() type to a pipe format.
+ */
+static enum pipe_format
+osmesa_choose_color_format(GLenum format, GLenum type)
+{
+   switch (format) {
+   case OSMESA_RGBA:
+      if (type == GL_UNSIGNED_BYTE)
+         return PIPE_FORMAT_R8G8B8A8_UNORM;
+      if (type == GL_UNSIGNED_SHORT)
+         return PIPE_FORMAT_R16G16B16A16_UNORM;
+      break;
+   case OSMESA_BGRA:
+      if (type == GL_UNSIGNED_BYTE)
+         return PIPE_FORMAT_B8G8R8A8_UNORM;
+      break;
+   case OSMESA_ARGB:
+      if (type == GL_UNSIGNED_BYTE)
+         return PIPE_FORMAT_A8R8G8B8_UNORM;
+      break;
+   case OSMESA_RGB_565:
+      if (type == GL_UNSIGNED_SHORT_5_6_5)
+         return PIPE_FORMAT_B5G6R5_UNORM;
+      break;
+   default:
+      break;
+   }
+
+   return PIPE_FORMAT_NONE;
+}
+
+
+/**
+ * Choose the depth/stencil format with at least the requested bits.
+ */
+static enum pipe_format
+osmesa_choose_depth_stencil_format(int depth, int stencil)
+{
+   struct pipe_screen *screen = smapi->screen;
+   const enum pipe_texture_target target = PIPE_TEXTURE_2D;
+   const unsigned tex_usage = PIPE_BIND_DEPTH_STENCIL;
+   const unsigned geom_flags = (PIPE_TEXTURE_GEOM_NON_SQUARE |
+                                PIPE_TEXTURE_GEOM_NON_POWER_OF_TWO);
+   const unsigned sample_count = 0;
+   enum pipe_format formats[8], fmt;
+   int count, i;
+
+   count = 0;
+
+   if (depth <= 16 && stencil == 0) {
+      formats[count++] = PIPE_FORMAT_Z16_UNORM;
+   }
+   if (depth <= 24 && stencil == 0) {
+      formats[count++] = PIPE_FORMAT_X8Z24_UNORM;
+      formats[count++] = PIPE_FORMAT_Z24X8_UNORM;
+   }
+   if (depth <= 24 && stencil <= 8) {
+      formats[count++] = PIPE_FORMAT_S8_USCALED_Z24_UNORM;
+      formats[count++] = PIPE_FORMAT_Z24_UNORM_S8_USCALED;
+   }
+   if (depth <= 32 && stencil == 0) {
+      formats[count++] = PIPE_FORMAT_Z32_UNORM;
+   }
+
+   fmt = PIPE_FORMAT_NONE;
+   for (i = 0; i < count; i++) {
+      if (screen->is_format_supported(screen, formats[i],
+                                      target, sample_count,
+                                      tex_usage, geom_flags)) {
+         fmt = formats[i];
+         break;
+      }
+   }
+
+   return fmt;
+}
+
+
+static INLINE struct osmesa_buffer *
+osmesa_buffer(struct st_framebuffer_iface *stfbi)
+{
+   return (struct osmesa_buffer *) stfbi;
+}
+
+
+static boolean
+osmesa_st_framebuffer_flush_front(struct st_framebuffer_iface *stfbi,
+                                  enum st_attachment_type statt)
+{
+   struct osmesa_buffer *osbuf = osmesa_buffer(stfbi);
+   struct pipe_screen *screen = smapi->screen;
+
+   /* a no-op unless the winsys had to use a shadow image */
+   if (osbuf->textures[statt])
+      screen->flush_frontbuffer(screen, osbuf->textures[statt], 0, 0, NULL);
+
+   return TRUE;
+}
+
+
+static struct pipe_resource *
+osmesa_buffer_create_texture(struct osmesa_buffer *osbuf,
+                             enum st_attachment_type statt)
+{
+   struct pipe_screen *screen = smapi->screen;
+   struct pipe_resource templ, *tex;
+
+   memset(&templ, 0, sizeof(templ));
+   templ.target = PIPE_TEXTURE_2D;
+   templ.width0 = osbuf->width;
+   templ.height0 = osbuf->height;
+   templ.depth0 = 1;
+   templ.array_size = 1;
+   templ.last_level = 0;
+
+   switch (statt) {
+   case ST_ATTACHMENT_FRONT_LEFT:
+      templ.format = osbuf->visual.color_format;
+      templ.bind = PIPE_BIND_DISPLAY_TARGET |
+                   PIPE_BIND_RENDER_TARGET |
+                   PIPE_BIND_SAMPLER_VIEW;
+
+      pipe_mutex_lock(osmesa_mutex);
+      osmesa_sw_winsys_set_user_memory(winsys, osbuf->map, osbuf->stride);
+      tex = screen->resource_create(screen, &templ);
+      osmesa_sw_winsys_set_user_memory(winsys, NULL, 0);
+      pipe_mutex_unlock(osmesa_mutex);
+      return tex;
+   case ST_ATTACHMENT_DEPTH_STENCIL:
+      templ.format = osbuf->visual.depth_stencil_format;
+      templ.bind = PIPE_BIND_DEPTH_STENCIL;
+      break;
+   default:
+      templ.format = osbuf->visual.color_format;
+      templ.bind = PIPE_BIND_RENDER_TARGET | PIPE_BIND_SAMPLER_VIEW;
+      break;
+   }
+
+   return screen->resource_create(screen, &templ);
+}
+
+
+static boolean
+osmesa_st_framebuffer_validate(struct st_framebuffer_iface *stfbi,
+                               const enum st_attachment_type *statts,
+                               unsigned count,
+                               struct pipe_resource **out)
+{
+   struct osmesa_buffer *osbuf = osmesa_buffer(stfbi);
+   unsigned i;
+
+   for (i = 0; i < count; i++) {
+      enum st_attachment_type statt = statts[i];
+
+      if (!osbuf->textures[statt]) {
+         osbuf->textures[statt] = osmesa_buffer_create_texture(osbuf, statt);
+         if (!osbuf->textures[statt])
+            return FALSE;
+      }
+   }
+
+   for (i = 0; i < count; i++) {
+      out[i] = NULL;
+      pipe_resource_reference(&out[i], osbuf->textures[statts[i]]);
+   }
+
+   return TRUE;
+}
+
+
+static void
+osmesa_buffer_release_textures(struct osmesa_buffer *osbuf, unsigned mask)
+{
+   int i;
+
+   for (i = 0; i < ST_ATTACHMENT_COUNT; i++) {
+      if (mask & (1 << i))
+         pipe_resource_reference(&osbuf->textures[i], NULL);
+   }
+}
+
+
+static struct osmesa_buffer *
+osmesa_create_buffer(struct osmesa_context *osmesa,
+                     enum pipe_format color_format)
+{
+   struct osmesa_buffer *osbuf = CALLOC_STRUCT(osmesa_buffer);
+   if (!osbuf)
+      return NULL;
+
+   osbuf->visual = osmesa->visual;
+   osbuf->visual.color_format = color_format;
+
+   osbuf->stfbi.visual = &osbuf->visual;
+   osbuf->stfbi.y_0_bottom = osmesa->y_up;
+   osbuf->stfbi.flush_front = osmesa_st_framebuffer_flush_front;
+   osbuf->stfbi.validate = osmesa_st_framebuffer_validate;
+   osbuf->stfbi.st_manager_private = (void *) osbuf;
+
+   return osbuf;
+}
+
+
+static void
+osmesa_destroy_buffer(struct osmesa_buffer *osbuf)
+{
+   osmesa_buffer_release_textures(osbuf, ~0);
+   FREE(osbuf);
+}
+
+
+/**
+ * Finish the rendering to the current color memory before it is
+ * replaced, so that the old buffer ends up complete.
+ */
+static void
+osmesa_flush_buffer(struct osmesa_context *osmesa)
+{
+   struct osmesa_buffer *osbuf = osmesa->buffer;
+   struct pipe_screen *screen = smapi->screen;
+   struct pipe_fence_handle *fence = NULL;
+
+   if (!osbuf || !osbuf->textures[ST_ATTACHMENT_FRONT_LEFT])
+      return;
+
+   osmesa->stctx->flush(osmesa->stctx,
+                        PIPE_FLUSH_RENDER_CACHE | PIPE_FLUSH_FRAME, &fence);
+   if (fence) {
+      screen->fence_finish(screen, fence, 0);
+      screen->fence_reference(screen, &fence, NULL);
+   }
+
+   osmesa_st_framebuffer_flush_front(&osbuf->stfbi, ST_ATTACHMENT_FRONT_LEFT);
+}
+
+
+static void
+osmesa_unmap_depth_buffer(struct osmesa_context *osmesa)
+{
+   if (osmesa->zs_transfer) {
+      struct pipe_context *pipe = osmesa->stctx->pipe;
+
+      pipe->transfer_unmap(pipe, osmesa->zs_transfer);
+      pipe->transfer_destroy(pipe, osmesa->zs_transfer);
+      osmesa->zs_transfer = NULL;
+   }
+}
+
+
+/**
+ * Bring the drawable in line with the last OSMesaMakeCurrent() and
+ * OSMesaPixelStore() parameters and bind it.
+ */
+static GLboolean
+osmesa_update_buffer(struct osmesa_context *osmesa)
+{
+   struct osmesa_buffer *osbuf = osmesa->buffer, *old = NULL;
+   enum pipe_format color_format =
+      osmesa_choose_color_format(osmesa->format, osmesa->type);
+   unsigned row_length = osmesa->user_row_length ?
+      osmesa->user_row_length : osmesa->width;
+   unsigned stride = row_length * util_format_get_blocksize(color_format);
+
+   osmesa_unmap_depth_buffer(osmesa);
+
+   if (!osbuf ||
+       osbuf->visual.color_format != color_format ||
+       osbuf->stfbi.y_0_bottom != osmesa->y_up) {
+      osmesa_flush_buffer(osmesa);
+
+      osbuf = osmesa_create_buffer(osmesa, color_format);
+      if (!osbuf)
+         return GL_FALSE;
+
+      old = osmesa->buffer;
+      osmesa->buffer = osbuf;
+   }
+   else if (osbuf->map != osmesa->map ||
+            osbuf->stride != stride ||
+            osbuf->width != osmesa->width ||
+            osbuf->height != osmesa->height) {
+      unsigned mask = ST_ATTACHMENT_FRONT_LEFT_MASK;
+
+      osmesa_flush_buffer(osmesa);
+
+      if (osbuf->width != osmesa->width || osbuf->height != osmesa->height)
+         mask = ~0;
+      osmesa_buffer_release_textures(osbuf, mask);
+
+      osmesa->stctx->notify_invalid_framebuffer(osmesa->stctx, &osbuf->stfbi);
+   }
+
+   osbuf->map = osmesa->map;
+   osbuf->stride = stride;
+   osbuf->width = osmesa->width;
+   osbuf->height = osmesa->height;
+
+   if (!stapi->make_current(stapi, osmesa->stctx, &osbuf->stfbi, &osbuf->stfbi))
+      return GL_FALSE;
+
+   /* the state tracker no longer references the old drawable */
+   if (old)
+      osmesa_destroy_buffer(old);
+
+   return GL_TRUE;
+}
+
+
+/**********************************************************************/
+/*****                    Public Functions                        *****/
+/**********************************************************************/
+
+
+/**
+ * Create an Off-Screen Mesa rendering context.  The only attribute needed is
+ * an RGBA vs Color-Index mode flag.
+ *
+ * Input:  format - Must be GL_RGBA
+ *         sharelist - specifies another OSMesaContext with which to share
+ *                     display lists.  NULL indicates no sharing.
+ * Return:  an OSMesaContext or 0 if error
+ */
+GLAPI OSMesaContext GLAPIENTRY
+OSMesaCreateContext( GLenum format, OSMesaContext sharelist )
+{
+   const GLint accumBits = (format == OSMESA_COLOR_INDEX) ? 0 : 16;
+   return OSMesaCreateContextExt(format, DEFAULT_SOFTWARE_DEPTH_BITS,
+                                 8, accumBits, sharelist);
+}
+
+
+/**
+ * New in Mesa 3.5
+ *
+ * Create context and specify size of ancillary buffers.
+ */
+GLAPI OSMesaContext GLAPIENTRY
+OSMesaCreateContextExt( GLenum format, GLint depthBits, GLint stencilBits,
+                        GLint accumBits, OSMesaContext sharelist )
+{
+   struct osmesa_context *osmesa;
+   struct st_context_attribs attribs;
+   enum pipe_format color_format;
+   GLenum type;
+
+   if (!osmesa_init())
+      return NULL;
+
+   /* the color format is settled by OSMesaMakeCurrent() */
+   type = (format == OSMESA_RGB_565) ? GL_UNSIGNED_SHORT_5_6_5 : GL_UNSIGNED_BYTE;
+   color_format = osmesa_choose_color_format(format, type);
+   if (color_format == PIPE_FORMAT_NONE)
+      return NULL;
+
+   osmesa = CALLOC_STRUCT(osmesa_context);
+   if (!osmesa)
+      return NULL;
+
+   osmesa->format = format;
+   osmesa->type = type;
+   osmesa->y_up = GL_TRUE;
+
+   osmesa->visual.buffer_mask = ST_ATTACHMENT_FRONT_LEFT_MASK;
+   osmesa->visual.color_format = color_format;
+   osmesa->visual.render_buffer = ST_ATTACHMENT_FRONT_LEFT;
+
+   if (depthBits > 0 || stencilBits > 0) {
+      osmesa->visual.depth_stencil_format =
+         osmesa_choose_depth_stencil_format(depthBits, stencilBits);
+      if (osmesa->visual.depth_stencil_format != PIPE_FORMAT_NONE)
+         osmesa->visual.buffer_mask |= ST_ATTACHMENT_DEPTH_STENCIL_MASK;
+   }
+
+   /* the accumulation buffer is done by the state tracker in software */
+   osmesa->visual.accum_format = (accumBits > 0) ?
+      PIPE_FORMAT_R16G16B16A16_SNORM : PIPE_FORMAT_NONE;
+
+   memset(&attribs, 0, sizeof(attribs));
+   attribs.profile = ST_PROFILE_DEFAULT;
+   attribs.visual = osmesa->visual;
+
+   osmesa->stctx = stapi->create_context(stapi, smapi, &attribs,
+                                         sharelist ? sharelist->stctx : NULL);
+   if (!osmesa->stctx) {
+      FREE(osmesa);
+      return NULL;
+   }
+
+   osmesa->stctx->st_manager_private = (void *) osmesa;
+
+   return osmesa;
+}
+
+
+/**
+ * Destroy an Off-Screen Mesa rendering context.
+ *
+ * \param osmesa  the context to destroy
+ */
+GLAPI void GLAPIENTRY
+OSMesaDestroyContext( OSMesaContext osmesa )
+{
+   if (osmesa) {
+      if (stapi->get_current(stapi) == osmesa->stctx)
+         stapi->make_current(stapi, NULL, NULL, NULL);
+
+      osmesa_unmap_depth_buffer(osmesa);
+      osmesa->stctx->destroy(osmesa->stctx);
+
+      if (osmesa->buffer)
+         osmesa_destroy_buffer(osmesa->buffer);
+
+      FREE(osmesa);
+   }
+}
+
+
+/**
+ * Bind an OSMesaContext to an image buffer.  The image buffer is just a
+ * block of memory which the client provides.  Its size must be at least
+ * as large as width*height*sizeof(type).  Its address should be a multiple
+ * of 16 bytes, as should the row size; otherwise rendering goes through
+ * an internal image which is copied to the buffer on glFlush/glFinish.
+ *
+ * Image data is stored in the order of glDrawPixels:  row-major order
+ * with the lower-left image pixel stored in the first array position
+ * (ie. bottom-to-top), unless OSMESA_Y_UP is set to false.
+ *
+ * If the context's viewport hasn't been initialized yet, it will now be
+ * initialized to (0,0,width,height).
+ *
+ * Input:  osmesa - the rendering context
+ *         buffer - the image buffer memory
+ *         type - data type for pixel components:  GL_UNSIGNED_BYTE or
+ *            GL_UNSIGNED_SHORT for OSMESA_RGBA, GL_UNSIGNED_BYTE for
+ *            OSMESA_BGRA and OSMESA_ARGB, GL_UNSIGNED_SHORT_5_6_5 for
+ *            OSMESA_RGB_565.  The packed RGB/BGR formats and color index
+ *            mode aren't supported.
+ *         width, height - size of image buffer in pixels, at least 1
+ * Return:  GL_TRUE if success, GL_FALSE if error because of invalid osmesa,
+ *          invalid buffer address, invalid type, width<1, height<1,
+ *          width>internal limit or height>internal limit.
+ */
+GLAPI GLboolean GLAPIENTRY
+OSMesaMakeCurrent( OSMesaContext osmesa, void *buffer, GLenum type,
+                   GLsizei width, GLsizei height )
+{
+   struct pipe_screen *screen;
+   enum pipe_format color_format;
+
+   if (!osmesa || !buffer ||
+       width < 1 || height < 1 ||
+       width > MAX_WIDTH || height > MAX_HEIGHT) {
+      return GL_FALSE;
+   }
+
+   screen = smapi->screen;
+   color_format = osmesa_choose_color_format(osmesa->format, type);
+   if (color_format == PIPE_FORMAT_NONE ||
+       !screen->is_format_supported(screen, color_format, PIPE_TEXTURE_2D, 0,
+                                    PIPE_BIND_DISPLAY_TARGET |
+                                    PIPE_BIND_RENDER_TARGET, 0)) {
+      return GL_FALSE;
+   }
+
+   osmesa->map = buffer;
+   osmesa->type = type;
+   osmesa->width = width;
+   osmesa->height = height;
+
+   return osmesa_update_buffer(osmesa);
+}
+
+
+GLAPI OSMesaContext GLAPIENTRY
+OSMesaGetCurrentContext( void )
+{
+   struct st_context_iface *stctx = stapi ? stapi->get_current(stapi) : NULL;
+
+   return stctx ? (OSMesaContext) stctx->st_manager_private : NULL;
+}
+
+
+GLAPI void GLAPIENTRY
+OSMesaPixelStore( GLint pname, GLint value )
+{
+   OSMesaContext osmesa = OSMesaGetCurrentContext();
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (!osmesa)
+      return;
+
+   switch (pname) {
+      case OSMESA_ROW_LENGTH:
+         if (value<0) {
+            _mesa_error( ctx, GL_INVALID_VALUE,
+                      "OSMesaPixelStore(value)" );
+            return;
+         }
+         osmesa->user_row_length = value;
+         break;
+      case OSMESA_Y_UP:
+         osmesa->y_up = value ? GL_TRUE : GL_FALSE;
+         break;
+      default:
+         _mesa_error( ctx, GL_INVALID_ENUM, "OSMesaPixelStore(pname)" );
+         return;
+   }
+
+   if (osmesa->buffer)
+      osmesa_update_buffer(osmesa);
+}
+
+
+GLAPI void GLAPIENTRY
+OSMesaGetIntegerv( GLint pname, GLint *value )
+{
+   OSMesaContext osmesa = OSMesaGetCurrentContext();
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (!osmesa)
+      return;
+
+   switch (pname) {
+      case OSMESA_WIDTH:
+         *value = osmesa->buffer ? osmesa->width : 0;
+         return;
+      case OSMESA_HEIGHT:
+         *value = osmesa->buffer ? osmesa->height : 0;
+         return;
+      case OSMESA_FORMAT:
+         *value = osmesa->format;
+         return;
+      case OSMESA_TYPE:
+         /* current color buffer's data type */
+         *value = osmesa->buffer ? osmesa->type : 0;
+         return;
+      case OSMESA_ROW_LENGTH:
+         *value = osmesa->user_row_length;
+         return;
+      case OSMESA_Y_UP:
+         *value = osmesa->y_up;
+         return;
+      case OSMESA_MAX_WIDTH:
+         *value = MAX_WIDTH;
+         return;
+      case OSMESA_MAX_HEIGHT:
+         *value = MAX_HEIGHT;
+         return;
+      default:
+         _mesa_error(ctx, GL_INVALID_ENUM, "OSMesaGetIntergerv(pname)");
+         return;
+   }
+}
+
+
+/**
+ * Return the depth buffer associated with an OSMesa context.
+ * The depth buffer is owned by the driver, so it is flushed and mapped
+ * here.  The pointer stays valid until the next call of this function or
+ * of OSMesaMakeCurrent() / OSMesaPixelStore() with the context.
+ * Input:  c - the OSMesa context
+ * Output:  width, height - size of buffer in pixels
+ *          bytesPerValue - bytes per depth value (2 or 4)
+ *          buffer - pointer to depth buffer values
+ * Return:  GL_TRUE or GL_FALSE to indicate success or failure.
+ */
+GLAPI GLboolean GLAPIENTRY
+OSMesaGetDepthBuffer( OSMesaContext c, GLint *width, GLint *height,
+                      GLint *bytesPerValue, void **buffer )
+{
+   struct pipe_resource *tex = NULL;
+   void *map = NULL;
+
+   osmesa_unmap_depth_buffer(c);
+
+   if (c->buffer)
+      tex = c->buffer->textures[ST_ATTACHMENT_DEPTH_STENCIL];
+
+   if (tex) {
+      struct pipe_context *pipe = c->stctx->pipe;
+
+      c->stctx->flush(c->stctx, PIPE_FLUSH_RENDER_CACHE, NULL);
+
+      c->zs_transfer = pipe_get_transfer(pipe, tex, 0, 0,
+                                         PIPE_TRANSFER_READ_WRITE,
+                                         0, 0, tex->width0, tex->height0);
+      if (c->zs_transfer)
+         map = pipe->transfer_map(pipe, c->zs_transfer);
+      if (!map && c->zs_transfer) {
+         pipe->transfer_destroy(pipe, c->zs_transfer);
+         c->zs_transfer = NULL;
+      }
+   }
+
+   if (!map) {
+      *width = 0;
+      *height = 0;
+      *bytesPerValue = 0;
+      *buffer = 0;
+      return GL_FALSE;
+   }
+   else {
+      *width = tex->width0;
+      *height = tex->height0;
+      *bytesPerValue = util_format_get_blocksize(tex->format);
+      *buffer = map;
+      return GL_TRUE;
+   }
+}
+
+
+/**
+ * Return the color buffer associated with an OSMesa context.
+ * Input:  c - the OSMesa context
+ * Output:  width, height - size of buffer in pixels
+ *          format - the pixel format (OSMESA_FORMAT)
+ *          buffer - pointer to color buffer values
+ * Return:  GL_TRUE or GL_FALSE to indicate success or failure.
+ */
+GLAPI GLboolean GLAPIENTRY
+OSMesaGetColorBuffer( OSMesaContext osmesa, GLint *width,
+                      GLint *height, GLint *format, void **buffer )
+{
+   if (osmesa->buffer) {
+      *width = osmesa->width;
+      *height = osmesa->height;
+      *format = osmesa->format;
+      *buffer = osmesa->map;
+      return GL_TRUE;
+   }
+   else {
+      *width = 0;
+      *height = 0;
+      *format = 0;
+      *buffer = 0;
+      return GL_FALSE;
+   }
+}
+
+
+struct name_function
+{
+   const char *Name;
+   OSMESAproc Function;
+};
+
+static struct name_function functions[] = {
+   { "OSMesaCreateContext", (OSMESAproc) OSMesaCreateContext },
+   { "OSMesaCreateContextExt", (OSMESAproc) OSMesaCreateContextExt },
+   { "OSMesaDestroyContext", (OSMESAproc) OSMesaDestroyContext },
+   { "OSMesaMakeCurrent", (OSMESAproc) OSMesaMakeCurrent },
+   { "OSMesaGetCurrentContext", (OSMESAproc) OSMesaGetCurrentContext },
+   { "OSMesaPixelsStore", (OSMESAproc) OSMesaPixelStore },
+   { "OSMesaGetIntegerv", (OSMESAproc) OSMesaGetIntegerv },
+   { "OSMesaGetDepthBuffer", (OSMESAproc) OSMesaGetDepthBuffer },
+   { "OSMesaGetColorBuffer", (OSMESAproc) OSMesaGetColorBuffer },
+   { "OSMesaGetProcAddress", (OSMESAproc) OSMesaGetProcAddress },
+   { "OSMesaColorClamp", (OSMESAproc) OSMesaColorClamp },
+   { NULL, NULL }
+};
+
+
+GLAPI OSMESAproc GLAPIENTRY
+OSMesaGetProcAddress( const char *funcName )
+{
+   int i;
+   for (i = 0; functions[i].Name; i++) {
+      if (strcmp(functions[i].Name, funcName) == 0)
+         return functions[i].Function;
+   }
+   return (OSMESAproc) _glapi_get_proc_address(funcName);
+}
+
+
+GLAPI void GLAPIENTRY
+OSMesaColorClamp(GLboolean enable)
+{
+   if (!OSMesaGetCurrentContext())
+      return;
+
+   _mesa_ClampColorARB(GL_CLAMP_FRAGMENT_COLOR_ARB,
+                       enable ? GL_TRUE : GL_FIXED_ONLY_ARB);
+}
@@ -0,0 +1,48 @@
+/**************************************************************************
+ * 
+ * Copyright 2011 VMware, Inc.
+ * All Rights Reserved.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE 
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ * 
+ **************************************************************************/
+
+
+#ifndef OSMESA_PUBLIC_H
+#define OSMESA_PUBLIC_H
+
+struct pipe_screen;
+struct sw_winsys;
+struct st_api;
+
+/* This is the driver interface required by the osmesa state tracker.
+ * The winsys passed to create_pipe_screen() is the osmesa one.
+ */
+struct osmesa_driver {
+   struct pipe_screen *(*create_pipe_screen)( struct sw_winsys *winsys );
+   struct st_api *(*create_st_api)( void );
+};
+
+extern void
+osmesa_set_driver( const struct osmesa_driver *driver );
+
+
+#endif /* OSMESA_PUBLIC_H */
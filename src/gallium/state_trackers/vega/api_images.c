@@ -492,3 +492,37 @@ void vegaCopyPixels(VGint dx, VGint dy,
    vg_copy_surface(ctx, strb->surface, dx, dy,
                    strb->surface, sx, sy, width, height);
 }
+
+VGImage vegaCreateEGLImageTargetKHR(VGeglImageKHR image)
+{
+   struct vg_context *ctx = vg_current_context();
+   struct st_manager *smapi =
+      (struct st_manager *) ctx->iface.st_context_private;
+   struct st_egl_image stimg;
+   struct vg_image *img;
+
+   if (!smapi || !smapi->get_egl_image) {
+      vg_set_error(ctx, VG_ILLEGAL_ARGUMENT_ERROR);
+      return VG_INVALID_HANDLE;
+   }
+
+   memset(&stimg, 0, sizeof(stimg));
+   if (!smapi->get_egl_image(smapi, (void *) image, &stimg)) {
+      vg_set_error(ctx, VG_ILLEGAL_ARGUMENT_ERROR);
+      return VG_INVALID_HANDLE;
+   }
+
+   /* only the base level of a 2D texture can back a VGImage */
+   if (stimg.level != 0 || stimg.layer != 0)
+      img = NULL;
+   else
+      img = image_create_from_resource(stimg.texture);
+   pipe_resource_reference(&stimg.texture, NULL);
+
+   if (!img) {
+      vg_set_error(ctx, VG_UNSUPPORTED_IMAGE_FORMAT_ERROR);
+      return VG_INVALID_HANDLE;
+   }
+
+   return (VGImage) img;
+}
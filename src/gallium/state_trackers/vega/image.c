@@ -231,23 +231,22 @@ static void image_cleari(struct vg_image *img, VGint clear_colori,
    free(clearbuf);
 }
 
-struct vg_image * image_create(VGImageFormat format,
-                               VGint width, VGint height)
+static struct vg_image *image_create_from_texture(struct vg_context *ctx,
+                                                  VGImageFormat format,
+                                                  struct pipe_resource *texture)
 {
-   struct vg_context *ctx = vg_current_context();
    struct pipe_context *pipe = ctx->pipe;
    struct vg_image *image = CALLOC_STRUCT(vg_image);
-   enum pipe_format pformat = vg_format_to_pipe(format);
-   struct pipe_resource pt, *newtex;
    struct pipe_sampler_view view_templ;
-   struct pipe_sampler_view *view;
-   struct pipe_screen *screen = ctx->pipe->screen;
+
+   if (!image)
+      return NULL;
 
    vg_init_object(&image->base, ctx, VG_OBJECT_IMAGE);
 
    image->format = format;
-   image->width = width;
-   image->height = height;
+   image->width = texture->width0;
+   image->height = texture->height0;
 
    image->sampler.wrap_s = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
    image->sampler.wrap_t = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
@@ -256,6 +255,35 @@ struct vg_image * image_create(VGImageFormat format,
    image->sampler.mag_img_filter = PIPE_TEX_MIPFILTER_NEAREST;
    image->sampler.normalized_coords = 1;
 
+   u_sampler_view_default_template(&view_templ, texture, texture->format);
+   /* R, G, and B are treated as 1.0 for alpha-only formats in OpenVG */
+   if (texture->format == PIPE_FORMAT_A8_UNORM) {
+      view_templ.swizzle_r = PIPE_SWIZZLE_ONE;
+      view_templ.swizzle_g = PIPE_SWIZZLE_ONE;
+      view_templ.swizzle_b = PIPE_SWIZZLE_ONE;
+   }
+
+   /* the view holds the reference to the texture */
+   image->sampler_view = pipe->create_sampler_view(pipe, texture, &view_templ);
+   if (!image->sampler_view) {
+      FREE(image);
+      return NULL;
+   }
+
+   vg_context_add_object(ctx, VG_OBJECT_IMAGE, image);
+
+   return image;
+}
+
+struct vg_image * image_create(VGImageFormat format,
+                               VGint width, VGint height)
+{
+   struct vg_context *ctx = vg_current_context();
+   struct vg_image *image;
+   enum pipe_format pformat = vg_format_to_pipe(format);
+   struct pipe_resource pt, *newtex;
+   struct pipe_screen *screen = ctx->pipe->screen;
+
    assert(screen->is_format_supported(screen, pformat, PIPE_TEXTURE_2D,
                                       0, PIPE_BIND_SAMPLER_VIEW, 0));
 
@@ -273,26 +301,59 @@ struct vg_image * image_create(VGImageFormat format,
 
    debug_assert(newtex);
 
-   u_sampler_view_default_template(&view_templ, newtex, newtex->format);
-   /* R, G, and B are treated as 1.0 for alpha-only formats in OpenVG */
-   if (newtex->format == PIPE_FORMAT_A8_UNORM) {
-      view_templ.swizzle_r = PIPE_SWIZZLE_ONE;
-      view_templ.swizzle_g = PIPE_SWIZZLE_ONE;
-      view_templ.swizzle_b = PIPE_SWIZZLE_ONE;
-   }
-
-   view = pipe->create_sampler_view(pipe, newtex, &view_templ);
+   image = image_create_from_texture(ctx, format, newtex);
    /* want the texture to go away if the view is freed */
    pipe_resource_reference(&newtex, NULL);
 
-   image->sampler_view = view;
-
-   vg_context_add_object(ctx, VG_OBJECT_IMAGE, image);
+   debug_assert(image);
 
    image_cleari(image, 0, 0, 0, image->width, image->height);
    return image;
 }
 
+/**
+ * Create an image that aliases the given texture, e.g. the texture of an
+ * EGLImage.  No pixels are copied; rendering by other contexts to the
+ * texture is visible once they have flushed.
+ */
+struct vg_image * image_create_from_resource(struct pipe_resource *texture)
+{
+   struct vg_context *ctx = vg_current_context();
+   VGImageFormat format;
+
+   if (texture->target != PIPE_TEXTURE_2D &&
+       texture->target != PIPE_TEXTURE_RECT)
+      return NULL;
+
+   switch (texture->format) {
+   case PIPE_FORMAT_B8G8R8A8_UNORM:
+      format = VG_sARGB_8888;
+      break;
+   case PIPE_FORMAT_B8G8R8X8_UNORM:
+      format = VG_sXRGB_8888;
+      break;
+   case PIPE_FORMAT_B5G6R5_UNORM:
+      format = VG_sRGB_565;
+      break;
+   case PIPE_FORMAT_B5G5R5A1_UNORM:
+      format = VG_sRGBA_5551;
+      break;
+   case PIPE_FORMAT_B4G4R4A4_UNORM:
+      format = VG_sRGBA_4444;
+      break;
+   case PIPE_FORMAT_L8_UNORM:
+      format = VG_sL_8;
+      break;
+   case PIPE_FORMAT_A8_UNORM:
+      format = VG_A_8;
+      break;
+   default:
+      return NULL;
+   }
+
+   return image_create_from_texture(ctx, format, texture);
+}
+
 void image_destroy(struct vg_image *img)
 {
    struct vg_context *ctx = vg_current_context();
@@ -51,6 +51,7 @@ struct vg_image {
 
 struct vg_image *image_create(VGImageFormat format,
                               VGint width, VGint height);
+struct vg_image *image_create_from_resource(struct pipe_resource *texture);
 void image_destroy(struct vg_image *img);
 
 void image_clear(struct vg_image *img,
@@ -148,6 +148,31 @@ vg_context_flush(struct st_context_iface *stctxi, unsigned flags,
       vg_manager_flush_frontbuffer(ctx);
 }
 
+static boolean
+vg_context_get_resource_for_egl_image(struct st_context_iface *stctxi,
+                                      struct st_context_resource *stres)
+{
+   struct vg_context *ctx = (struct vg_context *) stctxi;
+   struct vg_image *img = (struct vg_image *) stres->resource;
+
+   if (stres->type != ST_CONTEXT_RESOURCE_OPENVG_PARENT_IMAGE ||
+       vg_current_context() != ctx)
+      return FALSE;
+
+   /* only root images can be EGLImage sources */
+   if (!img || !vg_context_is_object_valid(ctx, VG_OBJECT_IMAGE, img) ||
+       img->parent)
+      return FALSE;
+
+   /* make pending rendering to the image visible to the siblings */
+   ctx->pipe->flush(ctx->pipe, PIPE_FLUSH_RENDER_CACHE, NULL);
+
+   stres->texture = NULL;
+   pipe_resource_reference(&stres->texture, img->sampler_view->texture);
+
+   return TRUE;
+}
+
 static void
 vg_context_destroy(struct st_context_iface *stctxi)
 {
@@ -191,8 +216,11 @@ vg_api_create_context(struct st_api *stapi, struct st_manager *smapi,
 
    ctx->iface.teximage = NULL;
    ctx->iface.copy = NULL;
+   ctx->iface.get_resource_for_egl_image =
+      vg_context_get_resource_for_egl_image;
 
    ctx->iface.st_context_private = (void *) smapi;
+   ctx->iface.pipe = pipe;
 
    return &ctx->iface;
 }
@@ -464,6 +464,65 @@ setup_transforms(struct  exa_context *exa,
       matrix_from_pict_transform(mask_t, exa->transform.mask);
 }
 
+/* Fill in the batch key.  Returns FALSE for composites which can't be
+ * batched; transforms and gradients are rare enough to not bother.
+ * Neither are composites which sample the destination: the queued
+ * rectangles must reach it before it is read again.
+ */
+static boolean
+composite_key(struct xorg_composite_key *key, int op,
+              PicturePtr pSrcPicture, PicturePtr pMaskPicture,
+              PicturePtr pDstPicture,
+              struct exa_pixmap_priv *pSrc,
+              struct exa_pixmap_priv *pMask,
+              struct exa_pixmap_priv *pDst)
+{
+   memset(key, 0, sizeof(*key));
+
+   if ((pSrcPicture && pSrcPicture->transform) ||
+       (pMaskPicture && pMaskPicture->transform))
+      return FALSE;
+
+   if (pSrc == pDst || pMask == pDst)
+      return FALSE;
+
+   key->op = op;
+   key->dst = pDst;
+   key->dst_tex = pDst->tex;
+   key->dst_format = pDstPicture ? pDstPicture->format : 0;
+
+   if (pSrcPicture) {
+      key->has_src = 1;
+      key->src_format = pSrcPicture->format;
+      key->src_repeat = pSrcPicture->repeatType;
+      key->src_filter = pSrcPicture->filter;
+      if (pSrcPicture->pSourcePict) {
+         if (pSrcPicture->pSourcePict->type != SourcePictTypeSolidFill)
+            return FALSE;
+         key->src_solid = 1;
+         key->solid_color = pSrcPicture->pSourcePict->solidFill.color;
+      }
+   }
+   if (pSrc) {
+      key->src = pSrc;
+      key->src_tex = pSrc->tex;
+   }
+
+   if (pMaskPicture) {
+      key->has_mask = 1;
+      key->mask_format = pMaskPicture->format;
+      key->mask_repeat = pMaskPicture->repeatType;
+      key->mask_filter = pMaskPicture->filter;
+      key->mask_ca = pMaskPicture->componentAlpha ? 1 : 0;
+   }
+   if (pMask) {
+      key->mask = pMask;
+      key->mask_tex = pMask->tex;
+   }
+
+   return TRUE;
+}
+
 boolean xorg_composite_bind_state(struct exa_context *exa,
                                   int op,
                                   PicturePtr pSrcPicture,
@@ -473,7 +532,27 @@ boolean xorg_composite_bind_state(struct exa_context *exa,
                                   struct exa_pixmap_priv *pMask,
                                   struct exa_pixmap_priv *pDst)
 {
-   struct pipe_surface *dst_surf = xorg_gpu_surface(exa->pipe, pDst);
+   struct xorg_composite_key key;
+   struct pipe_surface *dst_surf;
+   boolean batchable;
+
+   batchable = composite_key(&key, op, pSrcPicture, pMaskPicture,
+                             pDstPicture, pSrc, pMask, pDst);
+
+   /* Same state as the previous composite: everything is still bound,
+    * keep appending to its vertex buffer. */
+   if (batchable && exa->batch.pending &&
+       memcmp(&key, &exa->batch.key, sizeof(key)) == 0) {
+      exa->batch.pending = FALSE;
+      return TRUE;
+   }
+
+   xorg_composite_flush_batch(exa);
+
+   exa->batch.key = key;
+   exa->batch.valid = batchable;
+
+   dst_surf = xorg_gpu_surface(exa->pipe, pDst);
 
    renderer_bind_destination(exa->renderer, dst_surf,
                              pDst->width,
@@ -574,6 +653,9 @@ void xorg_solid(struct exa_context *exa,
 void
 xorg_composite_done(struct exa_context *exa)
 {
+   exa->batch.valid = FALSE;
+   exa->batch.pending = FALSE;
+
    renderer_draw_flush(exa->renderer);
 
    exa->transform.has_src = FALSE;
@@ -581,3 +663,22 @@ xorg_composite_done(struct exa_context *exa)
    exa->has_solid_color = FALSE;
    exa->num_bound_samplers = 0;
 }
+
+/* DoneComposite: keep batchable composites open until something else
+ * needs the context.
+ */
+void
+xorg_composite_done_deferred(struct exa_context *exa)
+{
+   if (exa->batch.valid)
+      exa->batch.pending = TRUE;
+   else
+      xorg_composite_done(exa);
+}
+
+void
+xorg_composite_flush_batch(struct exa_context *exa)
+{
+   if (exa->batch.pending)
+      xorg_composite_done(exa);
+}
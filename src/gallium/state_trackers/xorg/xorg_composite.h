@@ -33,4 +33,10 @@ void xorg_solid(struct exa_context *exa,
 void
 xorg_composite_done(struct exa_context *exa);
 
+void
+xorg_composite_done_deferred(struct exa_context *exa);
+
+void
+xorg_composite_flush_batch(struct exa_context *exa);
+
 #endif
@@ -34,6 +34,7 @@
 
 #include "xorg_tracker.h"
 #include "xorg_exa.h"
+#include "xorg_composite.h"
 
 #include "dri2.h"
 
@@ -332,6 +333,8 @@ dri2_copy_region(DrawablePtr pDraw, RegionPtr pRegion,
      * must in the glXWaitGL case but we don't know if this is a glXWaitGL
      * or a glFlush/glFinish call.
      */
+    xorg_composite_flush_batch(ms->exa);
+
     if (dst_priv->pPixmap == src_priv->pPixmap) {
 	/* pixmap glXWaitX */
 	if (pSrcBuffer->attachment == DRI2BufferFrontLeft &&
@@ -388,6 +391,8 @@ dri2_copy_region(DrawablePtr pDraw, RegionPtr pRegion,
 
     FreeScratchGC(gc);
 
+    xorg_composite_flush_batch(ms->exa);
+
     ms->ctx->flush(ms->ctx, PIPE_FLUSH_SWAPBUFFERS,
 		   (pDestBuffer->attachment == DRI2BufferFrontLeft
 		    && ms->swapThrottling) ?
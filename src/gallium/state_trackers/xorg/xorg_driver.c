@@ -56,6 +56,7 @@
 #include "pipe/p_context.h"
 #include "xorg_tracker.h"
 #include "xorg_winsys.h"
+#include "xorg_composite.h"
 
 #ifdef HAVE_LIBKMS
 #include "libkms.h"
@@ -545,6 +546,9 @@ void xorg_flush(ScreenPtr pScreen)
     if (ms->ctx) {
 	int j;
 
+	if (ms->exa)
+	    xorg_composite_flush_batch(ms->exa);
+
 	ms->ctx->flush(ms->ctx, PIPE_FLUSH_RENDER_CACHE,
 		       ms->dirtyThrottling ?
 		       &ms->fence[XORG_NR_FENCES-1] :
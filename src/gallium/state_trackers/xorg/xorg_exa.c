@@ -190,6 +190,8 @@ ExaDownloadFromScreen(PixmapPtr pPix, int x,  int y, int w,  int h, char *dst,
     if (!priv || !priv->tex)
 	return FALSE;
 
+    xorg_composite_flush_batch(exa);
+
     transfer = pipe_get_transfer(exa->pipe, priv->tex, 0, 0,
                                  PIPE_TRANSFER_READ, x, y, w, h);
     if (!transfer)
@@ -224,6 +226,8 @@ ExaUploadToScreen(PixmapPtr pPix, int x, int y, int w, int h, char *src,
     if (!priv || !priv->tex)
 	return FALSE;
 
+    xorg_composite_flush_batch(exa);
+
     transfer = pipe_get_transfer(exa->pipe, priv->tex, 0, 0,
                                  PIPE_TRANSFER_WRITE, x, y, w, h);
     if (!transfer)
@@ -261,6 +265,8 @@ ExaPrepareAccess(PixmapPtr pPix, int index)
     if (!priv->tex)
 	return FALSE;
 
+    xorg_composite_flush_batch(exa);
+
     if (priv->map_count == 0)
     {
         assert(pPix->drawable.width <= priv->tex->width0);
@@ -335,6 +341,8 @@ ExaPrepareSolid(PixmapPtr pPixmap, int alu, Pixel planeMask, Pixel fg)
     if (!exa->accel)
 	return FALSE;
 
+    xorg_composite_flush_batch(exa);
+
     if (!exa->pipe)
 	XORG_FALLBACK("accle not enabled");
 
@@ -413,6 +421,8 @@ ExaPrepareCopy(PixmapPtr pSrcPixmap, PixmapPtr pDstPixmap, int xdir,
     if (!exa->accel)
 	return FALSE;
 
+    xorg_composite_flush_batch(exa);
+
     if (!exa->pipe)
 	XORG_FALLBACK("accle not enabled");
 
@@ -707,7 +717,7 @@ ExaDoneComposite(PixmapPtr pPixmap)
    modesettingPtr ms = modesettingPTR(pScrn);
    struct exa_context *exa = ms->exa;
 
-   xorg_composite_done(exa);
+   xorg_composite_done_deferred(exa);
 }
 
 
@@ -731,10 +741,15 @@ static void
 ExaDestroyPixmap(ScreenPtr pScreen, void *dPriv)
 {
     struct exa_pixmap_priv *priv = (struct exa_pixmap_priv *)dPriv;
+    modesettingPtr ms = modesettingPTR(xf86Screens[pScreen->myNum]);
 
     if (!priv)
 	return;
 
+    /* The pending batch may reference this pixmap */
+    if (ms->exa)
+       xorg_composite_flush_batch(ms->exa);
+
     pipe_resource_reference(&priv->tex, NULL);
 
     free(priv);
@@ -846,6 +861,8 @@ ExaModifyPixmapHeader(PixmapPtr pPixmap, int width, int height,
     if (width <= 0 || height <= 0 || depth <= 0)
 	return FALSE;
 
+    xorg_composite_flush_batch(exa);
+
     miModifyPixmapHeader(pPixmap, width, height, depth,
 			     bitsPerPixel, devKind, NULL);
 
@@ -912,6 +929,8 @@ Bool
 xorg_exa_set_texture(PixmapPtr pPixmap, struct  pipe_resource *tex)
 {
     struct exa_pixmap_priv *priv = exaGetPixmapDriverPrivate(pPixmap);
+    ScrnInfoPtr pScrn = xf86Screens[pPixmap->drawable.pScreen->myNum];
+    modesettingPtr ms = modesettingPTR(pScrn);
 
     int mask = PIPE_BIND_SHARED | PIPE_BIND_SCANOUT;
 
@@ -922,6 +941,9 @@ xorg_exa_set_texture(PixmapPtr pPixmap, struct  pipe_resource *tex)
 	pPixmap->drawable.height != tex->height0)
 	return FALSE;
 
+    if (ms->exa)
+       xorg_composite_flush_batch(ms->exa);
+
     pipe_resource_reference(&priv->tex, tex);
     priv->tex_flags = tex->bind & mask;
 
@@ -959,6 +981,9 @@ xorg_exa_close(ScrnInfoPtr pScrn)
    modesettingPtr ms = modesettingPTR(pScrn);
    struct exa_context *exa = ms->exa;
 
+   if (exa->renderer)
+      xorg_composite_flush_batch(exa);
+
    pipe_sampler_view_reference(&exa->bound_sampler_views[0], NULL);
    pipe_sampler_view_reference(&exa->bound_sampler_views[1], NULL);
 
@@ -1075,6 +1100,8 @@ xorg_gpu_surface(struct pipe_context *pipe, struct exa_pixmap_priv *priv)
 void xorg_exa_flush(struct exa_context *exa, uint pipeFlushFlags,
                     struct pipe_fence_handle **fence)
 {
+   xorg_composite_flush_batch(exa);
+
    exa->pipe->flush(exa->pipe, pipeFlushFlags, fence);
 }
 
@@ -11,6 +11,36 @@ struct xorg_shaders;
 /* src + mask + dst */
 #define MAX_EXA_SAMPLERS 3
 
+/* Everything xorg_composite_bind_state() derives its state from; two
+ * composites with the same key can share one vertex buffer.  Compared
+ * with memcmp, so always memset before filling in. */
+struct xorg_composite_key
+{
+   int op;
+
+   struct exa_pixmap_priv *src;
+   struct exa_pixmap_priv *mask;
+   struct exa_pixmap_priv *dst;
+   struct pipe_resource *src_tex;
+   struct pipe_resource *mask_tex;
+   struct pipe_resource *dst_tex;
+
+   unsigned src_format;
+   unsigned mask_format;
+   unsigned dst_format;
+
+   unsigned src_repeat : 8;
+   unsigned src_filter : 8;
+   unsigned mask_repeat : 8;
+   unsigned mask_filter : 8;
+   unsigned mask_ca : 1;
+   unsigned has_src : 1;
+   unsigned has_mask : 1;
+   unsigned src_solid : 1;
+
+   CARD32 solid_color;
+};
+
 struct exa_context
 {
    ExaDriverPtr pExa;
@@ -44,6 +74,16 @@ struct exa_context
 
       struct pipe_resource *src_texture;
    } copy;
+
+   /* Composites whose DoneComposite has been deferred so that following
+    * composites with the same key keep appending to the vertex buffer.
+    * Flushed by xorg_composite_flush_batch().
+    */
+   struct {
+      struct xorg_composite_key key;
+      boolean valid;
+      boolean pending;
+   } batch;
 };
 
 struct exa_pixmap_priv
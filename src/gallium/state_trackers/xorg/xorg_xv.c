@@ -5,6 +5,7 @@
 #include <fourcc.h>
 
 #include "xorg_exa.h"
+#include "xorg_composite.h"
 #include "xorg_renderer.h"
 #include "xorg_exa_tgsi.h"
 
@@ -520,6 +521,9 @@ display_video(ScrnInfoPtr pScrn, struct xorg_xv_port_priv *pPriv, int id,
    struct exa_pixmap_priv *dst;
    struct pipe_surface *dst_surf = NULL;
 
+   /* Xv shares the EXA renderer */
+   xorg_composite_flush_batch(ms->exa);
+
    exaMoveInPixmap(pPixmap);
    dst = exaGetPixmapDriverPrivate(pPixmap);
 
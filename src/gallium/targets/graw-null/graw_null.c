@@ -1,6 +1,32 @@
+#include <string.h>
+
+#include "pipe/p_compiler.h"
+#include "pipe/p_screen.h"
+#include "util/u_debug.h"
+#include "util/u_memory.h"
+#include "target-helpers/inline_sw_helper.h"
+#include "target-helpers/inline_debug_helper.h"
+#include "sw/null/null_sw_winsys.h"
 #include "state_tracker/graw.h"
 
+#ifdef GALLIUM_NOOP
+#include "noop/noop_public.h"
+#endif
+
 
+/* Headless graw implementation.  There is no window: the screen is a
+ * software rasterizer on top of the null winsys, so only resources
+ * without PIPE_BIND_DISPLAY_TARGET can be created.  This is what the
+ * benchmarks in tests/graw use to run without an X server.
+ *
+ * The driver is chosen with GALLIUM_DRIVER (softpipe, llvmpipe or
+ * noop when built in).
+ */
+
+static struct {
+   void (*draw)(void);
+   int dummy_window;
+} graw;
 
 
 struct pipe_screen *
@@ -11,7 +37,30 @@ graw_create_window_and_screen( int x,
                                enum pipe_format format,
                                void **handle)
 {
-   return NULL;
+   struct sw_winsys *winsys;
+   struct pipe_screen *screen = NULL;
+   winsys = null_sw_create();
+   if (winsys == NULL)
+      return NULL;
+
+#ifdef GALLIUM_NOOP
+   if (strcmp(debug_get_option("GALLIUM_DRIVER", ""), "noop") == 0)
+      screen = noop_screen_create(winsys);
+#endif
+
+   if (screen == NULL)
+      screen = sw_screen_create(winsys);
+
+   if (screen == NULL) {
+      winsys->destroy(winsys);
+      return NULL;
+   }
+
+   /* Callers use a non-NULL handle to detect success.
+    */
+   *handle = &graw.dummy_window;
+
+   return debug_screen_wrap(screen);
 }
 
 
@@ -19,10 +68,15 @@ graw_create_window_and_screen( int x,
 void 
 graw_set_display_func( void (*draw)( void ) )
 {
+   graw.draw = draw;
 }
 
 
 void
 graw_main_loop( void )
 {
+   /* Nothing to wait for; draw a single frame.
+    */
+   if (graw.draw)
+      graw.draw();
 }
@@ -0,0 +1,71 @@
+/**************************************************************************
+ * 
+ * Copyright 2011 VMware, Inc.
+ * All Rights Reserved.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE 
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ * 
+ **************************************************************************/
+
+
+/*
+ * Glue the osmesa state tracker to one of the software rasterizers.
+ */
+
+#include "pipe/p_compiler.h"
+#include "util/u_debug.h"
+#include "state_tracker/osmesa_sw_winsys.h"
+#include "osmesa_public.h"
+
+#include "state_tracker/st_api.h"
+#include "state_tracker/st_gl_api.h"
+#include "target-helpers/inline_sw_helper.h"
+#include "target-helpers/inline_debug_helper.h"
+
+
+static struct pipe_screen *
+swrast_osmesa_create_screen( struct sw_winsys *winsys )
+{
+   struct pipe_screen *screen;
+
+   /* Create a software rasterizer on top of the osmesa winsys:
+    */
+   screen = sw_screen_create( winsys );
+   if (screen == NULL)
+      return NULL;
+
+   /* Inject any wrapping layers we want to here:
+    */
+   return debug_screen_wrap( screen );
+}
+
+static struct osmesa_driver osmesa_driver =
+{
+   .create_pipe_screen = swrast_osmesa_create_screen,
+   .create_st_api = st_gl_api_create,
+};
+
+
+static void _init( void ) __attribute__((constructor));
+static void _init( void )
+{
+   osmesa_set_driver( &osmesa_driver );
+}
@@ -0,0 +1,637 @@
+/* Headless throughput benchmarks for gallium drivers.
+ *
+ * Meant to be run against the graw-null target, selecting the driver
+ * with GALLIUM_DRIVER=softpipe|llvmpipe|noop.  Each result is printed
+ * as one JSON object per line so that runs from different builds can be
+ * collected and compared by scripts.
+ *
+ * Usage: bench [-t <test>] [-s <seconds>] [-o <file>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "state_tracker/graw.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_context.h"
+#include "pipe/p_state.h"
+#include "pipe/p_defines.h"
+
+#include "os/os_time.h"
+#include "util/u_box.h"
+#include "util/u_draw.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"      /* Offset() */
+
+#define WIDTH 512
+#define HEIGHT 512
+
+/* Triangle rate test: GRID x GRID cells of two triangles each. */
+#define GRID 64
+
+#define TEX_SIZE 256
+
+static struct pipe_screen *screen = NULL;
+static struct pipe_context *ctx = NULL;
+static struct pipe_resource *rttex = NULL;
+static struct pipe_resource *zstex = NULL;
+static struct pipe_surface *surf = NULL;
+static struct pipe_surface *zsurf = NULL;
+static void *window = NULL;
+
+static struct pipe_resource *quad_vbuf = NULL;
+static struct pipe_resource *grid_vbuf = NULL;
+
+static void *fs_color = NULL;
+static void *fs_tex = NULL;
+static void *blend_none = NULL;
+static void *blend_alpha = NULL;
+static void *blend_add = NULL;
+static void *dsa_none = NULL;
+static void *dsa_lequal = NULL;
+static void *sampler_nearest = NULL;
+static void *sampler_linear = NULL;
+
+static int64_t min_usecs = 1000000;
+static const char *only_test = NULL;
+
+struct vertex {
+   float position[4];
+   float color[4];   /* also used as texcoord */
+};
+
+static const char *fs_color_text =
+   "FRAG\n"
+   "DCL IN[0], GENERIC[0], LINEAR\n"
+   "DCL OUT[0], COLOR\n"
+   "  0: MOV OUT[0], IN[0]\n"
+   "  1: END\n";
+
+static const char *fs_tex_text =
+   "FRAG\n"
+   "DCL IN[0], GENERIC[0], LINEAR\n"
+   "DCL OUT[0], COLOR\n"
+   "DCL SAMP[0]\n"
+   "  0: TEX OUT[0], IN[0], SAMP[0], 2D\n"
+   "  1: END\n";
+
+/* Something a bit longer than a passthrough for the compile test. */
+static const char *fs_compile_text =
+   "FRAG\n"
+   "DCL IN[0], GENERIC[0], LINEAR\n"
+   "DCL OUT[0], COLOR\n"
+   "DCL SAMP[0]\n"
+   "DCL TEMP[0..3]\n"
+   "IMM FLT32 { 0.5, 2.0, 0.25, 1.0 }\n"
+   "  0: TEX TEMP[0], IN[0], SAMP[0], 2D\n"
+   "  1: MUL TEMP[1], IN[0], IMM[0].yyyy\n"
+   "  2: TEX TEMP[1], TEMP[1], SAMP[0], 2D\n"
+   "  3: LRP TEMP[2], IMM[0].xxxx, TEMP[0], TEMP[1]\n"
+   "  4: DP3 TEMP[3].x, TEMP[2], TEMP[2]\n"
+   "  5: RSQ TEMP[3].x, TEMP[3].xxxx\n"
+   "  6: MUL TEMP[2].xyz, TEMP[2], TEMP[3].xxxx\n"
+   "  7: MAD TEMP[2], TEMP[2], IMM[0].zzzz, IMM[0].zzzz\n"
+   "  8: MOV TEMP[2].w, IMM[0].wwww\n"
+   "  9: MOV OUT[0], TEMP[2]\n"
+   " 10: END\n";
+
+
+static void report( const char *test, double value, const char *unit,
+                    unsigned iterations )
+{
+   printf("{\"test\": \"%s\", \"driver\": \"%s\", \"value\": %.3f, "
+          "\"unit\": \"%s\", \"iterations\": %u}\n",
+          test, screen->get_name(screen), value, unit, iterations);
+   fflush(stdout);
+}
+
+
+static void finish( void )
+{
+   struct pipe_fence_handle *fence = NULL;
+
+   ctx->flush(ctx, PIPE_FLUSH_RENDER_CACHE, &fence);
+   if (fence) {
+      screen->fence_finish(screen, fence, 0);
+      screen->fence_reference(screen, &fence, NULL);
+   }
+}
+
+
+/* Call func repeatedly for at least min_usecs and return the elapsed
+ * time in seconds, including waiting for the rendering to complete.
+ */
+static double run( void (*func)( void ), unsigned *iterations )
+{
+   int64_t start, end;
+   unsigned n = 0;
+
+   /* warm up: builds any shader variants and fills caches */
+   func();
+   finish();
+
+   start = os_time_get();
+   do {
+      func();
+      n++;
+      end = os_time_get();
+   } while (end - start < min_usecs);
+   finish();
+   end = os_time_get();
+
+   *iterations = n;
+   return (end - start) * 1e-6;
+}
+
+
+static boolean enabled( const char *test )
+{
+   return only_test == NULL || strcmp(only_test, test) == 0;
+}
+
+
+static void set_vertices( struct pipe_resource *buf, unsigned count )
+{
+   struct pipe_vertex_buffer vbuf;
+
+   vbuf.stride = sizeof(struct vertex);
+   vbuf.max_index = count - 1;
+   vbuf.buffer_offset = 0;
+   vbuf.buffer = buf;
+
+   ctx->set_vertex_buffers(ctx, 1, &vbuf);
+}
+
+
+/*
+ * Tests
+ */
+
+static void draw_clear( void )
+{
+   static const float clear_color[4] = {0.2f, 0.4f, 0.6f, 1.0f};
+
+   ctx->clear(ctx, PIPE_CLEAR_COLOR | PIPE_CLEAR_DEPTHSTENCIL,
+              clear_color, 1.0, 0);
+
+   /* Some drivers defer clears; make sure the memory gets written. */
+   ctx->flush(ctx, PIPE_FLUSH_RENDER_CACHE, NULL);
+}
+
+static void draw_quad( void )
+{
+   util_draw_arrays(ctx, PIPE_PRIM_TRIANGLES, 0, 6);
+}
+
+static void draw_grid( void )
+{
+   util_draw_arrays(ctx, PIPE_PRIM_TRIANGLES, 0, GRID * GRID * 6);
+}
+
+static void draw_state_change( void )
+{
+   static unsigned i = 0;
+
+   ctx->bind_blend_state(ctx, (i & 1) ? blend_alpha : blend_none);
+   ctx->bind_fs_state(ctx, (i & 2) ? fs_tex : fs_color);
+   util_draw_arrays(ctx, PIPE_PRIM_TRIANGLES, 0, 3);
+   i++;
+}
+
+static void compile_shader( void )
+{
+   void *fs = graw_parse_fragment_shader(ctx, fs_compile_text);
+   ctx->delete_fs_state(ctx, fs);
+}
+
+
+static void bench_fill( const char *test, void *fs, void *blend,
+                        void *sampler )
+{
+   unsigned n;
+   double secs;
+
+   if (!enabled(test))
+      return;
+
+   ctx->bind_fs_state(ctx, fs);
+   ctx->bind_blend_state(ctx, blend);
+   if (sampler)
+      ctx->bind_fragment_sampler_states(ctx, 1, &sampler);
+   set_vertices(quad_vbuf, 6);
+
+   secs = run(draw_quad, &n);
+   report(test, (double)n * WIDTH * HEIGHT / secs * 1e-6, "Mpix/s", n);
+}
+
+
+/* Full-viewport quads with the depth test enabled, in millions of 2x2
+ * pixel quads per second.  The depth buffer is cleared only once, so
+ * every quad passes the LEQUAL test and goes through the whole
+ * depth/shade/blend pipeline.
+ */
+static void bench_quads( const char *test, void *fs, void *blend )
+{
+   static const float clear_color[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+   unsigned n;
+   double secs;
+
+   if (!enabled(test))
+      return;
+
+   ctx->bind_fs_state(ctx, fs);
+   ctx->bind_blend_state(ctx, blend);
+   ctx->bind_depth_stencil_alpha_state(ctx, dsa_lequal);
+   ctx->clear(ctx, PIPE_CLEAR_COLOR | PIPE_CLEAR_DEPTHSTENCIL,
+              clear_color, 1.0, 0);
+   set_vertices(quad_vbuf, 6);
+
+   secs = run(draw_quad, &n);
+   report(test, (double)n * (WIDTH / 2) * (HEIGHT / 2) / secs * 1e-6,
+          "Mquad/s", n);
+
+   ctx->bind_depth_stencil_alpha_state(ctx, dsa_none);
+}
+
+
+static void bench_all( void )
+{
+   unsigned n;
+   double secs;
+
+   if (enabled("clear")) {
+      secs = run(draw_clear, &n);
+      report("clear", (double)n * WIDTH * HEIGHT / secs * 1e-6, "Mpix/s", n);
+   }
+
+   bench_fill("fill", fs_color, blend_none, NULL);
+   bench_fill("blend_alpha", fs_color, blend_alpha, NULL);
+   bench_fill("blend_add", fs_color, blend_add, NULL);
+   bench_fill("texture_nearest", fs_tex, blend_none, sampler_nearest);
+   bench_fill("texture_linear", fs_tex, blend_none, sampler_linear);
+
+   bench_quads("quads_depth", fs_color, blend_none);
+   bench_quads("quads_depth_alpha", fs_color, blend_alpha);
+   bench_quads("quads_depth_add", fs_color, blend_add);
+
+   if (enabled("triangles")) {
+      ctx->bind_fs_state(ctx, fs_color);
+      ctx->bind_blend_state(ctx, blend_none);
+      set_vertices(grid_vbuf, GRID * GRID * 6);
+      secs = run(draw_grid, &n);
+      report("triangles", (double)n * GRID * GRID * 2 / secs * 1e-6,
+             "Mtri/s", n);
+   }
+
+   if (enabled("state_change")) {
+      ctx->bind_fragment_sampler_states(ctx, 1, &sampler_nearest);
+      set_vertices(grid_vbuf, GRID * GRID * 6);
+      secs = run(draw_state_change, &n);
+      report("state_change", n / secs * 1e-3, "Kdraw/s", n);
+      ctx->bind_blend_state(ctx, blend_none);
+   }
+
+   if (enabled("shader_compile")) {
+      secs = run(compile_shader, &n);
+      report("shader_compile", secs / n * 1e6, "us", n);
+   }
+}
+
+
+/*
+ * Setup
+ */
+
+static struct pipe_resource *create_vbuf( const struct vertex *verts,
+                                          unsigned count )
+{
+   struct pipe_resource *buf;
+
+   buf = pipe_buffer_create(screen, PIPE_BIND_VERTEX_BUFFER,
+                            count * sizeof *verts);
+   if (buf == NULL)
+      exit(6);
+
+   pipe_buffer_write(ctx, buf, 0, count * sizeof *verts, verts);
+   return buf;
+}
+
+static void init_vertices( void )
+{
+   static const float corners[6][2] = {
+      {0, 0}, {1, 0}, {0, 1},
+      {0, 1}, {1, 0}, {1, 1}
+   };
+   struct pipe_vertex_element ve[2];
+   struct vertex quad[6];
+   struct vertex *grid;
+   unsigned i, j, k;
+   void *handle;
+
+   memset(ve, 0, sizeof ve);
+   ve[0].src_offset = Offset(struct vertex, position);
+   ve[0].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   ve[1].src_offset = Offset(struct vertex, color);
+   ve[1].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+
+   handle = ctx->create_vertex_elements_state(ctx, 2, ve);
+   ctx->bind_vertex_elements_state(ctx, handle);
+
+   /* Full viewport quad.  Color alpha is 0.5 so that blending does
+    * real work; the texcoords repeat the texture four times.
+    */
+   for (k = 0; k < 6; k++) {
+      quad[k].position[0] = corners[k][0] * 2.0f - 1.0f;
+      quad[k].position[1] = corners[k][1] * 2.0f - 1.0f;
+      quad[k].position[2] = 0.0f;
+      quad[k].position[3] = 1.0f;
+      quad[k].color[0] = corners[k][0] * 4.0f;
+      quad[k].color[1] = corners[k][1] * 4.0f;
+      quad[k].color[2] = 0.5f;
+      quad[k].color[3] = 0.5f;
+   }
+   quad_vbuf = create_vbuf(quad, 6);
+
+   /* Small triangles covering the viewport, 8x8 pixel cells. */
+   grid = MALLOC(GRID * GRID * 6 * sizeof *grid);
+   if (grid == NULL)
+      exit(6);
+
+   for (j = 0; j < GRID; j++) {
+      for (i = 0; i < GRID; i++) {
+         struct vertex *v = &grid[(j * GRID + i) * 6];
+         for (k = 0; k < 6; k++) {
+            v[k].position[0] = (i + corners[k][0]) * 2.0f / GRID - 1.0f;
+            v[k].position[1] = (j + corners[k][1]) * 2.0f / GRID - 1.0f;
+            v[k].position[2] = 0.0f;
+            v[k].position[3] = 1.0f;
+            v[k].color[0] = (float)i / GRID;
+            v[k].color[1] = (float)j / GRID;
+            v[k].color[2] = corners[k][0];
+            v[k].color[3] = 1.0f;
+         }
+      }
+   }
+   grid_vbuf = create_vbuf(grid, GRID * GRID * 6);
+   FREE(grid);
+}
+
+static void *create_blend( boolean enable, unsigned src, unsigned dst )
+{
+   struct pipe_blend_state blend;
+
+   memset(&blend, 0, sizeof blend);
+   blend.rt[0].colormask = PIPE_MASK_RGBA;
+   blend.rt[0].blend_enable = enable;
+   blend.rt[0].rgb_func = PIPE_BLEND_ADD;
+   blend.rt[0].rgb_src_factor = src;
+   blend.rt[0].rgb_dst_factor = dst;
+   blend.rt[0].alpha_func = PIPE_BLEND_ADD;
+   blend.rt[0].alpha_src_factor = src;
+   blend.rt[0].alpha_dst_factor = dst;
+
+   return ctx->create_blend_state(ctx, &blend);
+}
+
+static void *create_sampler( unsigned filter )
+{
+   struct pipe_sampler_state sampler;
+
+   memset(&sampler, 0, sizeof sampler);
+   sampler.wrap_s = PIPE_TEX_WRAP_REPEAT;
+   sampler.wrap_t = PIPE_TEX_WRAP_REPEAT;
+   sampler.wrap_r = PIPE_TEX_WRAP_REPEAT;
+   sampler.min_img_filter = filter;
+   sampler.mag_img_filter = filter;
+   sampler.min_mip_filter = PIPE_TEX_MIPFILTER_NONE;
+   sampler.compare_mode = PIPE_TEX_COMPARE_NONE;
+   sampler.normalized_coords = 1;
+
+   return ctx->create_sampler_state(ctx, &sampler);
+}
+
+static void init_texture( void )
+{
+   struct pipe_sampler_view sv_template;
+   struct pipe_sampler_view *sv;
+   struct pipe_resource templat;
+   struct pipe_resource *samptex;
+   struct pipe_box box;
+   ubyte *texels;
+   unsigned s, t;
+
+   texels = MALLOC(TEX_SIZE * TEX_SIZE * 4);
+   if (texels == NULL)
+      exit(7);
+
+   for (t = 0; t < TEX_SIZE; t++) {
+      for (s = 0; s < TEX_SIZE; s++) {
+         ubyte *p = &texels[(t * TEX_SIZE + s) * 4];
+         p[0] = s;
+         p[1] = t;
+         p[2] = ((s ^ t) & 8) ? 255 : 0;
+         p[3] = 255;
+      }
+   }
+
+   memset(&templat, 0, sizeof templat);
+   templat.target = PIPE_TEXTURE_2D;
+   templat.format = PIPE_FORMAT_B8G8R8A8_UNORM;
+   templat.width0 = TEX_SIZE;
+   templat.height0 = TEX_SIZE;
+   templat.depth0 = 1;
+   templat.array_size = 1;
+   templat.last_level = 0;
+   templat.nr_samples = 1;
+   templat.bind = PIPE_BIND_SAMPLER_VIEW;
+
+   samptex = screen->resource_create(screen, &templat);
+   if (samptex == NULL)
+      exit(7);
+
+   u_box_2d(0, 0, TEX_SIZE, TEX_SIZE, &box);
+   ctx->transfer_inline_write(ctx, samptex, 0, PIPE_TRANSFER_WRITE, &box,
+                              texels, TEX_SIZE * 4, TEX_SIZE * TEX_SIZE * 4);
+   FREE(texels);
+
+   memset(&sv_template, 0, sizeof sv_template);
+   sv_template.format = samptex->format;
+   sv_template.texture = samptex;
+   sv_template.swizzle_r = 0;
+   sv_template.swizzle_g = 1;
+   sv_template.swizzle_b = 2;
+   sv_template.swizzle_a = 3;
+   sv = ctx->create_sampler_view(ctx, samptex, &sv_template);
+   if (sv == NULL)
+      exit(7);
+
+   ctx->set_fragment_sampler_views(ctx, 1, &sv);
+
+   sampler_nearest = create_sampler(PIPE_TEX_FILTER_NEAREST);
+   sampler_linear = create_sampler(PIPE_TEX_FILTER_LINEAR);
+   ctx->bind_fragment_sampler_states(ctx, 1, &sampler_nearest);
+}
+
+static struct pipe_surface *create_target( enum pipe_format format,
+                                           unsigned bind,
+                                           struct pipe_resource **tex )
+{
+   struct pipe_resource templat;
+   struct pipe_surface surf_tmpl;
+
+   memset(&templat, 0, sizeof templat);
+   templat.target = PIPE_TEXTURE_2D;
+   templat.format = format;
+   templat.width0 = WIDTH;
+   templat.height0 = HEIGHT;
+   templat.depth0 = 1;
+   templat.array_size = 1;
+   templat.last_level = 0;
+   templat.nr_samples = 1;
+   templat.bind = bind;
+
+   *tex = screen->resource_create(screen, &templat);
+   if (*tex == NULL) {
+      fprintf(stderr, "Unable to create render target!\n");
+      exit(4);
+   }
+
+   memset(&surf_tmpl, 0, sizeof surf_tmpl);
+   surf_tmpl.format = format;
+   surf_tmpl.usage = bind;
+   surf_tmpl.u.tex.level = 0;
+   surf_tmpl.u.tex.first_layer = 0;
+   surf_tmpl.u.tex.last_layer = 0;
+
+   return ctx->create_surface(ctx, *tex, &surf_tmpl);
+}
+
+static void init( void )
+{
+   struct pipe_framebuffer_state fb;
+   struct pipe_viewport_state vp;
+   void *handle;
+
+   screen = graw_create_window_and_screen(0, 0, WIDTH, HEIGHT,
+                                          PIPE_FORMAT_R8G8B8A8_UNORM,
+                                          &window);
+   if (screen == NULL || window == NULL) {
+      fprintf(stderr, "Unable to create screen!\n");
+      exit(2);
+   }
+
+   ctx = screen->context_create(screen, NULL);
+   if (ctx == NULL) {
+      fprintf(stderr, "Unable to create context!\n");
+      exit(3);
+   }
+
+   /* Render offscreen: no display target is needed for benchmarking. */
+   surf = create_target(PIPE_FORMAT_B8G8R8A8_UNORM,
+                        PIPE_BIND_RENDER_TARGET, &rttex);
+   zsurf = create_target(PIPE_FORMAT_Z24_UNORM_S8_USCALED,
+                         PIPE_BIND_DEPTH_STENCIL, &zstex);
+   if (surf == NULL || zsurf == NULL) {
+      fprintf(stderr, "Unable to create surfaces!\n");
+      exit(5);
+   }
+
+   memset(&fb, 0, sizeof fb);
+   fb.nr_cbufs = 1;
+   fb.width = WIDTH;
+   fb.height = HEIGHT;
+   fb.cbufs[0] = surf;
+   fb.zsbuf = zsurf;
+   ctx->set_framebuffer_state(ctx, &fb);
+
+   {
+      struct pipe_depth_stencil_alpha_state depthstencil;
+      memset(&depthstencil, 0, sizeof depthstencil);
+      dsa_none = ctx->create_depth_stencil_alpha_state(ctx, &depthstencil);
+      ctx->bind_depth_stencil_alpha_state(ctx, dsa_none);
+
+      depthstencil.depth.enabled = 1;
+      depthstencil.depth.writemask = 1;
+      depthstencil.depth.func = PIPE_FUNC_LEQUAL;
+      dsa_lequal = ctx->create_depth_stencil_alpha_state(ctx, &depthstencil);
+   }
+
+   {
+      struct pipe_rasterizer_state rasterizer;
+      memset(&rasterizer, 0, sizeof rasterizer);
+      rasterizer.cull_face = PIPE_FACE_NONE;
+      rasterizer.gl_rasterization_rules = 1;
+      handle = ctx->create_rasterizer_state(ctx, &rasterizer);
+      ctx->bind_rasterizer_state(ctx, handle);
+   }
+
+   vp.scale[0] = WIDTH / 2.0f;
+   vp.scale[1] = HEIGHT / 2.0f;
+   vp.scale[2] = 0.5f;
+   vp.scale[3] = 1.0f;
+   vp.translate[0] = WIDTH / 2.0f;
+   vp.translate[1] = HEIGHT / 2.0f;
+   vp.translate[2] = 0.5f;
+   vp.translate[3] = 0.0f;
+   ctx->set_viewport_state(ctx, &vp);
+
+   handle = graw_parse_vertex_shader(ctx,
+      "VERT\n"
+      "DCL IN[0]\n"
+      "DCL IN[1]\n"
+      "DCL OUT[0], POSITION\n"
+      "DCL OUT[1], GENERIC[0]\n"
+      "  0: MOV OUT[1], IN[1]\n"
+      "  1: MOV OUT[0], IN[0]\n"
+      "  2: END\n");
+   ctx->bind_vs_state(ctx, handle);
+
+   fs_color = graw_parse_fragment_shader(ctx, fs_color_text);
+   fs_tex = graw_parse_fragment_shader(ctx, fs_tex_text);
+
+   blend_none = create_blend(FALSE, PIPE_BLENDFACTOR_ONE,
+                             PIPE_BLENDFACTOR_ZERO);
+   blend_alpha = create_blend(TRUE, PIPE_BLENDFACTOR_SRC_ALPHA,
+                              PIPE_BLENDFACTOR_INV_SRC_ALPHA);
+   blend_add = create_blend(TRUE, PIPE_BLENDFACTOR_ONE,
+                            PIPE_BLENDFACTOR_ONE);
+
+   init_vertices();
+   init_texture();
+}
+
+static void args(int argc, char *argv[])
+{
+   int i;
+
+   for (i = 1; i < argc;) {
+      if (graw_parse_args(&i, argc, argv)) {
+         continue;
+      }
+      if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+         only_test = argv[i + 1];
+         i += 2;
+         continue;
+      }
+      if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+         min_usecs = (int64_t)(atof(argv[i + 1]) * 1000000.0);
+         i += 2;
+         continue;
+      }
+      fprintf(stderr, "usage: %s [-t test] [-s seconds] [-o file]\n",
+              argv[0]);
+      exit(1);
+   }
+}
+
+int main( int argc, char *argv[] )
+{
+   args(argc, argv);
+   init();
+
+   bench_all();
+
+   graw_save_surface_to_file(ctx, surf, NULL);
+   return 0;
+}
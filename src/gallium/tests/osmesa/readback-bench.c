@@ -0,0 +1,166 @@
+/*
+ * glGetTexImage throughput benchmark for the gallium OSMesa.
+ *
+ * Reads back textures of a few internal formats as a few format/type
+ * pairs, through the state tracker's st_get_tex_image().  Sizes below
+ * and above the threaded conversion cutoff are timed.  Results are
+ * printed one JSON object per line, like graw/bench.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "GL/osmesa.h"
+#include "GL/glext.h"
+
+
+#define WIDTH 16
+#define HEIGHT 16
+#define MAX_SIZE 1024
+
+
+struct readback_case
+{
+   const char *name;
+   GLenum internal_format;
+   GLenum format;
+   GLenum type;
+   unsigned cpp;   /* bytes per pixel read back */
+};
+
+
+static const struct readback_case cases[] = {
+   { "rgba8_rgba_ub", GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4 },
+   { "rgba8_bgra_ub", GL_RGBA8, GL_BGRA, GL_UNSIGNED_BYTE, 4 },
+   { "rgba8_rgb_ub", GL_RGBA8, GL_RGB, GL_UNSIGNED_BYTE, 3 },
+   { "rgba8_rgba_8888_rev", GL_RGBA8, GL_RGBA,
+     GL_UNSIGNED_INT_8_8_8_8_REV, 4 },
+   { "rgba8_rgba_float", GL_RGBA8, GL_RGBA, GL_FLOAT, 16 },
+   { "rgb565_rgb_565", GL_RGB5, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, 2 },
+   { "rgba16_rgba_us", GL_RGBA16, GL_RGBA, GL_UNSIGNED_SHORT, 8 },
+   { "l8_l_ub", GL_LUMINANCE8, GL_LUMINANCE, GL_UNSIGNED_BYTE, 1 },
+};
+
+static const unsigned sizes[] = { 256, MAX_SIZE };
+
+
+static double seconds = 1.0;
+static const char *only = NULL;
+
+
+static double
+now(void)
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+
+static void
+report(const char *test, double value, const char *unit, unsigned iterations)
+{
+   printf("{\"test\": \"%s\", \"driver\": \"osmesa\", \"value\": %.3f, "
+          "\"unit\": \"%s\", \"iterations\": %u}\n",
+          test, value, unit, iterations);
+   fflush(stdout);
+}
+
+
+static void
+bench_readback(const struct readback_case *c, unsigned size,
+               const GLubyte *texels, void *pixels)
+{
+   char test[64];
+   unsigned n = 0;
+   double t0, t1;
+
+   snprintf(test, sizeof test, "readback_%s_%u", c->name, size);
+   if (only && strcmp(only, test) != 0)
+      return;
+
+   glTexImage2D(GL_TEXTURE_2D, 0, c->internal_format, size, size, 0,
+                GL_RGBA, GL_UNSIGNED_BYTE, texels);
+
+   /* the first readback maps the texture in */
+   glGetTexImage(GL_TEXTURE_2D, 0, c->format, c->type, pixels);
+
+   t0 = now();
+   do {
+      glGetTexImage(GL_TEXTURE_2D, 0, c->format, c->type, pixels);
+      n++;
+      t1 = now();
+   } while (t1 - t0 < seconds);
+
+   report(test, (double)n * size * size * c->cpp / (t1 - t0) * 1e-6,
+          "MB/s", n);
+}
+
+
+static void
+args(int argc, char *argv[])
+{
+   int i;
+
+   for (i = 1; i < argc;) {
+      if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+         seconds = atof(argv[i + 1]);
+         i += 2;
+         continue;
+      }
+      if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+         only = argv[i + 1];
+         i += 2;
+         continue;
+      }
+      fprintf(stderr, "usage: %s [-s seconds] [-t test]\n", argv[0]);
+      exit(1);
+   }
+}
+
+
+int
+main(int argc, char *argv[])
+{
+   static GLubyte buffer[WIDTH * HEIGHT * 4];
+   OSMesaContext ctx;
+   GLubyte *texels;
+   void *pixels;
+   GLuint tex;
+   unsigned i, j;
+
+   args(argc, argv);
+
+   ctx = OSMesaCreateContextExt(OSMESA_RGBA, 0, 0, 0, NULL);
+   if (!ctx ||
+       !OSMesaMakeCurrent(ctx, buffer, GL_UNSIGNED_BYTE, WIDTH, HEIGHT)) {
+      fprintf(stderr, "failed to create the context\n");
+      return 1;
+   }
+
+   texels = malloc(MAX_SIZE * MAX_SIZE * 4);
+   pixels = malloc(MAX_SIZE * MAX_SIZE * 16);
+   if (!texels || !pixels)
+      return 1;
+   for (i = 0; i < MAX_SIZE * MAX_SIZE * 4; i++)
+      texels[i] = (GLubyte) (i * 7 + (i >> 12));
+
+   glPixelStorei(GL_PACK_ALIGNMENT, 1);
+   glGenTextures(1, &tex);
+   glBindTexture(GL_TEXTURE_2D, tex);
+
+   for (i = 0; i < sizeof cases / sizeof cases[0]; i++)
+      for (j = 0; j < sizeof sizes / sizeof sizes[0]; j++)
+         bench_readback(&cases[i], sizes[j], texels, pixels);
+
+   glDeleteTextures(1, &tex);
+   free(texels);
+   free(pixels);
+   OSMesaMakeCurrent(NULL, NULL, 0, 0, 0);
+   OSMesaDestroyContext(ctx);
+
+   return 0;
+}
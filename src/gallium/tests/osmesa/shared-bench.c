@@ -0,0 +1,220 @@
+/*
+ * Multi-context scaling benchmark for the gallium OSMesa.
+ *
+ * Creates one context per thread, all sharing the texture and buffer
+ * objects of a first context, and has every thread bind those objects
+ * as fast as it can.  This exercises the shared hash tables and object
+ * reference counts.  Results are printed one JSON object per line, like
+ * graw/bench.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "GL/osmesa.h"
+#include "GL/glext.h"
+
+
+#define MAX_THREADS 16
+#define NUM_OBJECTS 64
+#define WIDTH 16
+#define HEIGHT 16
+
+
+struct thread_info
+{
+   pthread_t thread;
+   OSMesaContext ctx;
+   GLubyte buffer[WIDTH * HEIGHT * 4];
+   unsigned long binds;
+};
+
+
+static GLuint textures[NUM_OBJECTS];
+static GLuint buffers[NUM_OBJECTS];
+
+static pthread_mutex_t start_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t start_cond = PTHREAD_COND_INITIALIZER;
+static int started;
+static volatile int stop;
+
+static double seconds = 1.0;
+static unsigned max_threads = MAX_THREADS;
+
+
+static double
+now(void)
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+
+static void *
+bind_thread(void *data)
+{
+   struct thread_info *info = (struct thread_info *) data;
+   unsigned long binds = 0;
+   unsigned i;
+
+   if (!OSMesaMakeCurrent(info->ctx, info->buffer, GL_UNSIGNED_BYTE,
+                          WIDTH, HEIGHT)) {
+      fprintf(stderr, "OSMesaMakeCurrent failed\n");
+      exit(1);
+   }
+
+   pthread_mutex_lock(&start_mutex);
+   while (!started)
+      pthread_cond_wait(&start_cond, &start_mutex);
+   pthread_mutex_unlock(&start_mutex);
+
+   while (!stop) {
+      for (i = 0; i < NUM_OBJECTS; i++) {
+         glBindTexture(GL_TEXTURE_2D, textures[i]);
+         glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+      }
+      binds += 2 * NUM_OBJECTS;
+   }
+
+   glBindTexture(GL_TEXTURE_2D, 0);
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+   glFinish();
+   OSMesaMakeCurrent(NULL, NULL, 0, 0, 0);
+
+   info->binds = binds;
+   return NULL;
+}
+
+
+static void
+report(const char *test, double value, const char *unit, unsigned threads)
+{
+   printf("{\"test\": \"%s\", \"driver\": \"osmesa\", \"value\": %.3f, "
+          "\"unit\": \"%s\", \"threads\": %u}\n",
+          test, value, unit, threads);
+   fflush(stdout);
+}
+
+
+static void
+bench_threads(OSMesaContext share, unsigned nr_threads)
+{
+   struct thread_info *info;
+   unsigned long binds = 0;
+   double t0, t1;
+   unsigned i;
+
+   info = calloc(nr_threads, sizeof *info);
+   if (!info)
+      exit(1);
+
+   for (i = 0; i < nr_threads; i++) {
+      info[i].ctx = OSMesaCreateContextExt(OSMESA_RGBA, 0, 0, 0, share);
+      if (!info[i].ctx) {
+         fprintf(stderr, "OSMesaCreateContextExt failed\n");
+         exit(1);
+      }
+   }
+
+   started = 0;
+   stop = 0;
+   for (i = 0; i < nr_threads; i++)
+      pthread_create(&info[i].thread, NULL, bind_thread, &info[i]);
+
+   pthread_mutex_lock(&start_mutex);
+   started = 1;
+   pthread_cond_broadcast(&start_cond);
+   pthread_mutex_unlock(&start_mutex);
+
+   t0 = now();
+   do {
+      usleep(10000);
+      t1 = now();
+   } while (t1 - t0 < seconds);
+   stop = 1;
+
+   for (i = 0; i < nr_threads; i++) {
+      pthread_join(info[i].thread, NULL);
+      binds += info[i].binds;
+      OSMesaDestroyContext(info[i].ctx);
+   }
+   t1 = now();
+
+   report("shared_binds", binds / (t1 - t0) * 1e-6, "Mbinds/s", nr_threads);
+   report("shared_binds_per_thread",
+          binds / (t1 - t0) * 1e-6 / nr_threads, "Mbinds/s", nr_threads);
+
+   free(info);
+}
+
+
+static void
+args(int argc, char *argv[])
+{
+   int i;
+
+   for (i = 1; i < argc;) {
+      if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+         seconds = atof(argv[i + 1]);
+         i += 2;
+         continue;
+      }
+      if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+         max_threads = atoi(argv[i + 1]);
+         if (max_threads < 1)
+            max_threads = 1;
+         i += 2;
+         continue;
+      }
+      fprintf(stderr, "usage: %s [-s seconds] [-t max_threads]\n", argv[0]);
+      exit(1);
+   }
+}
+
+
+int
+main(int argc, char *argv[])
+{
+   static GLubyte buffer[WIDTH * HEIGHT * 4];
+   static const GLubyte texel[4 * 4 * 4];
+   OSMesaContext ctx;
+   unsigned nr_threads, i;
+
+   args(argc, argv);
+
+   ctx = OSMesaCreateContextExt(OSMESA_RGBA, 0, 0, 0, NULL);
+   if (!ctx ||
+       !OSMesaMakeCurrent(ctx, buffer, GL_UNSIGNED_BYTE, WIDTH, HEIGHT)) {
+      fprintf(stderr, "failed to create the sharing context\n");
+      return 1;
+   }
+
+   glGenTextures(NUM_OBJECTS, textures);
+   glGenBuffers(NUM_OBJECTS, buffers);
+   for (i = 0; i < NUM_OBJECTS; i++) {
+      glBindTexture(GL_TEXTURE_2D, textures[i]);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 4, 4, 0,
+                   GL_RGBA, GL_UNSIGNED_BYTE, texel);
+      glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+      glBufferData(GL_ARRAY_BUFFER, 64, NULL, GL_STATIC_DRAW);
+   }
+   glBindTexture(GL_TEXTURE_2D, 0);
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+   glFinish();
+
+   for (nr_threads = 1; nr_threads <= max_threads; nr_threads *= 2)
+      bench_threads(ctx, nr_threads);
+
+   glDeleteTextures(NUM_OBJECTS, textures);
+   glDeleteBuffers(NUM_OBJECTS, buffers);
+   OSMesaMakeCurrent(NULL, NULL, 0, 0, 0);
+   OSMesaDestroyContext(ctx);
+
+   return 0;
+}
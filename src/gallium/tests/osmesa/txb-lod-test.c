@@ -0,0 +1,191 @@
+/*
+ * Per-fragment LOD bias test.
+ *
+ * Draws a 64x64 texture 1:1 with an ARB fragment program whose TXB bias
+ * is a sawtooth in x, so lambda goes up and down along every span and
+ * crosses the min/mag threshold several times.  The bias steps every two
+ * columns, so drivers which use one LOD per 2x2 quad give the same
+ * result.  The texture is minified
+ * with GL_LINEAR_MIPMAP_LINEAR and magnified with GL_NEAREST, and each
+ * mipmap level is a solid color, so every pixel shows which filter and
+ * levels it was sampled with.  Pixels are checked against the expected
+ * colors, and the test exits non-zero if any are wrong.
+ *
+ * Only uses the OSMesa API, so it runs against the classic (swrast)
+ * libOSMesa too, e.g. with LD_LIBRARY_PATH=$(TOP)/lib.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "GL/osmesa.h"
+#include "GL/glext.h"
+
+
+#define SIZE 64
+#define LEVELS 7
+
+/* colors differ enough that a 1/8 blend step is seen */
+#define TOLERANCE 24
+
+/* skip pixels this close to a level boundary, where LOG2 error decides */
+#define LAMBDA_EPSILON 0.15f
+
+
+static const GLubyte level_colors[LEVELS][4] = {
+   { 255,   0,   0, 255 },
+   {   0, 255,   0, 255 },
+   {   0,   0, 255, 255 },
+   { 255, 255,   0, 255 },
+   {   0, 255, 255, 255 },
+   { 255,   0, 255, 255 },
+   { 255, 255, 255, 255 },
+};
+
+static const char program[] =
+   "!!ARBfp1.0\n"
+   "TEMP t;\n"
+   "MOV t, fragment.texcoord[0];\n"
+   "MUL t.w, fragment.position.x, 0.5;\n"
+   "FLR t.w, t.w;\n"
+   "MUL t.w, t.w, 0.37;\n"
+   "FRC t.w, t.w;\n"
+   "MAD t.w, t.w, 3.0, -1.0;\n"
+   "TXB result.color, t, texture[0], 2D;\n"
+   "END\n";
+
+
+/* the same bias as the fragment program, at window x */
+static float
+bias(unsigned x)
+{
+   float w = (x / 2) * 0.37f;
+   w = w - floorf(w);
+   return w * 3.0f - 1.0f;
+}
+
+
+static void
+expected_color(float lambda, float rgba[4])
+{
+   unsigned c;
+
+   if (lambda <= 0.0f) {
+      /* GL_NEAREST magnification of level 0 */
+      for (c = 0; c < 4; c++)
+         rgba[c] = level_colors[0][c];
+   }
+   else {
+      /* GL_LINEAR_MIPMAP_LINEAR */
+      const unsigned level = (unsigned) lambda;
+      const float f = lambda - level;
+
+      for (c = 0; c < 4; c++) {
+         if (level + 1 < LEVELS)
+            rgba[c] = level_colors[level][c] * (1.0f - f) +
+                      level_colors[level + 1][c] * f;
+         else
+            rgba[c] = level_colors[LEVELS - 1][c];
+      }
+   }
+}
+
+
+static void
+make_texture(void)
+{
+   static GLubyte texels[SIZE * SIZE * 4];
+   unsigned level, size, i;
+
+   for (level = 0, size = SIZE; level < LEVELS; level++, size /= 2) {
+      for (i = 0; i < size * size; i++) {
+         texels[i * 4 + 0] = level_colors[level][0];
+         texels[i * 4 + 1] = level_colors[level][1];
+         texels[i * 4 + 2] = level_colors[level][2];
+         texels[i * 4 + 3] = level_colors[level][3];
+      }
+      glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, size, size, 0,
+                   GL_RGBA, GL_UNSIGNED_BYTE, texels);
+   }
+
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                   GL_LINEAR_MIPMAP_LINEAR);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+
+int
+main(void)
+{
+   static GLubyte buffer[SIZE * SIZE * 4];
+   OSMesaContext ctx;
+   GLuint prog, tex;
+   unsigned x, y, c, errors = 0, checked = 0;
+
+   ctx = OSMesaCreateContextExt(OSMESA_RGBA, 0, 0, 0, NULL);
+   if (!ctx ||
+       !OSMesaMakeCurrent(ctx, buffer, GL_UNSIGNED_BYTE, SIZE, SIZE)) {
+      fprintf(stderr, "failed to create the context\n");
+      return 1;
+   }
+
+   glGenTextures(1, &tex);
+   glBindTexture(GL_TEXTURE_2D, tex);
+   make_texture();
+
+   glGenProgramsARB(1, &prog);
+   glBindProgramARB(GL_FRAGMENT_PROGRAM_ARB, prog);
+   glProgramStringARB(GL_FRAGMENT_PROGRAM_ARB, GL_PROGRAM_FORMAT_ASCII_ARB,
+                      sizeof program - 1, program);
+   if (glGetError() != GL_NO_ERROR) {
+      fprintf(stderr, "failed to compile the fragment program\n");
+      return 1;
+   }
+   glEnable(GL_FRAGMENT_PROGRAM_ARB);
+
+   glViewport(0, 0, SIZE, SIZE);
+   glBegin(GL_QUADS);
+   glTexCoord2f(0, 0); glVertex2f(-1, -1);
+   glTexCoord2f(1, 0); glVertex2f( 1, -1);
+   glTexCoord2f(1, 1); glVertex2f( 1,  1);
+   glTexCoord2f(0, 1); glVertex2f(-1,  1);
+   glEnd();
+   glFinish();
+
+   for (x = 0; x < SIZE; x++) {
+      const float lambda = bias(x);
+      float rgba[4];
+
+      if (fabsf(lambda - floorf(lambda + 0.5f)) < LAMBDA_EPSILON)
+         continue;
+
+      expected_color(lambda, rgba);
+      for (y = 0; y < SIZE; y++) {
+         const GLubyte *p = buffer + (y * SIZE + x) * 4;
+
+         for (c = 0; c < 4; c++) {
+            if (fabsf(p[c] - rgba[c]) > TOLERANCE) {
+               if (errors < 10)
+                  printf("pixel %u,%u lambda %.2f: got %u %u %u %u, "
+                         "expected %.0f %.0f %.0f %.0f\n",
+                         x, y, lambda, p[0], p[1], p[2], p[3],
+                         rgba[0], rgba[1], rgba[2], rgba[3]);
+               errors++;
+               break;
+            }
+         }
+         checked++;
+      }
+   }
+
+   printf("%u of %u pixels wrong\n", errors, checked);
+
+   glDeleteProgramsARB(1, &prog);
+   glDeleteTextures(1, &tex);
+   OSMesaMakeCurrent(NULL, NULL, 0, 0, 0);
+   OSMesaDestroyContext(ctx);
+
+   return errors != 0;
+}
@@ -0,0 +1,220 @@
+#!/usr/bin/env python
+##########################################################################
+#
+# Copyright 2010 VMware, Inc.
+# All Rights Reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the
+# "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sub license, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# The above copyright notice and this permission notice (including the
+# next paragraph) shall be included in all copies or substantial portions
+# of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+# IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+# TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+# SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+##########################################################################
+
+
+'''Replay a trace for performance measurement.
+
+The whole trace is parsed, and every argument which does not reference
+a live object is translated, before replay starts, so the timed loop
+only does the pipe calls themselves.  Frames are delimited by flushes
+with PIPE_FLUSH_FRAME.  The trace is replayed several times and the
+fastest time of each frame is kept.
+
+Results are written as JSON and can be compared against a baseline
+file from a previous run; the exit status is non-zero when the total
+time regresses by more than the given tolerance.
+'''
+
+
+import sys
+import time
+
+try:
+    import json
+except ImportError:
+    import simplejson as json
+
+import gallium
+import model
+import interpreter
+
+
+class PointerFinder(model.Visitor):
+    '''Find out whether a node references any object.'''
+
+    def __init__(self):
+        self.found = False
+
+    def visit_literal(self, node):
+        pass
+
+    def visit_named_constant(self, node):
+        pass
+
+    def visit_array(self, node):
+        for element in node.elements:
+            element.visit(self)
+
+    def visit_struct(self, node):
+        for member_name, member_node in node.members:
+            member_node.visit(self)
+
+    def visit_pointer(self, node):
+        self.found = True
+
+
+def has_pointers(node):
+    finder = PointerFinder()
+    node.visit(finder)
+    return finder.found
+
+
+class Benchmark(interpreter.Interpreter):
+
+    def __init__(self, stream, options):
+        interpreter.Interpreter.__init__(self, stream, options)
+        self.calls = []
+
+    def handle_call(self, call):
+        # Only record the call while parsing; see replay().
+        if self.options.stop and call.no > self.options.stop:
+            return
+
+        if (call.klass, call.method) in self.ignore_calls:
+            return
+
+        args = []
+        for name, arg in call.args:
+            if has_pointers(arg):
+                args.append((str(name), True, arg))
+            else:
+                args.append((str(name), False, self.interpret_arg(arg)))
+        self.calls.append((call, args))
+
+    def present(self, ctx, surface, description, x=None, y=None, w=None, h=None):
+        pass
+
+    def replay(self):
+        '''Replay all recorded calls, returning the duration of each frame
+        in milliseconds.'''
+
+        self.objects = {}
+        frames = []
+        start = time.time()
+        for call, args in self.calls:
+            self.call_no = call.no
+
+            kwargs = {}
+            obj = self.globl
+            for name, lazy, value in args:
+                if lazy:
+                    value = self.interpret_arg(value)
+                if call.klass and obj is self.globl:
+                    obj = value
+                else:
+                    kwargs[name] = value
+
+            ret = getattr(obj, call.method)(**kwargs)
+
+            if call.ret and isinstance(call.ret, model.Pointer):
+                self.register_object(call.ret.address, ret)
+
+            if call.method == 'flush' and \
+               kwargs.get('flags', 0) & gallium.PIPE_FLUSH_FRAME:
+                end = time.time()
+                frames.append((end - start) * 1000.0)
+                start = end
+
+        self.call_no = None
+        return frames
+
+
+def compare(result, baseline, tolerance):
+    '''Print the differences against the baseline and return whether the
+    total time is within tolerance.'''
+
+    ok = True
+
+    total = result['total_ms']
+    base_total = baseline['total_ms']
+    sys.stdout.write('total: %.3f ms (baseline %.3f ms, %+.1f%%)\n' % (
+        total, base_total, (total - base_total) * 100.0 / base_total))
+    if total > base_total * (1.0 + tolerance):
+        ok = False
+
+    frames = result['frames_ms']
+    base_frames = baseline['frames_ms']
+    if len(frames) != len(base_frames):
+        sys.stdout.write('warning: %u frames, baseline has %u\n' % (
+            len(frames), len(base_frames)))
+    for i in range(min(len(frames), len(base_frames))):
+        if frames[i] > base_frames[i] * (1.0 + tolerance):
+            sys.stdout.write('frame %u: %.3f ms (baseline %.3f ms)\n' % (
+                i, frames[i], base_frames[i]))
+
+    return ok
+
+
+class Main(interpreter.Main):
+
+    def get_optparser(self):
+        optparser = interpreter.Main.get_optparser(self)
+        optparser.set_defaults(verbosity=0)
+        optparser.add_option("-r", "--repeat", action="store", type="int", dest="repeat", default=3, help="number of replays")
+        optparser.add_option("-o", "--output", action="store", type="string", dest="output", default=None, help="write results to JSON file")
+        optparser.add_option("-b", "--baseline", action="store", type="string", dest="baseline", default=None, help="compare against baseline JSON file")
+        optparser.add_option("--tolerance", action="store", type="float", dest="tolerance", default=0.05, help="allowed slowdown against the baseline [default: %default]")
+        return optparser
+
+    def process_arg(self, stream, options):
+        benchmark = Benchmark(stream, options)
+        benchmark.parse()
+
+        best = None
+        for i in range(max(options.repeat, 1)):
+            frames = benchmark.replay()
+            if best is None:
+                best = frames
+            else:
+                best = map(min, best, frames)
+
+        result = {
+            'trace': getattr(stream, 'name', None),
+            'calls': len(benchmark.calls),
+            'repeat': options.repeat,
+            'frames_ms': best,
+            'total_ms': sum(best),
+        }
+
+        sys.stdout.write('%u frames, %.3f ms total\n' % (len(best), result['total_ms']))
+
+        if options.output:
+            f = open(options.output, 'wt')
+            json.dump(result, f, indent=2)
+            f.close()
+
+        if options.baseline:
+            f = open(options.baseline, 'rt')
+            baseline = json.load(f)
+            f.close()
+            if not compare(result, baseline, options.tolerance):
+                sys.exit(1)
+
+
+if __name__ == '__main__':
+    Main().main()
@@ -0,0 +1,262 @@
+/**************************************************************************
+ * 
+ * Copyright 2011 VMware, Inc.
+ * All Rights Reserved.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE 
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ * 
+ **************************************************************************/
+
+
+/**
+ * @file
+ * Software rasterizer winsys for OSMesa.
+ *
+ * Display targets normally live in the memory the application passed to
+ * OSMesaMakeCurrent(), so the rasterizer draws straight into it and
+ * presenting is a no-op.  Only when that memory does not satisfy the
+ * alignment the driver asks for is a private shadow image allocated, which
+ * is then copied out on every present.
+ */
+
+
+#include "pipe/p_format.h"
+#include "util/u_format.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "util/u_rect.h"
+#include "state_tracker/sw_winsys.h"
+#include "state_tracker/osmesa_sw_winsys.h"
+
+
+struct osmesa_sw_displaytarget
+{
+   enum pipe_format format;
+   unsigned width;
+   unsigned height;
+   unsigned stride;
+
+   /** The image the driver renders to */
+   void *data;
+   boolean in_place;   /**< data is application memory */
+
+   /** Application memory to copy data to on present, if data is a shadow */
+   void *user_data;
+   unsigned user_stride;
+};
+
+
+struct osmesa_sw_winsys
+{
+   struct sw_winsys base;
+
+   /** Memory to use for the next display target */
+   void *user_data;
+   unsigned user_stride;
+};
+
+
+/** Cast wrapper */
+static INLINE struct osmesa_sw_displaytarget *
+osmesa_sw_displaytarget( struct sw_displaytarget *dt )
+{
+   return (struct osmesa_sw_displaytarget *)dt;
+}
+
+
+static INLINE struct osmesa_sw_winsys *
+osmesa_sw_winsys( struct sw_winsys *ws )
+{
+   return (struct osmesa_sw_winsys *)ws;
+}
+
+
+static boolean
+osmesa_sw_is_displaytarget_format_supported( struct sw_winsys *ws,
+                                             unsigned tex_usage,
+                                             enum pipe_format format )
+{
+   /* The application chooses the memory layout, so anything goes */
+   return TRUE;
+}
+
+
+static void *
+osmesa_sw_displaytarget_map(struct sw_winsys *ws,
+                            struct sw_displaytarget *dt,
+                            unsigned flags )
+{
+   struct osmesa_sw_displaytarget *osdt = osmesa_sw_displaytarget(dt);
+   return osdt->data;
+}
+
+
+static void
+osmesa_sw_displaytarget_unmap(struct sw_winsys *ws,
+                              struct sw_displaytarget *dt )
+{
+}
+
+
+static void
+osmesa_sw_displaytarget_destroy(struct sw_winsys *winsys,
+                                struct sw_displaytarget *dt)
+{
+   struct osmesa_sw_displaytarget *osdt = osmesa_sw_displaytarget(dt);
+
+   if (!osdt->in_place)
+      align_free(osdt->data);
+
+   FREE(osdt);
+}
+
+
+static struct sw_displaytarget *
+osmesa_sw_displaytarget_create(struct sw_winsys *winsys,
+                               unsigned tex_usage,
+                               enum pipe_format format,
+                               unsigned width, unsigned height,
+                               unsigned alignment,
+                               unsigned *stride)
+{
+   struct osmesa_sw_winsys *osws = osmesa_sw_winsys(winsys);
+   struct osmesa_sw_displaytarget *osdt;
+   void *user_data = osws->user_data;
+   unsigned user_stride = osws->user_stride;
+   unsigned nblocksy = util_format_get_nblocksy(format, height);
+
+   /* The memory is for this display target only */
+   osws->user_data = NULL;
+   osws->user_stride = 0;
+
+   osdt = CALLOC_STRUCT(osmesa_sw_displaytarget);
+   if (!osdt)
+      return NULL;
+
+   osdt->format = format;
+   osdt->width = width;
+   osdt->height = height;
+
+   if (user_data &&
+       user_stride >= util_format_get_stride(format, width) &&
+       ((uintptr_t) user_data % alignment) == 0 &&
+       (user_stride % alignment) == 0) {
+      /* render in place */
+      osdt->data = user_data;
+      osdt->stride = user_stride;
+      osdt->in_place = TRUE;
+   }
+   else {
+      osdt->stride = align(util_format_get_stride(format, width), alignment);
+      osdt->data = align_malloc(osdt->stride * nblocksy, alignment);
+      if (!osdt->data) {
+         FREE(osdt);
+         return NULL;
+      }
+
+      if (user_data) {
+         /* Start from the current contents, as rendering in place would */
+         osdt->user_data = user_data;
+         osdt->user_stride = user_stride;
+         util_copy_rect(osdt->data, format, osdt->stride, 0, 0,
+                        width, height, user_data, user_stride, 0, 0);
+      }
+   }
+
+   *stride = osdt->stride;
+   return (struct sw_displaytarget *)osdt;
+}
+
+
+static struct sw_displaytarget *
+osmesa_sw_displaytarget_from_handle(struct sw_winsys *winsys,
+                                    const struct pipe_resource *templet,
+                                    struct winsys_handle *whandle,
+                                    unsigned *stride)
+{
+   return NULL;
+}
+
+
+static boolean
+osmesa_sw_displaytarget_get_handle(struct sw_winsys *winsys,
+                                   struct sw_displaytarget *dt,
+                                   struct winsys_handle *whandle)
+{
+   assert(0);
+   return FALSE;
+}
+
+
+static void
+osmesa_sw_displaytarget_display(struct sw_winsys *winsys,
+                                struct sw_displaytarget *dt,
+                                void *context_private)
+{
+   struct osmesa_sw_displaytarget *osdt = osmesa_sw_displaytarget(dt);
+
+   if (osdt->user_data) {
+      util_copy_rect(osdt->user_data, osdt->format, osdt->user_stride, 0, 0,
+                     osdt->width, osdt->height,
+                     osdt->data, osdt->stride, 0, 0);
+   }
+}
+
+
+static void
+osmesa_sw_destroy(struct sw_winsys *winsys)
+{
+   FREE(winsys);
+}
+
+
+void
+osmesa_sw_winsys_set_user_memory(struct sw_winsys *winsys,
+                                 void *data, unsigned stride)
+{
+   struct osmesa_sw_winsys *osws = osmesa_sw_winsys(winsys);
+
+   osws->user_data = data;
+   osws->user_stride = stride;
+}
+
+
+struct sw_winsys *
+osmesa_create_sw_winsys(void)
+{
+   struct osmesa_sw_winsys *osws;
+
+   osws = CALLOC_STRUCT(osmesa_sw_winsys);
+   if (!osws)
+      return NULL;
+
+   osws->base.destroy = osmesa_sw_destroy;
+   osws->base.is_displaytarget_format_supported = osmesa_sw_is_displaytarget_format_supported;
+   osws->base.displaytarget_create = osmesa_sw_displaytarget_create;
+   osws->base.displaytarget_from_handle = osmesa_sw_displaytarget_from_handle;
+   osws->base.displaytarget_get_handle = osmesa_sw_displaytarget_get_handle;
+   osws->base.displaytarget_map = osmesa_sw_displaytarget_map;
+   osws->base.displaytarget_unmap = osmesa_sw_displaytarget_unmap;
+   osws->base.displaytarget_display = osmesa_sw_displaytarget_display;
+   osws->base.displaytarget_destroy = osmesa_sw_displaytarget_destroy;
+
+   return &osws->base;
+}
@@ -76,6 +76,12 @@ struct xlib_displaytarget
 
    XShmSegmentInfo shminfo;
    Bool shm;  /** Using shared memory images? */
+
+   /* Serial number of the last XShmPutImage request reading from the
+    * shared memory segment, valid while put_pending is set.
+    */
+   unsigned long put_serial;
+   boolean put_pending;
 };
 
 
@@ -222,12 +228,40 @@ xlib_is_displaytarget_format_supported(struct sw_winsys *ws,
 }
 
 
+/**
+ * Wait for the X server to finish reading the shared memory segment
+ * before it is written to again.
+ *
+ * XShmPutImage() returns as soon as the request is queued, so the
+ * server may still be copying from the segment.  Instead of syncing
+ * after each put (which would stall the renderer until the copy is
+ * done), the wait is deferred to the next write mapping of the same
+ * display target.  With double buffering that is a frame later and the
+ * request has normally long been processed.
+ */
+static void
+xlib_displaytarget_wait_put(struct xlib_displaytarget *xlib_dt)
+{
+   if (!xlib_dt->put_pending)
+      return;
+
+   if (LastKnownRequestProcessed(xlib_dt->display) < xlib_dt->put_serial)
+      XSync(xlib_dt->display, False);
+
+   xlib_dt->put_pending = FALSE;
+}
+
+
 static void *
 xlib_displaytarget_map(struct sw_winsys *ws,
                        struct sw_displaytarget *dt,
                        unsigned flags)
 {
    struct xlib_displaytarget *xlib_dt = xlib_displaytarget(dt);
+
+   if (flags & PIPE_TRANSFER_WRITE)
+      xlib_displaytarget_wait_put(xlib_dt);
+
    xlib_dt->mapped = xlib_dt->data;
    return xlib_dt->mapped;
 }
@@ -281,9 +315,34 @@ xlib_displaytarget_destroy(struct sw_winsys *ws,
 }
 
 
+/**
+ * Clip a damage rectangle against the display target.
+ * \return FALSE if nothing is left
+ */
+static boolean
+clip_rect(const struct xlib_displaytarget *xlib_dt, const XRectangle *rect,
+          int *x, int *y, int *width, int *height)
+{
+   int x0 = MAX2(rect->x, 0);
+   int y0 = MAX2(rect->y, 0);
+   int x1 = MIN2(rect->x + rect->width, (int) xlib_dt->width);
+   int y1 = MIN2(rect->y + rect->height, (int) xlib_dt->height);
+
+   if (x0 >= x1 || y0 >= y1)
+      return FALSE;
+
+   *x = x0;
+   *y = y0;
+   *width = x1 - x0;
+   *height = y1 - y0;
+   return TRUE;
+}
+
+
 /**
  * Display/copy the image in the surface into the X window specified
- * by the display target.
+ * by the display target.  Only the damaged rectangles of the drawable
+ * are sent, if any are given.
  */
 static void
 xlib_sw_display(struct xlib_drawable *xlib_drawable,
@@ -294,6 +353,9 @@ xlib_sw_display(struct xlib_drawable *xlib_drawable,
    struct xlib_displaytarget *xlib_dt = xlib_displaytarget(dt);
    Display *display = xlib_dt->display;
    XImage *ximage;
+   XRectangle whole;
+   const XRectangle *rects;
+   int num_rects, i;
 
    if (firsttime) {
       no_swap = getenv("SP_NO_RAST") != NULL;
@@ -332,13 +394,34 @@ xlib_sw_display(struct xlib_drawable *xlib_drawable,
       XSetFunction(display, xlib_dt->gc, GXcopy);
    }
 
+   if (xlib_drawable->num_damage) {
+      rects = xlib_drawable->damage;
+      num_rects = xlib_drawable->num_damage;
+   }
+   else {
+      whole.x = 0;
+      whole.y = 0;
+      whole.width = xlib_dt->width;
+      whole.height = xlib_dt->height;
+      rects = &whole;
+      num_rects = 1;
+   }
+
    if (xlib_dt->shm) {
       ximage = xlib_dt->tempImage;
       ximage->data = xlib_dt->data;
 
       /* _debug_printf("XSHM\n"); */
-      XShmPutImage(xlib_dt->display, xlib_drawable->drawable, xlib_dt->gc,
-                   ximage, 0, 0, 0, 0, xlib_dt->width, xlib_dt->height, False);
+      for (i = 0; i < num_rects; i++) {
+         int x, y, w, h;
+
+         if (clip_rect(xlib_dt, &rects[i], &x, &y, &w, &h)) {
+            XShmPutImage(display, xlib_drawable->drawable, xlib_dt->gc,
+                         ximage, x, y, x, y, w, h, False);
+            xlib_dt->put_serial = NextRequest(display) - 1;
+            xlib_dt->put_pending = TRUE;
+         }
+      }
    }
    else {
       /* display image in Window */
@@ -355,8 +438,13 @@ xlib_sw_display(struct xlib_drawable *xlib_drawable,
       ximage->bytes_per_line = xlib_dt->stride;
 
       /* _debug_printf("XPUT\n"); */
-      XPutImage(xlib_dt->display, xlib_drawable->drawable, xlib_dt->gc,
-                ximage, 0, 0, 0, 0, xlib_dt->width, xlib_dt->height);
+      for (i = 0; i < num_rects; i++) {
+         int x, y, w, h;
+
+         if (clip_rect(xlib_dt, &rects[i], &x, &y, &w, &h))
+            XPutImage(display, xlib_drawable->drawable, xlib_dt->gc,
+                      ximage, x, y, x, y, w, h);
+      }
    }
 
    XFlush(xlib_dt->display);
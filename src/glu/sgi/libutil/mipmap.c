@@ -365,6 +365,93 @@ static void halveImage(GLint components, GLuint width, GLuint height,
     }
 }
 
+/*
+** Fast paths for the common GL_UNSIGNED_BYTE layouts (RGBA, RGB and
+** LUMINANCE).  They compute exactly the same box filter as the generic
+** loop in halveImage_ubyte() but walk whole rows instead of stepping
+** through every component with a variable stride.  ysize is the source
+** row stride in bytes; the destination is tightly packed.
+*/
+static void halveImage_ubyte_rgba(GLuint width, GLuint height,
+				  const GLubyte *datain, GLubyte *dataout,
+				  GLint ysize)
+{
+    const GLuint mask = 0x00ff00ff;
+    GLuint newwidth = width / 2;
+    GLuint newheight = height / 2;
+    GLubyte *s = dataout;
+    GLuint i, j;
+
+    for (i = 0; i < newheight; i++) {
+	const GLubyte *t0 = datain + 2 * i * ysize;
+	const GLubyte *t1 = t0 + ysize;
+
+	for (j = 0; j < newwidth; j++) {
+	    GLuint p0, p1, p2, p3, lo, hi;
+
+	    memcpy(&p0, t0, 4);
+	    memcpy(&p1, t0 + 4, 4);
+	    memcpy(&p2, t1, 4);
+	    memcpy(&p3, t1 + 4, 4);
+
+	    /* Average two channels at a time in 16-bit lanes.  A lane holds
+	    ** at most 4*255+2, so no carry can reach the neighbouring lane,
+	    ** and the result does not depend on the host byte order.
+	    */
+	    lo = (p0 & mask) + (p1 & mask) + (p2 & mask) + (p3 & mask) +
+		 0x00020002;
+	    hi = ((p0 >> 8) & mask) + ((p1 >> 8) & mask) +
+		 ((p2 >> 8) & mask) + ((p3 >> 8) & mask) + 0x00020002;
+	    p0 = ((lo >> 2) & mask) | (((hi >> 2) & mask) << 8);
+
+	    memcpy(s, &p0, 4);
+	    s += 4; t0 += 8; t1 += 8;
+	}
+    }
+}
+
+static void halveImage_ubyte_rgb(GLuint width, GLuint height,
+				 const GLubyte *datain, GLubyte *dataout,
+				 GLint ysize)
+{
+    GLuint newwidth = width / 2;
+    GLuint newheight = height / 2;
+    GLubyte *s = dataout;
+    GLuint i, j;
+
+    for (i = 0; i < newheight; i++) {
+	const GLubyte *t0 = datain + 2 * i * ysize;
+	const GLubyte *t1 = t0 + ysize;
+
+	for (j = 0; j < newwidth; j++) {
+	    s[0] = (t0[0] + t0[3] + t1[0] + t1[3] + 2) >> 2;
+	    s[1] = (t0[1] + t0[4] + t1[1] + t1[4] + 2) >> 2;
+	    s[2] = (t0[2] + t0[5] + t1[2] + t1[5] + 2) >> 2;
+	    s += 3; t0 += 6; t1 += 6;
+	}
+    }
+}
+
+static void halveImage_ubyte_l(GLuint width, GLuint height,
+			       const GLubyte *datain, GLubyte *dataout,
+			       GLint ysize)
+{
+    GLuint newwidth = width / 2;
+    GLuint newheight = height / 2;
+    GLubyte *s = dataout;
+    GLuint i, j;
+
+    for (i = 0; i < newheight; i++) {
+	const GLubyte *t0 = datain + 2 * i * ysize;
+	const GLubyte *t1 = t0 + ysize;
+
+	for (j = 0; j < newwidth; j++) {
+	    s[j] = (t0[2*j] + t0[2*j+1] + t1[2*j] + t1[2*j+1] + 2) >> 2;
+	}
+	s += newwidth;
+    }
+}
+
 static void halveImage_ubyte(GLint components, GLuint width, GLuint height,
 			const GLubyte *datain, GLubyte *dataout,
 			GLint element_size, GLint ysize, GLint group_size)
@@ -383,6 +470,25 @@ static void halveImage_ubyte(GLint components, GLuint width, GLuint height,
        return;
     }
 
+    /* The generic loop below walks odd widths slightly differently, so
+    ** only take the row-based fast paths for even widths.
+    */
+    if (element_size == 1 && group_size == components && !(width & 1)) {
+	switch (components) {
+	case 4:
+	    halveImage_ubyte_rgba(width, height, datain, dataout, ysize);
+	    return;
+	case 3:
+	    halveImage_ubyte_rgb(width, height, datain, dataout, ysize);
+	    return;
+	case 1:
+	    halveImage_ubyte_l(width, height, datain, dataout, ysize);
+	    return;
+	default:
+	    break;
+	}
+    }
+
     newwidth = width / 2;
     newheight = height / 2;
     padBytes = ysize - (width*group_size);
@@ -4580,6 +4686,44 @@ gluBuild2DMipmapLevels(GLenum target, GLint internalFormat,
 				     data);
 } /* gluBuild2DMipmapLevels() */
 
+/*
+** If the GL can generate the mipmap chain itself (OpenGL 1.4 or
+** GL_SGIS_generate_mipmap), upload only the base level and let the
+** implementation build the rest.  This is only done when no rescaling
+** is needed and level 0 is the texture's base level.  The chain is then
+** generated by the driver: its downsampling filter may differ from the
+** software path's box filter in the low bits, and only the levels up to
+** GL_TEXTURE_MAX_LEVEL are built.
+** Returns GL_TRUE if the texture was specified.
+*/
+static GLboolean generateMipmapBuild2DMipmaps(GLenum target,
+					      GLint internalFormat,
+					      GLsizei width, GLsizei height,
+					      GLenum format, GLenum type,
+					      const void *data)
+{
+    GLint baseLevel, oldGenerate;
+
+    if (target != GL_TEXTURE_2D || type == GL_BITMAP || is_index(format))
+	return GL_FALSE;
+
+    if (strtod((const char *)glGetString(GL_VERSION),NULL) < 1.4 &&
+	!gluCheckExtension((const GLubyte *)"GL_SGIS_generate_mipmap",
+			   glGetString(GL_EXTENSIONS)))
+	return GL_FALSE;
+
+    glGetTexParameteriv(target, GL_TEXTURE_BASE_LEVEL, &baseLevel);
+    if (baseLevel != 0)
+	return GL_FALSE;
+
+    glGetTexParameteriv(target, GL_GENERATE_MIPMAP, &oldGenerate);
+    glTexParameteri(target, GL_GENERATE_MIPMAP, GL_TRUE);
+    glTexImage2D(target, 0, internalFormat, width, height, 0,
+		 format, type, data);
+    glTexParameteri(target, GL_GENERATE_MIPMAP, oldGenerate);
+    return GL_TRUE;
+}
+
 GLint GLAPIENTRY
 gluBuild2DMipmaps(GLenum target, GLint internalFormat,
 			GLsizei width, GLsizei height,
@@ -4599,6 +4743,12 @@ gluBuild2DMipmaps(GLenum target, GLint internalFormat,
    closestFit(target,width,height,internalFormat,format,type,
 	      &widthPowerOf2,&heightPowerOf2);
 
+   if (width == widthPowerOf2 && height == heightPowerOf2 &&
+       generateMipmapBuild2DMipmaps(target,internalFormat,width,height,
+				    format,type,data)) {
+      return 0;
+   }
+
    levels = computeLog(widthPowerOf2);
    level = computeLog(heightPowerOf2);
    if (level > levels) levels=level;
@@ -119,6 +119,18 @@ void *u_current_user;
 struct u_tsd u_current_table_tsd;
 static struct u_tsd u_current_user_tsd;
 static int ThreadSafe;
+
+/*
+ * Once an application is multithreaded every dispatch goes through
+ * u_tsd_get().  When the compiler has __thread, keep a copy of the TSD
+ * values in private thread-local variables and read those instead.  They
+ * are static, so the loader/driver ABI is the same as without TLS.
+ */
+#if defined(PTHREADS) && defined(__GNUC__) && defined(__ELF__)
+#define U_CURRENT_TLS_CACHE
+static __thread struct mapi_table *u_current_table_cache;
+static __thread void *u_current_user_cache;
+#endif
 #endif /* THREADS */
 
 #endif /* defined(GLX_USE_TLS) */
@@ -210,6 +222,9 @@ u_current_set_user_internal(void *ptr)
    u_current_user_tls = ptr;
 #elif defined(THREADS)
    u_tsd_set(&u_current_user_tsd, ptr);
+#ifdef U_CURRENT_TLS_CACHE
+   u_current_user_cache = ptr;
+#endif
    u_current_user = (ThreadSafe) ? NULL : ptr;
 #else
    u_current_user = ptr;
@@ -226,6 +241,8 @@ u_current_get_user_internal(void)
 {
 #if defined(GLX_USE_TLS)
    return u_current_user_tls;
+#elif defined(U_CURRENT_TLS_CACHE)
+   return (ThreadSafe) ? u_current_user_cache : u_current_user;
 #elif defined(THREADS)
    return (ThreadSafe)
       ? u_tsd_get(&u_current_user_tsd)
@@ -254,6 +271,9 @@ u_current_set_internal(struct mapi_table *tbl)
    u_current_table_tls = tbl;
 #elif defined(THREADS)
    u_tsd_set(&u_current_table_tsd, (void *) tbl);
+#ifdef U_CURRENT_TLS_CACHE
+   u_current_table_cache = tbl;
+#endif
    u_current_table = (ThreadSafe) ? NULL : tbl;
 #else
    u_current_table = tbl;
@@ -268,6 +288,8 @@ u_current_get_internal(void)
 {
 #if defined(GLX_USE_TLS)
    return u_current_table_tls;
+#elif defined(U_CURRENT_TLS_CACHE)
+   return (ThreadSafe) ? u_current_table_cache : u_current_table;
 #elif defined(THREADS)
    return (struct mapi_table *) ((ThreadSafe) ?
          u_tsd_get(&u_current_table_tsd) : (void *) u_current_table);
@@ -62,6 +62,11 @@ typedef struct {
    AEattrib attribs[VERT_ATTRIB_MAX + 1];
    GLuint NewState;
 
+   /* The same arrays in the form of _ae_get_direct_arrays() */
+   struct _ae_direct_array direct[VERT_ATTRIB_MAX + 2];
+   GLuint nr_direct;
+   GLboolean direct_ok;
+
    struct gl_buffer_object *vbo[VERT_ATTRIB_MAX];
    GLuint nr_vbos;
    GLboolean mapped_vbos;
@@ -1455,6 +1460,33 @@ static void check_vbo( AEcontext *actx,
 }
 
 
+/**
+ * Fill in an entry of the list returned by _ae_get_direct_arrays(), which
+ * is only usable if all arrays are plain client arrays of floats (or of
+ * unsigned bytes for the color).
+ * \param attr  the VERT_ATTRIB_x the array element is sent to
+ * \param size  the number of components sent
+ */
+static void add_direct( AEcontext *actx, struct _ae_direct_array *da,
+                        const struct gl_client_array *array,
+                        GLuint attr, GLuint size )
+{
+   if (_mesa_is_bufferobj(array->BufferObj))
+      actx->direct_ok = GL_FALSE;
+   else if (array->Type == GL_UNSIGNED_BYTE && attr == VERT_ATTRIB_COLOR0)
+      size = 4;  /* glColor3ubv is sent as glColor4f */
+   else if (array->Type != GL_FLOAT)
+      actx->direct_ok = GL_FALSE;
+
+   da->ptr = array->Ptr;
+   da->stride = array->StrideB;
+   da->type = array->Type;
+   da->attr = attr;
+   da->comps = array->Size;
+   da->size = size;
+}
+
+
 /**
  * Make a list of per-vertex functions to call for each glArrayElement call.
  * These functions access the array data (i.e. glVertex, glColor, glNormal,
@@ -1468,44 +1500,61 @@ static void _ae_update_state( struct gl_context *ctx )
    AEattrib *at = actx->attribs;
    GLuint i;
    struct gl_array_object *arrayObj = ctx->Array.ArrayObj;
+   /* The conventional arrays are sent after the attribs, so their direct
+    * entries are collected here and appended at the end.
+    */
+   struct _ae_direct_array direct_arrays[5];
+   GLuint nr_direct_arrays = 0;
 
    actx->nr_vbos = 0;
+   actx->nr_direct = 0;
+   actx->direct_ok = GL_TRUE;
 
    /* conventional vertex arrays */
    if (arrayObj->Index.Enabled) {
       aa->array = &arrayObj->Index;
       aa->offset = IndexFuncs[TYPE_IDX(aa->array->Type)];
       check_vbo(actx, aa->array->BufferObj);
+      actx->direct_ok = GL_FALSE;
       aa++;
    }
    if (arrayObj->EdgeFlag.Enabled) {
       aa->array = &arrayObj->EdgeFlag;
       aa->offset = _gloffset_EdgeFlagv;
       check_vbo(actx, aa->array->BufferObj);
+      actx->direct_ok = GL_FALSE;
       aa++;
    }
    if (arrayObj->Normal.Enabled) {
       aa->array = &arrayObj->Normal;
       aa->offset = NormalFuncs[TYPE_IDX(aa->array->Type)];
       check_vbo(actx, aa->array->BufferObj);
+      add_direct(actx, &direct_arrays[nr_direct_arrays++],
+                 aa->array, VERT_ATTRIB_NORMAL, 3);
       aa++;
    }
    if (arrayObj->Color.Enabled) {
       aa->array = &arrayObj->Color;
       aa->offset = ColorFuncs[aa->array->Size-3][TYPE_IDX(aa->array->Type)];
       check_vbo(actx, aa->array->BufferObj);
+      add_direct(actx, &direct_arrays[nr_direct_arrays++],
+                 aa->array, VERT_ATTRIB_COLOR0, aa->array->Size);
       aa++;
    }
    if (arrayObj->SecondaryColor.Enabled) {
       aa->array = &arrayObj->SecondaryColor;
       aa->offset = SecondaryColorFuncs[TYPE_IDX(aa->array->Type)];
       check_vbo(actx, aa->array->BufferObj);
+      add_direct(actx, &direct_arrays[nr_direct_arrays++],
+                 aa->array, VERT_ATTRIB_COLOR1, 3);
       aa++;
    }
    if (arrayObj->FogCoord.Enabled) {
       aa->array = &arrayObj->FogCoord;
       aa->offset = FogCoordFuncs[TYPE_IDX(aa->array->Type)];
       check_vbo(actx, aa->array->BufferObj);
+      add_direct(actx, &direct_arrays[nr_direct_arrays++],
+                 aa->array, VERT_ATTRIB_FOG, 1);
       aa++;
    }
    for (i = 0; i < ctx->Const.MaxTextureCoordUnits; i++) {
@@ -1521,6 +1570,8 @@ static void _ae_update_state( struct gl_context *ctx )
                                  [TYPE_IDX(at->array->Type)];
          at->index = VERT_ATTRIB_TEX0 + i;
 	 check_vbo(actx, at->array->BufferObj);
+         add_direct(actx, &actx->direct[actx->nr_direct++],
+                    at->array, at->index, at->array->Size);
          at++;
       }
    }
@@ -1540,6 +1591,8 @@ static void _ae_update_state( struct gl_context *ctx )
             at->func = AttribFuncsNV[at->array->Normalized]
                                     [at->array->Size-1]
                                     [TYPE_IDX(at->array->Type)];
+            add_direct(actx, &actx->direct[actx->nr_direct++],
+                       at->array, i, at->array->Size);
          }
          else {
             GLint intOrNorm;
@@ -1553,6 +1606,8 @@ static void _ae_update_state( struct gl_context *ctx )
             at->func = AttribFuncsARB[intOrNorm]
                                      [at->array->Size-1]
                                      [TYPE_IDX(at->array->Type)];
+            add_direct(actx, &actx->direct[actx->nr_direct++], at->array,
+                       VERT_ATTRIB_GENERIC0 + i, at->array->Size);
          }
          at->index = i;
 	 check_vbo(actx, at->array->BufferObj);
@@ -1569,14 +1624,21 @@ static void _ae_update_state( struct gl_context *ctx )
       assert(aa->array->Size >= 2); /* XXX fix someday? */
       aa->offset = VertexFuncs[aa->array->Size-2][TYPE_IDX(aa->array->Type)];
       check_vbo(actx, aa->array->BufferObj);
+      add_direct(actx, &direct_arrays[nr_direct_arrays++],
+                 aa->array, VERT_ATTRIB_POS, aa->array->Size);
       aa++;
    }
    else if (arrayObj->Vertex.Enabled) {
       aa->array = &arrayObj->Vertex;
       aa->offset = VertexFuncs[aa->array->Size-2][TYPE_IDX(aa->array->Type)];
       check_vbo(actx, aa->array->BufferObj);
+      add_direct(actx, &direct_arrays[nr_direct_arrays++],
+                 aa->array, VERT_ATTRIB_POS, aa->array->Size);
       aa++;
    }
+   else {
+      actx->direct_ok = GL_FALSE;
+   }
 
    check_vbo(actx, ctx->Array.ElementArrayBufferObj);
 
@@ -1585,9 +1647,37 @@ static void _ae_update_state( struct gl_context *ctx )
    at->func = NULL;  /* terminate the list */
    aa->offset = -1;  /* terminate the list */
 
+   ASSERT(nr_direct_arrays <= Elements(direct_arrays));
+   memcpy(&actx->direct[actx->nr_direct], direct_arrays,
+          nr_direct_arrays * sizeof(direct_arrays[0]));
+   actx->nr_direct += nr_direct_arrays;
+   actx->direct[actx->nr_direct].size = 0;  /* terminate the list */
+
    actx->NewState = 0;
 }
 
+/**
+ * Return the enabled arrays in the order glArrayElement() sends them,
+ * vertex position last, so that a vertex format module can read the
+ * element directly instead of calling through the dispatch table for
+ * each array.  Returns NULL unless all arrays are client-side GL_FLOAT
+ * arrays (GL_UNSIGNED_BYTE is also allowed for the primary color) and a
+ * position array is enabled; _ae_ArrayElement() must be used then.
+ */
+const struct _ae_direct_array *
+_ae_get_direct_arrays( struct gl_context *ctx )
+{
+   AEcontext *actx = AE_CONTEXT(ctx);
+
+   if (actx->NewState) {
+      assert(!actx->mapped_vbos);
+      _ae_update_state( ctx );
+   }
+
+   return actx->direct_ok ? actx->direct : NULL;
+}
+
+
 void _ae_map_vbos( struct gl_context *ctx )
 {
    AEcontext *actx = AE_CONTEXT(ctx);
@@ -30,6 +30,20 @@
 
 #include "main/mtypes.h"
 
+
+/**
+ * One enabled vertex array, as returned by _ae_get_direct_arrays().
+ */
+struct _ae_direct_array {
+   const GLubyte *ptr;  /**< client memory address of element zero */
+   GLuint stride;       /**< in bytes */
+   GLenum type;         /**< GL_FLOAT or GL_UNSIGNED_BYTE */
+   GLuint attr;         /**< VERT_ATTRIB_x the element is sent to */
+   GLuint comps;        /**< number of components in the array */
+   GLuint size;         /**< number of components sent, 0 ends the list */
+};
+
+
 #if FEATURE_arrayelt
 
 #define _MESA_INIT_ARRAYELT_VTXFMT(vfmt, impl)     \
@@ -42,6 +56,9 @@ extern void _ae_destroy_context( struct gl_context *ctx );
 extern void _ae_invalidate_state( struct gl_context *ctx, GLuint new_state );
 extern void GLAPIENTRY _ae_ArrayElement( GLint elt );
 
+extern const struct _ae_direct_array *
+_ae_get_direct_arrays( struct gl_context *ctx );
+
 /* May optionally be called before a batch of element calls:
  */
 extern void _ae_map_vbos( struct gl_context *ctx );
@@ -40,6 +40,7 @@
 #include "bufferobj.h"
 #include "fbobject.h"
 #include "texobj.h"
+#include "util/u_atomic.h"
 
 
 /* Debug flags */
@@ -247,15 +248,12 @@ _mesa_reference_buffer_object(struct gl_context *ctx,
       GLboolean deleteFlag = GL_FALSE;
       struct gl_buffer_object *oldObj = *ptr;
 
-      _glthread_LOCK_MUTEX(oldObj->Mutex);
       ASSERT(oldObj->RefCount > 0);
-      oldObj->RefCount--;
+      deleteFlag = p_atomic_dec_zero(&oldObj->RefCount);
 #if 0
       printf("BufferObj %p %d DECR to %d\n",
              (void *) oldObj, oldObj->Name, oldObj->RefCount);
 #endif
-      deleteFlag = (oldObj->RefCount == 0);
-      _glthread_UNLOCK_MUTEX(oldObj->Mutex);
 
       if (deleteFlag) {
 
@@ -277,22 +275,20 @@ _mesa_reference_buffer_object(struct gl_context *ctx,
 
    if (bufObj) {
       /* reference new buffer */
-      _glthread_LOCK_MUTEX(bufObj->Mutex);
-      if (bufObj->RefCount == 0) {
+      if (p_atomic_read(&bufObj->RefCount) == 0) {
          /* this buffer's being deleted (look just above) */
          /* Not sure this can every really happen.  Warn if it does. */
          _mesa_problem(NULL, "referencing deleted buffer object");
          *ptr = NULL;
       }
       else {
-         bufObj->RefCount++;
+         p_atomic_inc(&bufObj->RefCount);
 #if 0
          printf("BufferObj %p %d INCR to %d\n",
                 (void *) bufObj, bufObj->Name, bufObj->RefCount);
 #endif
          *ptr = bufObj;
       }
-      _glthread_UNLOCK_MUTEX(bufObj->Mutex);
    }
 }
 
@@ -910,7 +906,8 @@ _mesa_lookup_bufferobj(struct gl_context *ctx, GLuint buffer)
       return NULL;
    else
       return (struct gl_buffer_object *)
-         _mesa_HashLookup(ctx->Shared->BufferObjects, buffer);
+         _mesa_HashLookupCached(ctx->Shared->BufferObjects,
+                                &ctx->BufferObjCache, buffer);
 }
 
 
@@ -132,6 +132,7 @@
 #include "math/m_matrix.h"
 #endif
 #include "main/dispatch.h" /* for _gloffset_COUNT */
+#include "util/u_atomic.h"
 
 #ifdef USE_SPARC_ASM
 #include "sparc/sparc.h"
@@ -844,6 +845,19 @@ _mesa_alloc_dispatch_table(int size)
 }
 
 
+/**
+ * Drop the context's cached lookups in the shared object tables, e.g.
+ * because it switched to another gl_shared_state.
+ */
+static void
+invalidate_lookup_caches(struct gl_context *ctx)
+{
+   _mesa_HashInvalidateCache(&ctx->TexObjCache);
+   _mesa_HashInvalidateCache(&ctx->BufferObjCache);
+   _mesa_HashInvalidateCache(&ctx->ProgramCache);
+}
+
+
 /**
  * Initialize a struct gl_context struct (rendering context).
  *
@@ -915,10 +929,9 @@ _mesa_initialize_context_for_api(struct gl_context *ctx,
          return GL_FALSE;
    }
 
-   _glthread_LOCK_MUTEX(shared->Mutex);
    ctx->Shared = shared;
-   shared->RefCount++;
-   _glthread_UNLOCK_MUTEX(shared->Mutex);
+   p_atomic_inc(&shared->RefCount);
+   invalidate_lookup_caches(ctx);
 
    if (!init_attrib_groups( ctx )) {
       _mesa_release_shared_state(ctx, ctx->Shared);
@@ -1560,10 +1573,8 @@ _mesa_share_state(struct gl_context *ctx, struct gl_context *ctxToShare)
       struct gl_shared_state *oldSharedState = ctx->Shared;
 
       ctx->Shared = ctxToShare->Shared;
-      
-      _glthread_LOCK_MUTEX(ctx->Shared->Mutex);
-      ctx->Shared->RefCount++;
-      _glthread_UNLOCK_MUTEX(ctx->Shared->Mutex);
+      p_atomic_inc(&ctx->Shared->RefCount);
+      invalidate_lookup_caches(ctx);
 
       update_default_objects(ctx);
 
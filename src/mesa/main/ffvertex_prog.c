@@ -1642,6 +1642,11 @@ _mesa_get_fixed_func_vertex_program(struct gl_context *ctx)
 {
    struct gl_vertex_program *prog;
    struct state_key key;
+   struct {
+      struct state_key key;
+      GLuint mvp_with_dp4;
+      GLuint max_temps;
+   } shared_key;
 
    /* Grab all the relevent state and put it in a single structure:
     */
@@ -1653,18 +1658,35 @@ _mesa_get_fixed_func_vertex_program(struct gl_context *ctx)
       _mesa_search_program_cache(ctx->VertexProgram.Cache, &key, sizeof(key));
 
    if (!prog) {
-      /* OK, we'll have to build a new one */
-      if (0)
-         printf("Build new TNL program\n");
+      /* Maybe another context already built it.  The generated code also
+       * depends on these context settings.
+       */
+      memset(&shared_key, 0, sizeof(shared_key));
+      shared_key.key = key;
+      shared_key.mvp_with_dp4 = ctx->mvp_with_dp4;
+      shared_key.max_temps = ctx->Const.VertexProgram.MaxTemps;
 
       prog = (struct gl_vertex_program *)
-         ctx->Driver.NewProgram(ctx, GL_VERTEX_PROGRAM_ARB, 0);
-      if (!prog)
-         return NULL;
-
-      create_new_program( &key, prog,
-                          ctx->mvp_with_dp4,
-                          ctx->Const.VertexProgram.MaxTemps );
+         _mesa_search_shared_program_cache(ctx, GL_VERTEX_PROGRAM_ARB,
+                                           &shared_key, sizeof(shared_key));
+      if (!prog) {
+         /* OK, we'll have to build a new one */
+         if (0)
+            printf("Build new TNL program\n");
+
+         prog = (struct gl_vertex_program *)
+            ctx->Driver.NewProgram(ctx, GL_VERTEX_PROGRAM_ARB, 0);
+         if (!prog)
+            return NULL;
+
+         create_new_program( &key, prog,
+                             ctx->mvp_with_dp4,
+                             ctx->Const.VertexProgram.MaxTemps );
+
+         _mesa_shared_program_cache_insert(ctx, GL_VERTEX_PROGRAM_ARB,
+                                           &shared_key, sizeof(shared_key),
+                                           &prog->Base);
+      }
 
 #if 0
       if (ctx->Driver.ProgramStringNotify)
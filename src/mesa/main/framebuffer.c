@@ -43,6 +43,7 @@
 #include "framebuffer.h"
 #include "renderbuffer.h"
 #include "texobj.h"
+#include "util/u_atomic.h"
 
 
 
@@ -248,11 +249,8 @@ _mesa_reference_framebuffer(struct gl_framebuffer **ptr,
       GLboolean deleteFlag = GL_FALSE;
       struct gl_framebuffer *oldFb = *ptr;
 
-      _glthread_LOCK_MUTEX(oldFb->Mutex);
       ASSERT(oldFb->RefCount > 0);
-      oldFb->RefCount--;
-      deleteFlag = (oldFb->RefCount == 0);
-      _glthread_UNLOCK_MUTEX(oldFb->Mutex);
+      deleteFlag = p_atomic_dec_zero(&oldFb->RefCount);
       
       if (deleteFlag)
          oldFb->Delete(oldFb);
@@ -262,9 +260,7 @@ _mesa_reference_framebuffer(struct gl_framebuffer **ptr,
    assert(!*ptr);
 
    if (fb) {
-      _glthread_LOCK_MUTEX(fb->Mutex);
-      fb->RefCount++;
-      _glthread_UNLOCK_MUTEX(fb->Mutex);
+      p_atomic_inc(&fb->RefCount);
       *ptr = fb;
    }
 }
@@ -39,6 +39,7 @@
 #include "imports.h"
 #include "glapi/glthread.h"
 #include "hash.h"
+#include "util/u_atomic.h"
 
 
 #define TABLE_SIZE 1023  /**< Size of lookup table/array */
@@ -65,6 +66,7 @@ struct _mesa_HashTable {
    _glthread_Mutex Mutex;                /**< mutual exclusion lock */
    _glthread_Mutex WalkMutex;            /**< for _mesa_HashWalk() */
    GLboolean InDeleteAll;                /**< Debug check */
+   GLint Stamp;                          /**< bumped when a key's data goes */
 };
 
 
@@ -164,6 +166,62 @@ _mesa_HashLookup(struct _mesa_HashTable *table, GLuint key)
 }
 
 
+/**
+ * Lookup an entry in the hash table, trying a lookup cache first.
+ *
+ * Hits in the cache don't take the table's mutex.  The cache is dropped
+ * whenever the table's stamp changed, i.e. after any entry was removed or
+ * replaced, so a hit never returns data that was since taken out of the
+ * table.  Only the insertion of new keys leaves the cached entries valid.
+ *
+ * A cache must only be used by one thread at a time (it's typically part
+ * of a context).
+ *
+ * \param table the hash table.
+ * \param cache the lookup cache.
+ * \param key the key.
+ *
+ * \return pointer to user's data or NULL if key not in table
+ */
+void *
+_mesa_HashLookupCached(struct _mesa_HashTable *table,
+                       struct _mesa_HashCache *cache, GLuint key)
+{
+   const GLuint slot = key % MESA_HASH_CACHE_SIZE;
+   const GLint stamp = p_atomic_read(&table->Stamp);
+   void *res;
+
+   assert(table);
+   assert(key);
+
+   if (cache->Table != table || cache->Stamp != stamp) {
+      _mesa_HashInvalidateCache(cache);
+      cache->Table = table;
+      cache->Stamp = stamp;
+   }
+   else if (cache->Key[slot] == key) {
+      return cache->Data[slot];
+   }
+
+   res = _mesa_HashLookup(table, key);
+   if (res) {
+      cache->Key[slot] = key;
+      cache->Data[slot] = res;
+   }
+   return res;
+}
+
+
+/**
+ * Drop all entries of a lookup cache.
+ */
+void
+_mesa_HashInvalidateCache(struct _mesa_HashCache *cache)
+{
+   memset(cache, 0, sizeof(*cache));
+}
+
+
 /**
  * Insert a key/pointer pair into the hash table.  
  * If an entry with this key already exists we'll replace the existing entry.
@@ -199,6 +257,7 @@ _mesa_HashInsert(struct _mesa_HashTable *table, GLuint key, void *data)
          }
 #endif
 	 entry->Data = data;
+         p_atomic_inc(&table->Stamp);
          _glthread_UNLOCK_MUTEX(table->Mutex);
 	 return;
       }
@@ -258,6 +317,7 @@ _mesa_HashRemove(struct _mesa_HashTable *table, GLuint key)
             table->Table[pos] = entry->Next;
          }
          free(entry);
+         p_atomic_inc(&table->Stamp);
          _glthread_UNLOCK_MUTEX(table->Mutex);
 	 return;
       }
@@ -298,6 +358,7 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
       }
       table->Table[pos] = NULL;
    }
+   p_atomic_inc(&table->Stamp);
    table->InDeleteAll = GL_FALSE;
    _glthread_UNLOCK_MUTEX(table->Mutex);
 }
@@ -528,6 +589,7 @@ _mesa_test_hash_functions(void)
 {
    int a, b, c;
    struct _mesa_HashTable *t;
+   struct _mesa_HashCache cache;
 
    t = _mesa_NewHashTable();
    _mesa_HashInsert(t, 501, &a);
@@ -539,6 +601,18 @@ _mesa_test_hash_functions(void)
    assert(!_mesa_HashLookup(t,1313));
    assert(_mesa_HashFindFreeKeyBlock(t, 100));
 
+   /* cached lookups must see removals and replacements */
+   _mesa_HashInvalidateCache(&cache);
+   assert(_mesa_HashLookupCached(t, &cache, 501) == &a);
+   assert(_mesa_HashLookupCached(t, &cache, 501) == &a);
+   _mesa_HashInsert(t, 502, &b);
+   assert(_mesa_HashLookupCached(t, &cache, 501) == &a);
+   _mesa_HashInsert(t, 501, &b);
+   assert(_mesa_HashLookupCached(t, &cache, 501) == &b);
+   _mesa_HashRemove(t, 501);
+   assert(!_mesa_HashLookupCached(t, &cache, 501));
+   _mesa_HashRemove(t, 502);
+
    _mesa_DeleteHashTable(t);
 
    test_hash_walking();
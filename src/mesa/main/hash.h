@@ -35,12 +35,33 @@
 #include "glheader.h"
 
 
+#define MESA_HASH_CACHE_SIZE 16  /**< Entries in a lookup cache */
+
+
+/**
+ * Small direct-mapped cache of recent lookups in a hash table.
+ * \sa _mesa_HashLookupCached
+ */
+struct _mesa_HashCache {
+   const struct _mesa_HashTable *Table;  /**< table the entries came from */
+   GLint Stamp;                          /**< table's stamp at that time */
+   GLuint Key[MESA_HASH_CACHE_SIZE];
+   void *Data[MESA_HASH_CACHE_SIZE];
+};
+
+
 extern struct _mesa_HashTable *_mesa_NewHashTable(void);
 
 extern void _mesa_DeleteHashTable(struct _mesa_HashTable *table);
 
 extern void *_mesa_HashLookup(struct _mesa_HashTable *table, GLuint key);
 
+extern void *
+_mesa_HashLookupCached(struct _mesa_HashTable *table,
+                       struct _mesa_HashCache *cache, GLuint key);
+
+extern void _mesa_HashInvalidateCache(struct _mesa_HashCache *cache);
+
 extern void _mesa_HashInsert(struct _mesa_HashTable *table, GLuint key, void *data);
 
 extern void _mesa_HashRemove(struct _mesa_HashTable *table, GLuint key);
@@ -40,6 +40,7 @@
 #include "glapi/glapi.h"
 #include "math/m_matrix.h"	/* GLmatrix */
 #include "main/simple_list.h"	/* struct simple_node */
+#include "main/hash.h"		/* struct _mesa_HashCache */
 
 
 /**
@@ -3086,6 +3087,16 @@ struct gl_context
    /** State possibly shared with other contexts in the address space */
    struct gl_shared_state *Shared;
 
+   /** \name Caches of recent lookups in the shared object tables
+    * These let binds by contexts on different threads avoid contending
+    * for the tables' mutexes.
+    */
+   /*@{*/
+   struct _mesa_HashCache TexObjCache;
+   struct _mesa_HashCache BufferObjCache;
+   struct _mesa_HashCache ProgramCache;
+   /*@}*/
+
    /** \name API function pointer tables */
    /*@{*/
    gl_api API;
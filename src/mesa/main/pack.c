@@ -3286,6 +3286,241 @@ extract_uint_rgba(GLuint n, GLuint rgba[][4],
 
 
 
+/*
+ * Fast paths for _mesa_unpack_color_span_chan() with 8-bit unorm source
+ * data and no transfer ops.  Each component of the dest pixel is then a
+ * copy of one source byte, or 0 or 1, so the conversion between any pair
+ * of formats is described by a swizzle which is set up once per call.
+ */
+
+#define UNPACK_ZERO 4
+#define UNPACK_ONE  5
+
+typedef void (*unpack_ubyte_func)(GLuint n, GLchan *dst,
+                                  const GLubyte *src, GLuint srcStride,
+                                  const GLubyte swizzle[4]);
+
+static void
+unpack_ubyte_1(GLuint n, GLchan *dst, const GLubyte *src, GLuint srcStride,
+               const GLubyte swizzle[4])
+{
+   const GLubyte s0 = swizzle[0];
+   GLuint i;
+   for (i = 0; i < n; i++) {
+      dst[i] = UBYTE_TO_CHAN(src[s0]);
+      src += srcStride;
+   }
+}
+
+static void
+unpack_ubyte_2(GLuint n, GLchan *dst, const GLubyte *src, GLuint srcStride,
+               const GLubyte swizzle[4])
+{
+   const GLubyte s0 = swizzle[0], s1 = swizzle[1];
+   GLuint i;
+   for (i = 0; i < n; i++) {
+      dst[0] = UBYTE_TO_CHAN(src[s0]);
+      dst[1] = UBYTE_TO_CHAN(src[s1]);
+      src += srcStride;
+      dst += 2;
+   }
+}
+
+static void
+unpack_ubyte_3(GLuint n, GLchan *dst, const GLubyte *src, GLuint srcStride,
+               const GLubyte swizzle[4])
+{
+   const GLubyte s0 = swizzle[0], s1 = swizzle[1], s2 = swizzle[2];
+   GLuint i;
+   for (i = 0; i < n; i++) {
+      dst[0] = UBYTE_TO_CHAN(src[s0]);
+      dst[1] = UBYTE_TO_CHAN(src[s1]);
+      dst[2] = UBYTE_TO_CHAN(src[s2]);
+      src += srcStride;
+      dst += 3;
+   }
+}
+
+static void
+unpack_ubyte_4(GLuint n, GLchan *dst, const GLubyte *src, GLuint srcStride,
+               const GLubyte swizzle[4])
+{
+   const GLubyte s0 = swizzle[0], s1 = swizzle[1];
+   const GLubyte s2 = swizzle[2], s3 = swizzle[3];
+   GLuint i;
+   for (i = 0; i < n; i++) {
+      dst[0] = UBYTE_TO_CHAN(src[s0]);
+      dst[1] = UBYTE_TO_CHAN(src[s1]);
+      dst[2] = UBYTE_TO_CHAN(src[s2]);
+      dst[3] = UBYTE_TO_CHAN(src[s3]);
+      src += srcStride;
+      dst += 4;
+   }
+}
+
+/** Source lacks some of the dest components (e.g. BGR -> RGBA) */
+static void
+unpack_ubyte_4_const(GLuint n, GLchan *dst, const GLubyte *src,
+                     GLuint srcStride, const GLubyte swizzle[4])
+{
+   GLuint i, c;
+   for (c = 0; c < 4; c++) {
+      GLchan *d = dst + c;
+      if (swizzle[c] == UNPACK_ZERO || swizzle[c] == UNPACK_ONE) {
+         const GLchan value = (swizzle[c] == UNPACK_ONE) ? CHAN_MAX : 0;
+         for (i = 0; i < n; i++) {
+            *d = value;
+            d += 4;
+         }
+      }
+      else {
+         const GLubyte *s = src + swizzle[c];
+         for (i = 0; i < n; i++) {
+            *d = UBYTE_TO_CHAN(*s);
+            s += srcStride;
+            d += 4;
+         }
+      }
+   }
+}
+
+static const unpack_ubyte_func unpack_ubyte_funcs[5] = {
+   NULL,
+   unpack_ubyte_1,
+   unpack_ubyte_2,
+   unpack_ubyte_3,
+   unpack_ubyte_4
+};
+
+
+/**
+ * Compute the swizzle for unpacking 8-bit srcFormat/srcType pixels into
+ * dstFormat pixels.  swizzle[i] is the byte offset, within a source
+ * pixel, of the value for dest component i, or UNPACK_ZERO/ONE.
+ * \return number of bytes per source pixel, or 0 if not handled.
+ */
+static GLuint
+get_ubyte_unpack_swizzle(GLenum dstFormat, GLenum srcFormat, GLenum srcType,
+                         GLboolean swapBytes, GLubyte swizzle[4])
+{
+   GLint rSrc, gSrc, bSrc, aSrc, rDst, gDst, bDst, aDst;
+   GLint r, g, b, a, l, i;
+   GLubyte src[4];
+   GLuint srcBytes;
+
+   switch (srcFormat) {
+   case GL_RED:
+   case GL_GREEN:
+   case GL_BLUE:
+   case GL_ALPHA:
+   case GL_LUMINANCE:
+   case GL_LUMINANCE_ALPHA:
+   case GL_INTENSITY:
+   case GL_RG:
+   case GL_RGB:
+   case GL_BGR:
+   case GL_RGBA:
+   case GL_BGRA:
+   case GL_ABGR_EXT:
+      break;
+   default:
+      return 0;
+   }
+
+   if (dstFormat == GL_COLOR_INDEX)
+      return 0;
+
+   get_component_mapping(srcFormat, &rSrc, &gSrc, &bSrc, &aSrc,
+                         &rDst, &gDst, &bDst, &aDst);
+   srcBytes = _mesa_components_in_format(srcFormat);
+
+   if (srcType == GL_UNSIGNED_INT_8_8_8_8 ||
+       srcType == GL_UNSIGNED_INT_8_8_8_8_REV) {
+      /* Find where each component of the packed value is in memory.
+       * For 8_8_8_8 the first component is in the most significant byte.
+       */
+      GLboolean firstInLowByte = (srcType == GL_UNSIGNED_INT_8_8_8_8_REV);
+      GLuint k;
+
+      if (srcBytes != 4)
+         return 0;
+      if (swapBytes)
+         firstInLowByte = !firstInLowByte;
+      if (!_mesa_little_endian())
+         firstInLowByte = !firstInLowByte;
+
+      for (k = 0; k < 4; k++)
+         src[k] = firstInLowByte ? k : 3 - k;
+
+      rSrc = src[rSrc];
+      gSrc = src[gSrc];
+      bSrc = src[bSrc];
+      aSrc = src[aSrc];
+   }
+   else if (srcType != GL_UNSIGNED_BYTE) {
+      return 0;
+   }
+
+   /* missing components default to (0, 0, 0, 1) */
+   src[RCOMP] = rSrc >= 0 ? rSrc : UNPACK_ZERO;
+   src[GCOMP] = gSrc >= 0 ? gSrc : UNPACK_ZERO;
+   src[BCOMP] = bSrc >= 0 ? bSrc : UNPACK_ZERO;
+   src[ACOMP] = aSrc >= 0 ? aSrc : UNPACK_ONE;
+
+   get_component_indexes(dstFormat, &r, &g, &b, &a, &l, &i);
+   if (r >= 0)
+      swizzle[r] = src[RCOMP];
+   if (g >= 0)
+      swizzle[g] = src[GCOMP];
+   if (b >= 0)
+      swizzle[b] = src[BCOMP];
+   if (a >= 0)
+      swizzle[a] = src[ACOMP];
+   /* luminance and intensity come from the red channel */
+   if (l >= 0)
+      swizzle[l] = src[RCOMP];
+   if (i >= 0)
+      swizzle[i] = src[RCOMP];
+
+   return srcBytes;
+}
+
+
+/**
+ * Try to unpack with one of the fast paths above.
+ * \return GL_TRUE if done, GL_FALSE if the general code must be used.
+ */
+static GLboolean
+fast_unpack_color_span_chan(GLuint n, GLenum dstFormat, GLchan dest[],
+                            GLenum srcFormat, GLenum srcType,
+                            const GLvoid *source,
+                            const struct gl_pixelstore_attrib *srcPacking)
+{
+   GLubyte swizzle[4];
+   GLuint srcBytes, dstComps, c;
+
+   srcBytes = get_ubyte_unpack_swizzle(dstFormat, srcFormat, srcType,
+                                       srcPacking->SwapBytes, swizzle);
+   if (srcBytes == 0)
+      return GL_FALSE;
+
+   dstComps = _mesa_components_in_format(dstFormat);
+   for (c = 0; c < dstComps; c++) {
+      if (swizzle[c] == UNPACK_ZERO || swizzle[c] == UNPACK_ONE) {
+         if (dstComps != 4)
+            return GL_FALSE;
+         unpack_ubyte_4_const(n, dest, (const GLubyte *) source, srcBytes,
+                              swizzle);
+         return GL_TRUE;
+      }
+   }
+
+   unpack_ubyte_funcs[dstComps](n, dest, (const GLubyte *) source, srcBytes,
+                                swizzle);
+   return GL_TRUE;
+}
+
+
 /*
  * Unpack a row of color image data from a client buffer according to
  * the pixel unpacking parameters.
@@ -3471,6 +3706,12 @@ _mesa_unpack_color_span_chan( struct gl_context *ctx,
             }
          }
       }
+
+      /* any other 8-bit format conversion */
+      if (fast_unpack_color_span_chan(n, dstFormat, dest, srcFormat, srcType,
+                                      source, srcPacking)) {
+         return;
+      }
    }
 
 
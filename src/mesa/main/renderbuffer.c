@@ -47,6 +47,7 @@
 #include "formats.h"
 #include "mtypes.h"
 #include "renderbuffer.h"
+#include "util/u_atomic.h"
 
 
 /*
@@ -1954,14 +1955,10 @@ _mesa_reference_renderbuffer(struct gl_renderbuffer **ptr,
       GLboolean deleteFlag = GL_FALSE;
       struct gl_renderbuffer *oldRb = *ptr;
 
-      assert(oldRb->Magic == RB_MAGIC);
-      _glthread_LOCK_MUTEX(oldRb->Mutex);
       assert(oldRb->Magic == RB_MAGIC);
       ASSERT(oldRb->RefCount > 0);
-      oldRb->RefCount--;
+      deleteFlag = p_atomic_dec_zero(&oldRb->RefCount);
       /*printf("RB DECR %p (%d) to %d\n", (void*) oldRb, oldRb->Name, oldRb->RefCount);*/
-      deleteFlag = (oldRb->RefCount == 0);
-      _glthread_UNLOCK_MUTEX(oldRb->Mutex);
 
       if (deleteFlag) {
          oldRb->Magic = 0; /* now invalid memory! */
@@ -1975,10 +1972,8 @@ _mesa_reference_renderbuffer(struct gl_renderbuffer **ptr,
    if (rb) {
       assert(rb->Magic == RB_MAGIC);
       /* reference new renderbuffer */
-      _glthread_LOCK_MUTEX(rb->Mutex);
-      rb->RefCount++;
+      p_atomic_inc(&rb->RefCount);
       /*printf("RB INCR %p (%d) to %d\n", (void*) rb, rb->Name, rb->RefCount);*/
-      _glthread_UNLOCK_MUTEX(rb->Mutex);
       *ptr = rb;
    }
 }
@@ -41,6 +41,7 @@
 #include "dlist.h"
 #include "shaderobj.h"
 #include "syncobj.h"
+#include "util/u_atomic.h"
 
 /**
  * Allocate and initialize a shared context state structure.
@@ -375,15 +376,9 @@ free_shared_state(struct gl_context *ctx, struct gl_shared_state *shared)
 void
 _mesa_release_shared_state(struct gl_context *ctx, struct gl_shared_state *shared)
 {
-   GLint RefCount;
+   assert(shared->RefCount > 0);
 
-   _glthread_LOCK_MUTEX(shared->Mutex);
-   RefCount = --shared->RefCount;
-   _glthread_UNLOCK_MUTEX(shared->Mutex);
-
-   assert(RefCount >= 0);
-
-   if (RefCount == 0) {
+   if (p_atomic_dec_zero(&shared->RefCount)) {
       /* free shared state */
       free_shared_state( ctx, shared );
    }
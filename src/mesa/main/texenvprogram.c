@@ -1596,6 +1596,11 @@ _mesa_get_fixed_func_fragment_program(struct gl_context *ctx)
    struct gl_fragment_program *prog;
    struct state_key key;
    GLuint keySize;
+   struct shared_state_key {
+      GLuint max_temps;
+      struct state_key key;
+   } shared_key;
+   GLuint sharedKeySize;
 	
    keySize = make_state_key(ctx, &key);
       
@@ -1604,10 +1609,30 @@ _mesa_get_fixed_func_fragment_program(struct gl_context *ctx)
                                  &key, keySize);
 
    if (!prog) {
-      prog = (struct gl_fragment_program *) 
-         ctx->Driver.NewProgram(ctx, GL_FRAGMENT_PROGRAM_ARB, 0);
+      /* Maybe another context already built it */
+      memset(&shared_key, 0, sizeof(shared_key));
+      shared_key.max_temps = ctx->Const.FragmentProgram.MaxTemps;
+      memcpy(&shared_key.key, &key, keySize);
+      sharedKeySize = offsetof(struct shared_state_key, key) + keySize;
+
+      prog = (struct gl_fragment_program *)
+         _mesa_search_shared_program_cache(ctx, GL_FRAGMENT_PROGRAM_ARB,
+                                           &shared_key, sharedKeySize);
+      if (prog) {
+         if (ctx->Driver.ProgramStringNotify)
+            ctx->Driver.ProgramStringNotify(ctx, GL_FRAGMENT_PROGRAM_ARB,
+                                            &prog->Base);
+      }
+      else {
+         prog = (struct gl_fragment_program *) 
+            ctx->Driver.NewProgram(ctx, GL_FRAGMENT_PROGRAM_ARB, 0);
 
-      create_new_program(ctx, &key, prog);
+         create_new_program(ctx, &key, prog);
+
+         _mesa_shared_program_cache_insert(ctx, GL_FRAGMENT_PROGRAM_ARB,
+                                           &shared_key, sharedKeySize,
+                                           &prog->Base);
+      }
 
       _mesa_program_cache_insert(ctx, ctx->FragmentProgram.Cache,
                                  &key, keySize, &prog->Base);
@@ -39,6 +39,7 @@
 #include "macros.h"
 #include "teximage.h"
 #include "texobj.h"
+#include "util/u_atomic.h"
 #include "mtypes.h"
 #include "program/prog_instruction.h"
 
@@ -56,7 +57,7 @@ struct gl_texture_object *
 _mesa_lookup_texture(struct gl_context *ctx, GLuint id)
 {
    return (struct gl_texture_object *)
-      _mesa_HashLookup(ctx->Shared->TexObjects, id);
+      _mesa_HashLookupCached(ctx->Shared->TexObjects, &ctx->TexObjCache, id);
 }
 
 
@@ -332,12 +333,8 @@ _mesa_reference_texobj(struct gl_texture_object **ptr,
       ASSERT(valid_texture_object(oldTex));
       (void) valid_texture_object; /* silence warning in release builds */
 
-      _glthread_LOCK_MUTEX(oldTex->Mutex);
       ASSERT(oldTex->RefCount > 0);
-      oldTex->RefCount--;
-
-      deleteFlag = (oldTex->RefCount == 0);
-      _glthread_UNLOCK_MUTEX(oldTex->Mutex);
+      deleteFlag = p_atomic_dec_zero(&oldTex->RefCount);
 
       if (deleteFlag) {
          GET_CURRENT_CONTEXT(ctx);
@@ -354,18 +351,16 @@ _mesa_reference_texobj(struct gl_texture_object **ptr,
    if (tex) {
       /* reference new texture */
       ASSERT(valid_texture_object(tex));
-      _glthread_LOCK_MUTEX(tex->Mutex);
-      if (tex->RefCount == 0) {
+      if (p_atomic_read(&tex->RefCount) == 0) {
          /* this texture's being deleted (look just above) */
          /* Not sure this can every really happen.  Warn if it does. */
          _mesa_problem(NULL, "referencing deleted texture object");
          *ptr = NULL;
       }
       else {
-         tex->RefCount++;
+         p_atomic_inc(&tex->RefCount);
          *ptr = tex;
       }
-      _glthread_UNLOCK_MUTEX(tex->Mutex);
    }
 }
 
@@ -1064,12 +1059,10 @@ _mesa_BindTexture( GLenum target, GLuint texName )
 
    assert(valid_texture_object(newTexObj));
 
-   _glthread_LOCK_MUTEX(ctx->Shared->Mutex);
-   if ((ctx->Shared->RefCount == 1)
+   if ((p_atomic_read(&ctx->Shared->RefCount) == 1)
        && (newTexObj == texUnit->CurrentTex[targetIndex])) {
       early_out = GL_TRUE;
    }
-   _glthread_UNLOCK_MUTEX(ctx->Shared->Mutex);
 
    if (early_out) {
       return;
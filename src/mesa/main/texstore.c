@@ -657,6 +657,129 @@ _mesa_make_temp_chan_image(struct gl_context *ctx, GLuint dims,
 }
 
 
+/**
+ * State for unpacking a source image one row at a time.
+ *
+ * This is the row-by-row counterpart of _mesa_make_temp_chan_image():
+ * instead of unpacking the whole image into a temporary buffer which is
+ * then converted into the texture, the texstore functions unpack one row,
+ * convert it straight into the destination (usually a mapped texture
+ * transfer) and move on.  Only a single row of temporary storage is
+ * needed, which stays in cache for large images.
+ */
+struct chan_row_unpacker
+{
+   struct gl_context *ctx;
+   GLuint dims;
+   GLenum logicalBaseFormat;
+   GLint srcWidth, srcHeight;
+   GLenum srcFormat, srcType;
+   const GLvoid *srcAddr;
+   const struct gl_pixelstore_attrib *srcPacking;
+   GLint logComponents, texComponents;
+   GLubyte map[6];
+   GLchan *row;      /**< row in the logical base format */
+   GLchan *texRow;   /**< row in the texture base format (may be == row) */
+};
+
+
+static GLboolean
+init_chan_row_unpacker(struct chan_row_unpacker *u,
+                       struct gl_context *ctx, GLuint dims,
+                       GLenum logicalBaseFormat,
+                       GLenum textureBaseFormat,
+                       GLint srcWidth, GLint srcHeight,
+                       GLenum srcFormat, GLenum srcType,
+                       const GLvoid *srcAddr,
+                       const struct gl_pixelstore_attrib *srcPacking)
+{
+   ASSERT(dims >= 1 && dims <= 3);
+
+   u->ctx = ctx;
+   u->dims = dims;
+   u->logicalBaseFormat = logicalBaseFormat;
+   u->srcWidth = srcWidth;
+   u->srcHeight = srcHeight;
+   u->srcFormat = srcFormat;
+   u->srcType = srcType;
+   u->srcAddr = srcAddr;
+   u->srcPacking = srcPacking;
+   u->logComponents = _mesa_components_in_format(logicalBaseFormat);
+   u->texComponents = _mesa_components_in_format(textureBaseFormat);
+
+   u->row = (GLchan *) malloc(srcWidth * u->logComponents * sizeof(GLchan));
+   if (!u->row)
+      return GL_FALSE;
+
+   if (logicalBaseFormat != textureBaseFormat) {
+      /* we only promote up to RGB, RGBA and LUMINANCE_ALPHA formats for now */
+      ASSERT(textureBaseFormat == GL_RGB || textureBaseFormat == GL_RGBA ||
+             textureBaseFormat == GL_LUMINANCE_ALPHA);
+      ASSERT(u->texComponents >= u->logComponents);
+
+      u->texRow = (GLchan *) malloc(srcWidth * u->texComponents *
+                                    sizeof(GLchan));
+      if (!u->texRow) {
+         free(u->row);
+         return GL_FALSE;
+      }
+      compute_component_mapping(logicalBaseFormat, textureBaseFormat, u->map);
+   }
+   else {
+      u->texRow = u->row;
+   }
+
+   return GL_TRUE;
+}
+
+
+/**
+ * Unpack row \p row of image \p img of the source.
+ * \return pointer to srcWidth pixels in the texture base format; only
+ *         valid until the next call.
+ */
+static const GLchan *
+unpack_chan_row(struct chan_row_unpacker *u, GLint img, GLint row)
+{
+   const GLvoid *src = _mesa_image_address(u->dims, u->srcPacking, u->srcAddr,
+                                           u->srcWidth, u->srcHeight,
+                                           u->srcFormat, u->srcType,
+                                           img, row, 0);
+
+   _mesa_unpack_color_span_chan(u->ctx, u->srcWidth, u->logicalBaseFormat,
+                                u->row, u->srcFormat, u->srcType, src,
+                                u->srcPacking, u->ctx->_ImageTransferState);
+
+   if (u->texRow != u->row) {
+      const GLint texComponents = u->texComponents;
+      const GLint logComponents = u->logComponents;
+      GLint i, k;
+      for (i = 0; i < u->srcWidth; i++) {
+         for (k = 0; k < texComponents; k++) {
+            GLint j = u->map[k];
+            if (j == ZERO)
+               u->texRow[i * texComponents + k] = 0;
+            else if (j == ONE)
+               u->texRow[i * texComponents + k] = CHAN_MAX;
+            else
+               u->texRow[i * texComponents + k] = u->row[i * logComponents + j];
+         }
+      }
+   }
+
+   return u->texRow;
+}
+
+
+static void
+fini_chan_row_unpacker(struct chan_row_unpacker *u)
+{
+   if (u->texRow != u->row)
+      free(u->texRow);
+   free(u->row);
+}
+
+
 /**
  * Copy GLubyte pixels from <src> to <dst> with swizzling.
  * \param dst  destination pixels
@@ -1230,15 +1353,12 @@ _mesa_texstore_rgb565(TEXSTORE_PARAMS)
    }
    else {
       /* general path */
-      const GLchan *tempImage = _mesa_make_temp_chan_image(ctx, dims,
-                                                 baseInternalFormat,
-                                                 baseFormat,
-                                                 srcWidth, srcHeight, srcDepth,
-                                                 srcFormat, srcType, srcAddr,
-                                                 srcPacking);
-      const GLchan *src = tempImage;
+      struct chan_row_unpacker rows;
       GLint img, row, col;
-      if (!tempImage)
+      if (!init_chan_row_unpacker(&rows, ctx, dims,
+                                  baseInternalFormat, baseFormat,
+                                  srcWidth, srcHeight,
+                                  srcFormat, srcType, srcAddr, srcPacking))
          return GL_FALSE;
       for (img = 0; img < srcDepth; img++) {
          GLubyte *dstRow = (GLubyte *) dstAddr
@@ -1246,6 +1366,7 @@ _mesa_texstore_rgb565(TEXSTORE_PARAMS)
             + dstYoffset * dstRowStride
             + dstXoffset * texelBytes;
          for (row = 0; row < srcHeight; row++) {
+            const GLchan *src = unpack_chan_row(&rows, img, row);
             GLushort *dstUS = (GLushort *) dstRow;
             /* check for byteswapped format */
             if (dstFormat == MESA_FORMAT_RGB565) {
@@ -1267,7 +1388,7 @@ _mesa_texstore_rgb565(TEXSTORE_PARAMS)
             dstRow += dstRowStride;
          }
       }
-      free((void *) tempImage);
+      fini_chan_row_unpacker(&rows);
    }
    return GL_TRUE;
 }
@@ -1356,15 +1477,12 @@ _mesa_texstore_rgba8888(TEXSTORE_PARAMS)
    }
    else {
       /* general path */
-      const GLchan *tempImage = _mesa_make_temp_chan_image(ctx, dims,
-                                                 baseInternalFormat,
-                                                 baseFormat,
-                                                 srcWidth, srcHeight, srcDepth,
-                                                 srcFormat, srcType, srcAddr,
-                                                 srcPacking);
-      const GLchan *src = tempImage;
+      struct chan_row_unpacker rows;
       GLint img, row, col;
-      if (!tempImage)
+      if (!init_chan_row_unpacker(&rows, ctx, dims,
+                                  baseInternalFormat, baseFormat,
+                                  srcWidth, srcHeight,
+                                  srcFormat, srcType, srcAddr, srcPacking))
          return GL_FALSE;
       for (img = 0; img < srcDepth; img++) {
          GLubyte *dstRow = (GLubyte *) dstAddr
@@ -1372,6 +1490,7 @@ _mesa_texstore_rgba8888(TEXSTORE_PARAMS)
             + dstYoffset * dstRowStride
             + dstXoffset * texelBytes;
          for (row = 0; row < srcHeight; row++) {
+            const GLchan *src = unpack_chan_row(&rows, img, row);
             GLuint *dstUI = (GLuint *) dstRow;
             if (dstFormat == MESA_FORMAT_RGBA8888) {
                for (col = 0; col < srcWidth; col++) {
@@ -1394,7 +1513,7 @@ _mesa_texstore_rgba8888(TEXSTORE_PARAMS)
             dstRow += dstRowStride;
          }
       }
-      free((void *) tempImage);
+      fini_chan_row_unpacker(&rows);
    }
    return GL_TRUE;
 }
@@ -1556,15 +1675,12 @@ _mesa_texstore_argb8888(TEXSTORE_PARAMS)
    }
    else {
       /* general path */
-      const GLchan *tempImage = _mesa_make_temp_chan_image(ctx, dims,
-                                                 baseInternalFormat,
-                                                 baseFormat,
-                                                 srcWidth, srcHeight, srcDepth,
-                                                 srcFormat, srcType, srcAddr,
-                                                 srcPacking);
-      const GLchan *src = tempImage;
+      struct chan_row_unpacker rows;
       GLint img, row, col;
-      if (!tempImage)
+      if (!init_chan_row_unpacker(&rows, ctx, dims,
+                                  baseInternalFormat, baseFormat,
+                                  srcWidth, srcHeight,
+                                  srcFormat, srcType, srcAddr, srcPacking))
          return GL_FALSE;
       for (img = 0; img < srcDepth; img++) {
          GLubyte *dstRow = (GLubyte *) dstAddr
@@ -1572,6 +1688,7 @@ _mesa_texstore_argb8888(TEXSTORE_PARAMS)
             + dstYoffset * dstRowStride
             + dstXoffset * texelBytes;
          for (row = 0; row < srcHeight; row++) {
+            const GLchan *src = unpack_chan_row(&rows, img, row);
             GLuint *dstUI = (GLuint *) dstRow;
             if (dstFormat == MESA_FORMAT_ARGB8888) {
                for (col = 0; col < srcWidth; col++) {
@@ -1603,7 +1720,7 @@ _mesa_texstore_argb8888(TEXSTORE_PARAMS)
             dstRow += dstRowStride;
          }
       }
-      free((void *) tempImage);
+      fini_chan_row_unpacker(&rows);
    }
    return GL_TRUE;
 }
@@ -1685,15 +1802,12 @@ _mesa_texstore_rgb888(TEXSTORE_PARAMS)
    }
    else {
       /* general path */
-      const GLchan *tempImage = _mesa_make_temp_chan_image(ctx, dims,
-                                                 baseInternalFormat,
-                                                 baseFormat,
-                                                 srcWidth, srcHeight, srcDepth,
-                                                 srcFormat, srcType, srcAddr,
-                                                 srcPacking);
-      const GLchan *src = (const GLchan *) tempImage;
+      struct chan_row_unpacker rows;
       GLint img, row, col;
-      if (!tempImage)
+      if (!init_chan_row_unpacker(&rows, ctx, dims,
+                                  baseInternalFormat, baseFormat,
+                                  srcWidth, srcHeight,
+                                  srcFormat, srcType, srcAddr, srcPacking))
          return GL_FALSE;
       for (img = 0; img < srcDepth; img++) {
          GLubyte *dstRow = (GLubyte *) dstAddr
@@ -1701,6 +1815,7 @@ _mesa_texstore_rgb888(TEXSTORE_PARAMS)
             + dstYoffset * dstRowStride
             + dstXoffset * texelBytes;
          for (row = 0; row < srcHeight; row++) {
+            const GLchan *src = unpack_chan_row(&rows, img, row);
 #if 0
             if (littleEndian) {
                for (col = 0; col < srcWidth; col++) {
@@ -1729,7 +1844,7 @@ _mesa_texstore_rgb888(TEXSTORE_PARAMS)
             dstRow += dstRowStride;
          }
       }
-      free((void *) tempImage);
+      fini_chan_row_unpacker(&rows);
    }
    return GL_TRUE;
 }
@@ -1811,15 +1926,12 @@ _mesa_texstore_bgr888(TEXSTORE_PARAMS)
    }   
    else {
       /* general path */
-      const GLchan *tempImage = _mesa_make_temp_chan_image(ctx, dims,
-                                                 baseInternalFormat,
-                                                 baseFormat,
-                                                 srcWidth, srcHeight, srcDepth,
-                                                 srcFormat, srcType, srcAddr,
-                                                 srcPacking);
-      const GLchan *src = (const GLchan *) tempImage;
+      struct chan_row_unpacker rows;
       GLint img, row, col;
-      if (!tempImage)
+      if (!init_chan_row_unpacker(&rows, ctx, dims,
+                                  baseInternalFormat, baseFormat,
+                                  srcWidth, srcHeight,
+                                  srcFormat, srcType, srcAddr, srcPacking))
          return GL_FALSE;
       for (img = 0; img < srcDepth; img++) {
          GLubyte *dstRow = (GLubyte *) dstAddr
@@ -1827,6 +1939,7 @@ _mesa_texstore_bgr888(TEXSTORE_PARAMS)
             + dstYoffset * dstRowStride
             + dstXoffset * texelBytes;
          for (row = 0; row < srcHeight; row++) {
+            const GLchan *src = unpack_chan_row(&rows, img, row);
             for (col = 0; col < srcWidth; col++) {
                dstRow[col * 3 + 0] = CHAN_TO_UBYTE(src[RCOMP]);
                dstRow[col * 3 + 1] = CHAN_TO_UBYTE(src[GCOMP]);
@@ -1836,7 +1949,7 @@ _mesa_texstore_bgr888(TEXSTORE_PARAMS)
             dstRow += dstRowStride;
          }
       }
-      free((void *) tempImage);
+      fini_chan_row_unpacker(&rows);
    }
    return GL_TRUE;
 }
@@ -1868,15 +1981,12 @@ _mesa_texstore_argb4444(TEXSTORE_PARAMS)
    }
    else {
       /* general path */
-      const GLchan *tempImage = _mesa_make_temp_chan_image(ctx, dims,
-                                                 baseInternalFormat,
-                                                 baseFormat,
-                                                 srcWidth, srcHeight, srcDepth,
-                                                 srcFormat, srcType, srcAddr,
-                                                 srcPacking);
-      const GLchan *src = tempImage;
+      struct chan_row_unpacker rows;
       GLint img, row, col;
-      if (!tempImage)
+      if (!init_chan_row_unpacker(&rows, ctx, dims,
+                                  baseInternalFormat, baseFormat,
+                                  srcWidth, srcHeight,
+                                  srcFormat, srcType, srcAddr, srcPacking))
          return GL_FALSE;
       for (img = 0; img < srcDepth; img++) {
          GLubyte *dstRow = (GLubyte *) dstAddr
@@ -1884,6 +1994,7 @@ _mesa_texstore_argb4444(TEXSTORE_PARAMS)
             + dstYoffset * dstRowStride
             + dstXoffset * texelBytes;
          for (row = 0; row < srcHeight; row++) {
+            const GLchan *src = unpack_chan_row(&rows, img, row);
             GLushort *dstUS = (GLushort *) dstRow;
             if (dstFormat == MESA_FORMAT_ARGB4444) {
                for (col = 0; col < srcWidth; col++) {
@@ -1906,7 +2017,7 @@ _mesa_texstore_argb4444(TEXSTORE_PARAMS)
             dstRow += dstRowStride;
          }
       }
-      free((void *) tempImage);
+      fini_chan_row_unpacker(&rows);
    }
    return GL_TRUE;
 }
@@ -1936,15 +2047,12 @@ _mesa_texstore_rgba5551(TEXSTORE_PARAMS)
    }
    else {
       /* general path */
-      const GLchan *tempImage = _mesa_make_temp_chan_image(ctx, dims,
-                                                 baseInternalFormat,
-                                                 baseFormat,
-                                                 srcWidth, srcHeight, srcDepth,
-                                                 srcFormat, srcType, srcAddr,
-                                                 srcPacking);
-      const GLchan *src =tempImage;
+      struct chan_row_unpacker rows;
       GLint img, row, col;
-      if (!tempImage)
+      if (!init_chan_row_unpacker(&rows, ctx, dims,
+                                  baseInternalFormat, baseFormat,
+                                  srcWidth, srcHeight,
+                                  srcFormat, srcType, srcAddr, srcPacking))
          return GL_FALSE;
       for (img = 0; img < srcDepth; img++) {
          GLubyte *dstRow = (GLubyte *) dstAddr
@@ -1952,6 +2060,7 @@ _mesa_texstore_rgba5551(TEXSTORE_PARAMS)
             + dstYoffset * dstRowStride
             + dstXoffset * texelBytes;
          for (row = 0; row < srcHeight; row++) {
+            const GLchan *src = unpack_chan_row(&rows, img, row);
             GLushort *dstUS = (GLushort *) dstRow;
 	    for (col = 0; col < srcWidth; col++) {
 	       dstUS[col] = PACK_COLOR_5551( CHAN_TO_UBYTE(src[RCOMP]),
@@ -1963,7 +2072,7 @@ _mesa_texstore_rgba5551(TEXSTORE_PARAMS)
             dstRow += dstRowStride;
          }
       }
-      free((void *) tempImage);
+      fini_chan_row_unpacker(&rows);
    }
    return GL_TRUE;
 }
@@ -1994,15 +2103,12 @@ _mesa_texstore_argb1555(TEXSTORE_PARAMS)
    }
    else {
       /* general path */
-      const GLchan *tempImage = _mesa_make_temp_chan_image(ctx, dims,
-                                                 baseInternalFormat,
-                                                 baseFormat,
-                                                 srcWidth, srcHeight, srcDepth,
-                                                 srcFormat, srcType, srcAddr,
-                                                 srcPacking);
-      const GLchan *src =tempImage;
+      struct chan_row_unpacker rows;
       GLint img, row, col;
-      if (!tempImage)
+      if (!init_chan_row_unpacker(&rows, ctx, dims,
+                                  baseInternalFormat, baseFormat,
+                                  srcWidth, srcHeight,
+                                  srcFormat, srcType, srcAddr, srcPacking))
          return GL_FALSE;
       for (img = 0; img < srcDepth; img++) {
          GLubyte *dstRow = (GLubyte *) dstAddr
@@ -2010,6 +2116,7 @@ _mesa_texstore_argb1555(TEXSTORE_PARAMS)
             + dstYoffset * dstRowStride
             + dstXoffset * texelBytes;
          for (row = 0; row < srcHeight; row++) {
+            const GLchan *src = unpack_chan_row(&rows, img, row);
             GLushort *dstUS = (GLushort *) dstRow;
             if (dstFormat == MESA_FORMAT_ARGB1555) {
                for (col = 0; col < srcWidth; col++) {
@@ -2032,7 +2139,7 @@ _mesa_texstore_argb1555(TEXSTORE_PARAMS)
             dstRow += dstRowStride;
          }
       }
-      free((void *) tempImage);
+      fini_chan_row_unpacker(&rows);
    }
    return GL_TRUE;
 }
@@ -2114,15 +2221,12 @@ _mesa_texstore_unorm88(TEXSTORE_PARAMS)
    }   
    else {
       /* general path */
-      const GLchan *tempImage = _mesa_make_temp_chan_image(ctx, dims,
-                                                 baseInternalFormat,
-                                                 baseFormat,
-                                                 srcWidth, srcHeight, srcDepth,
-                                                 srcFormat, srcType, srcAddr,
-                                                 srcPacking);
-      const GLchan *src = tempImage;
+      struct chan_row_unpacker rows;
       GLint img, row, col;
-      if (!tempImage)
+      if (!init_chan_row_unpacker(&rows, ctx, dims,
+                                  baseInternalFormat, baseFormat,
+                                  srcWidth, srcHeight,
+                                  srcFormat, srcType, srcAddr, srcPacking))
          return GL_FALSE;
       for (img = 0; img < srcDepth; img++) {
          GLubyte *dstRow = (GLubyte *) dstAddr
@@ -2130,6 +2234,7 @@ _mesa_texstore_unorm88(TEXSTORE_PARAMS)
             + dstYoffset * dstRowStride
             + dstXoffset * texelBytes;
          for (row = 0; row < srcHeight; row++) {
+            const GLchan *src = unpack_chan_row(&rows, img, row);
             GLushort *dstUS = (GLushort *) dstRow;
             if (dstFormat == MESA_FORMAT_AL88 ||
 		dstFormat == MESA_FORMAT_RG88) {
@@ -2151,7 +2256,7 @@ _mesa_texstore_unorm88(TEXSTORE_PARAMS)
             dstRow += dstRowStride;
          }
       }
-      free((void *) tempImage);
+      fini_chan_row_unpacker(&rows);
    }
    return GL_TRUE;
 }
@@ -2454,15 +2559,12 @@ _mesa_texstore_rgb332(TEXSTORE_PARAMS)
    }
    else {
       /* general path */
-      const GLchan *tempImage = _mesa_make_temp_chan_image(ctx, dims,
-                                                 baseInternalFormat,
-                                                 baseFormat,
-                                                 srcWidth, srcHeight, srcDepth,
-                                                 srcFormat, srcType, srcAddr,
-                                                 srcPacking);
-      const GLchan *src = tempImage;
+      struct chan_row_unpacker rows;
       GLint img, row, col;
-      if (!tempImage)
+      if (!init_chan_row_unpacker(&rows, ctx, dims,
+                                  baseInternalFormat, baseFormat,
+                                  srcWidth, srcHeight,
+                                  srcFormat, srcType, srcAddr, srcPacking))
          return GL_FALSE;
       for (img = 0; img < srcDepth; img++) {
          GLubyte *dstRow = (GLubyte *) dstAddr
@@ -2470,6 +2572,7 @@ _mesa_texstore_rgb332(TEXSTORE_PARAMS)
             + dstYoffset * dstRowStride
             + dstXoffset * texelBytes;
          for (row = 0; row < srcHeight; row++) {
+            const GLchan *src = unpack_chan_row(&rows, img, row);
             for (col = 0; col < srcWidth; col++) {
                dstRow[col] = PACK_COLOR_332( CHAN_TO_UBYTE(src[RCOMP]),
                                              CHAN_TO_UBYTE(src[GCOMP]),
@@ -2479,7 +2582,7 @@ _mesa_texstore_rgb332(TEXSTORE_PARAMS)
             dstRow += dstRowStride;
          }
       }
-      free((void *) tempImage);
+      fini_chan_row_unpacker(&rows);
    }
    return GL_TRUE;
 }
@@ -2542,15 +2645,12 @@ _mesa_texstore_a8(TEXSTORE_PARAMS)
    }   
    else {
       /* general path */
-      const GLchan *tempImage = _mesa_make_temp_chan_image(ctx, dims,
-                                                 baseInternalFormat,
-                                                 baseFormat,
-                                                 srcWidth, srcHeight, srcDepth,
-                                                 srcFormat, srcType, srcAddr,
-                                                 srcPacking);
-      const GLchan *src = tempImage;
+      struct chan_row_unpacker rows;
       GLint img, row, col;
-      if (!tempImage)
+      if (!init_chan_row_unpacker(&rows, ctx, dims,
+                                  baseInternalFormat, baseFormat,
+                                  srcWidth, srcHeight,
+                                  srcFormat, srcType, srcAddr, srcPacking))
          return GL_FALSE;
       for (img = 0; img < srcDepth; img++) {
          GLubyte *dstRow = (GLubyte *) dstAddr
@@ -2558,14 +2658,14 @@ _mesa_texstore_a8(TEXSTORE_PARAMS)
             + dstYoffset * dstRowStride
             + dstXoffset * texelBytes;
          for (row = 0; row < srcHeight; row++) {
+            const GLchan *src = unpack_chan_row(&rows, img, row);
             for (col = 0; col < srcWidth; col++) {
                dstRow[col] = CHAN_TO_UBYTE(src[col]);
             }
             dstRow += dstRowStride;
-            src += srcWidth;
          }
       }
-      free((void *) tempImage);
+      fini_chan_row_unpacker(&rows);
    }
    return GL_TRUE;
 }
@@ -29,6 +29,7 @@
 #include "main/glheader.h"
 #include "main/mtypes.h"
 #include "main/imports.h"
+#include "glapi/glthread.h"
 #include "program/prog_cache.h"
 #include "program/program.h"
 
@@ -204,3 +205,182 @@ _mesa_program_cache_insert(struct gl_context *ctx,
    c->next = cache->items[hash % cache->size];
    cache->items[hash % cache->size] = c;
 }
+
+
+
+/**
+ * Process-wide cache of generated fixed-function programs.
+ *
+ * Each context keeps its own gl_program_cache, so every new context used
+ * to generate (and optimize) the same fixed-function programs again.
+ * This cache is shared by all contexts and holds a core Mesa copy of
+ * every program generated; a context which misses its own cache gets a
+ * clone of it, made with its own ctx->Driver.NewProgram.  Translation to
+ * driver shaders still happens per context since driver objects can't be
+ * shared between contexts.
+ */
+/*@{*/
+
+#define SHARED_CACHE_MAX_ITEMS 1024
+
+struct shared_cache_item
+{
+   GLuint hash;
+   GLenum target;
+   GLuint keysize;
+   void *key;
+   struct gl_program *program;
+   struct shared_cache_item *next;
+};
+
+static struct {
+   struct shared_cache_item *items[257];
+   GLuint n_items;
+   GLuint hits, misses;
+} SharedCache;
+
+_glthread_DECLARE_STATIC_MUTEX(SharedCacheMutex);
+
+
+static struct shared_cache_item *
+shared_cache_lookup(GLenum target, GLuint hash, const void *key,
+                    GLuint keysize)
+{
+   struct shared_cache_item *c;
+
+   for (c = SharedCache.items[hash % Elements(SharedCache.items)];
+        c; c = c->next) {
+      if (c->hash == hash && c->target == target && c->keysize == keysize &&
+          memcmp(c->key, key, keysize) == 0)
+         return c;
+   }
+
+   return NULL;
+}
+
+
+/**
+ * Return a new program for 'ctx' cloned from the process-wide cache, or
+ * NULL if no context generated a program for this key yet.
+ */
+struct gl_program *
+_mesa_search_shared_program_cache(struct gl_context *ctx, GLenum target,
+                                  const void *key, GLuint keysize)
+{
+   const GLuint hash = hash_key(key, keysize);
+   struct shared_cache_item *c;
+   struct gl_program *prog = NULL;
+
+   _glthread_LOCK_MUTEX(SharedCacheMutex);
+   c = shared_cache_lookup(target, hash, key, keysize);
+   if (c) {
+      SharedCache.hits++;
+      prog = _mesa_clone_program(ctx, c->program);
+   }
+   else {
+      SharedCache.misses++;
+   }
+   _glthread_UNLOCK_MUTEX(SharedCacheMutex);
+
+   return prog;
+}
+
+
+/**
+ * Put a copy of a freshly generated program into the process-wide cache.
+ */
+void
+_mesa_shared_program_cache_insert(struct gl_context *ctx, GLenum target,
+                                  const void *key, GLuint keysize,
+                                  const struct gl_program *program)
+{
+   const GLuint hash = hash_key(key, keysize);
+   struct shared_cache_item *c;
+   struct gl_program *copy;
+   GLuint i;
+
+   copy = _mesa_new_program(ctx, program->Target, 0);
+   if (!copy)
+      return;
+   if (!_mesa_copy_program(copy, program)) {
+      copy->RefCount = 0;
+      _mesa_delete_program(NULL, copy);
+      return;
+   }
+
+   c = CALLOC_STRUCT(shared_cache_item);
+   if (c)
+      c->key = malloc(keysize);
+   if (!c || !c->key) {
+      free(c);
+      copy->RefCount = 0;
+      _mesa_delete_program(NULL, copy);
+      return;
+   }
+
+   c->hash = hash;
+   c->target = target;
+   c->keysize = keysize;
+   memcpy(c->key, key, keysize);
+   c->program = copy;
+
+   _glthread_LOCK_MUTEX(SharedCacheMutex);
+
+   if (shared_cache_lookup(target, hash, key, keysize)) {
+      /* another context got there first */
+      _glthread_UNLOCK_MUTEX(SharedCacheMutex);
+      free(c->key);
+      free(c);
+      copy->RefCount = 0;
+      _mesa_delete_program(NULL, copy);
+      return;
+   }
+
+   if (SharedCache.n_items >= SHARED_CACHE_MAX_ITEMS) {
+      struct shared_cache_item *next;
+
+      for (i = 0; i < Elements(SharedCache.items); i++) {
+         struct shared_cache_item *old;
+         for (old = SharedCache.items[i]; old; old = next) {
+            next = old->next;
+            old->program->RefCount = 0;
+            _mesa_delete_program(NULL, old->program);
+            free(old->key);
+            free(old);
+         }
+         SharedCache.items[i] = NULL;
+      }
+      SharedCache.n_items = 0;
+   }
+
+   i = hash % Elements(SharedCache.items);
+   c->next = SharedCache.items[i];
+   SharedCache.items[i] = c;
+   SharedCache.n_items++;
+
+   _glthread_UNLOCK_MUTEX(SharedCacheMutex);
+}
+
+
+/**
+ * Print the process-wide cache hit rate, for MESA_PROGRAM_CACHE_STATS.
+ */
+void
+_mesa_print_shared_program_cache_stats(void)
+{
+   GLuint hits, misses, n_items;
+
+   _glthread_LOCK_MUTEX(SharedCacheMutex);
+   hits = SharedCache.hits;
+   misses = SharedCache.misses;
+   n_items = SharedCache.n_items;
+   _glthread_UNLOCK_MUTEX(SharedCacheMutex);
+
+   _mesa_debug(NULL, "shared program cache: %u hits, %u misses "
+               "(%.1f%% hit rate), %u programs\n",
+               hits, misses,
+               hits + misses ? 100.0 * hits / (hits + misses) : 0.0,
+               n_items);
+}
+
+/*@}*/
@@ -54,5 +54,17 @@ _mesa_program_cache_insert(struct gl_context *ctx,
                            const void *key, GLuint keysize,
                            struct gl_program *program);
 
+extern struct gl_program *
+_mesa_search_shared_program_cache(struct gl_context *ctx, GLenum target,
+                                  const void *key, GLuint keysize);
+
+extern void
+_mesa_shared_program_cache_insert(struct gl_context *ctx, GLenum target,
+                                  const void *key, GLuint keysize,
+                                  const struct gl_program *program);
+
+extern void
+_mesa_print_shared_program_cache_stats(void);
+
 
 #endif /* PROG_CACHE_H */
@@ -36,6 +36,7 @@
 #include "prog_cache.h"
 #include "prog_parameter.h"
 #include "prog_instruction.h"
+#include "util/u_atomic.h"
 
 
 /**
@@ -130,6 +131,9 @@ _mesa_init_program(struct gl_context *ctx)
 void
 _mesa_free_program_data(struct gl_context *ctx)
 {
+   if (_mesa_getenv("MESA_PROGRAM_CACHE_STATS"))
+      _mesa_print_shared_program_cache_stats();
+
 #if FEATURE_NV_vertex_program || FEATURE_ARB_vertex_program
    _mesa_reference_vertprog(ctx, &ctx->VertexProgram.Current, NULL);
    _mesa_delete_program_cache(ctx, ctx->VertexProgram.Cache);
@@ -409,7 +413,8 @@ struct gl_program *
 _mesa_lookup_program(struct gl_context *ctx, GLuint id)
 {
    if (id)
-      return (struct gl_program *) _mesa_HashLookup(ctx->Shared->Programs, id);
+      return (struct gl_program *)
+         _mesa_HashLookupCached(ctx->Shared->Programs, &ctx->ProgramCache, id);
    else
       return NULL;
 }
@@ -449,9 +454,7 @@ _mesa_reference_program(struct gl_context *ctx,
              (*ptr)->RefCount - 1);
 #endif
       ASSERT((*ptr)->RefCount > 0);
-      (*ptr)->RefCount--;
-
-      deleteFlag = ((*ptr)->RefCount == 0);
+      deleteFlag = p_atomic_dec_zero(&(*ptr)->RefCount);
       /*_glthread_UNLOCK_MUTEX((*ptr)->Mutex);*/
 
       if (deleteFlag) {
@@ -465,7 +468,7 @@ _mesa_reference_program(struct gl_context *ctx,
    assert(!*ptr);
    if (prog) {
       /*_glthread_LOCK_MUTEX(prog->Mutex);*/
-      prog->RefCount++;
+      p_atomic_inc(&prog->RefCount);
 #if 0
       printf("Program %p ID=%u Target=%s  Refcount++ to %d\n",
              prog, prog->Id,
@@ -481,29 +484,19 @@ _mesa_reference_program(struct gl_context *ctx,
 
 
 /**
- * Return a copy of a program.
- * XXX Problem here if the program object is actually OO-derivation
- * made by a device driver.
+ * Copy the contents of program 'prog' into the new program 'clone'.
+ * \return GL_FALSE if out of memory
  */
-struct gl_program *
-_mesa_clone_program(struct gl_context *ctx, const struct gl_program *prog)
+GLboolean
+_mesa_copy_program(struct gl_program *clone, const struct gl_program *prog)
 {
-   struct gl_program *clone;
-
-   clone = ctx->Driver.NewProgram(ctx, prog->Target, prog->Id);
-   if (!clone)
-      return NULL;
-
    assert(clone->Target == prog->Target);
-   assert(clone->RefCount == 1);
 
    clone->String = (GLubyte *) _mesa_strdup((char *) prog->String);
    clone->Format = prog->Format;
    clone->Instructions = _mesa_alloc_instructions(prog->NumInstructions);
-   if (!clone->Instructions) {
-      _mesa_reference_program(ctx, &clone, NULL);
-      return NULL;
-   }
+   if (!clone->Instructions)
+      return GL_FALSE;
    _mesa_copy_instructions(clone->Instructions, prog->Instructions,
                            prog->NumInstructions);
    clone->InputsRead = prog->InputsRead;
@@ -511,6 +504,9 @@ _mesa_clone_program(struct gl_context *ctx, const struct gl_program *prog)
    clone->SamplersUsed = prog->SamplersUsed;
    clone->ShadowSamplers = prog->ShadowSamplers;
    memcpy(clone->TexturesUsed, prog->TexturesUsed, sizeof(prog->TexturesUsed));
+   memcpy(clone->InputFlags, prog->InputFlags, sizeof(prog->InputFlags));
+   memcpy(clone->OutputFlags, prog->OutputFlags, sizeof(prog->OutputFlags));
+   memcpy(clone->SamplerUnits, prog->SamplerUnits, sizeof(prog->SamplerUnits));
 
    if (prog->Parameters)
       clone->Parameters = _mesa_clone_parameter_list(prog->Parameters);
@@ -573,6 +569,32 @@ _mesa_clone_program(struct gl_context *ctx, const struct gl_program *prog)
       _mesa_problem(NULL, "Unexpected target in _mesa_clone_program");
    }
 
+   return GL_TRUE;
+}
+
+
+/**
+ * Return a copy of a program.
+ * XXX Problem here if the program object is actually OO-derivation
+ * made by a device driver.
+ */
+struct gl_program *
+_mesa_clone_program(struct gl_context *ctx, const struct gl_program *prog)
+{
+   struct gl_program *clone;
+
+   clone = ctx->Driver.NewProgram(ctx, prog->Target, prog->Id);
+   if (!clone)
+      return NULL;
+
+   assert(clone->Target == prog->Target);
+   assert(clone->RefCount == 1);
+
+   if (!_mesa_copy_program(clone, prog)) {
+      _mesa_reference_program(ctx, &clone, NULL);
+      return NULL;
+   }
+
    return clone;
 }
 
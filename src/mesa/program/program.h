@@ -120,6 +120,9 @@ _mesa_reference_geomprog(struct gl_context *ctx,
                            (struct gl_program *) prog);
 }
 
+extern GLboolean
+_mesa_copy_program(struct gl_program *clone, const struct gl_program *prog);
+
 extern struct gl_program *
 _mesa_clone_program(struct gl_context *ctx, const struct gl_program *prog);
 
@@ -130,6 +130,7 @@ SWRAST_SOURCES = \
 	swrast/s_feedback.c \
 	swrast/s_fog.c \
 	swrast/s_fragprog.c \
+	swrast/s_fragprog_soa.c \
 	swrast/s_lines.c \
 	swrast/s_logic.c \
 	swrast/s_masking.c \
@@ -226,6 +227,7 @@ STATETRACKER_SOURCES = \
 	state_tracker/st_gen_mipmap.c \
 	state_tracker/st_manager.c \
 	state_tracker/st_mesa_to_tgsi.c \
+	state_tracker/st_precompile.c \
 	state_tracker/st_program.c \
 	state_tracker/st_texture.c
 
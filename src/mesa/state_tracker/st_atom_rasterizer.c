@@ -76,7 +76,8 @@ static void update_raster_state( struct st_context *st )
        * Flipping Y changes CW to CCW and vice-versa.
        * But this is an implementation/driver-specific artifact - remove...
        */
-      if (ctx->DrawBuffer && ctx->DrawBuffer->Name != 0)
+      if (ctx->DrawBuffer &&
+          st_fb_orientation(ctx->DrawBuffer) == Y_0_BOTTOM)
          raster->front_ccw ^= 1;
    }
 
@@ -41,14 +41,18 @@
 #include "st_atom.h"
 #include "st_atom_constbuf.h"
 #include "st_program.h"
+#include "st_precompile.h"
 #include "st_cb_bitmap.h"
 #include "st_texture.h"
+#include "st_debug.h"
 
 #include "pipe/p_context.h"
 #include "pipe/p_defines.h"
 #include "pipe/p_shader_tokens.h"
 #include "util/u_inlines.h"
+#include "util/u_box.h"
 #include "util/u_draw_quad.h"
+#include "util/u_hash.h"
 #include "util/u_simple_shaders.h"
 #include "program/prog_instruction.h"
 #include "cso_cache/cso_context.h"
@@ -70,36 +74,74 @@
 
 
 /**
- * The bitmap cache attempts to accumulate multiple glBitmap calls in a
- * buffer which is then rendered en mass upon a flush, state change, etc.
- * A wide, short buffer is used to target the common case of a series
- * of glBitmap calls being used to draw text.
+ * The bitmap cache works like a glyph cache: small bitmaps are stored
+ * in a persistent atlas texture, keyed by their contents, and kept there
+ * across frames.  Successive glBitmap calls with the same color and Z
+ * only append a quad referencing the atlas; the quads are drawn all at
+ * once upon a flush, state change, etc.  So a typical glCallLists() text
+ * string is one draw and, once its glyphs are in the atlas, no texture
+ * upload at all.
  */
 static GLboolean UseBitmapCache = GL_TRUE;
 
 
-#define BITMAP_CACHE_WIDTH  512
-#define BITMAP_CACHE_HEIGHT 32
+#define BITMAP_ATLAS_WIDTH   512
+#define BITMAP_ATLAS_HEIGHT  512
+
+/** Largest bitmap put into the atlas, others are drawn on their own */
+#define BITMAP_ATLAS_MAX_SIZE 64
+
+#define BITMAP_ATLAS_MAX_ENTRIES 2048
+#define BITMAP_ATLAS_HASH_SIZE   1024   /* power of two */
+
+/** Max quads drawn per flush */
+#define BITMAP_CACHE_MAX_QUADS 256
+
+struct bitmap_atlas_entry
+{
+   unsigned hash;
+   GLushort width, height;
+   GLushort x, y;          /**< position in the atlas */
+   GLint next;             /**< next entry in the hash chain, or -1 */
+};
+
+struct bitmap_quad
+{
+   GLint x, y;             /**< window position */
+   GLuint entry;           /**< atlas entry */
+};
 
 struct bitmap_cache
 {
-   /** Window pos to render the cached image */
-   GLint xpos, ypos;
-   /** Bounds of region used in window coords */
-   GLint xmin, ymin, xmax, ymax;
+   /** Quads pending to be drawn, all with the same color and Z */
+   struct bitmap_quad quads[BITMAP_CACHE_MAX_QUADS];
+   GLuint num_quads;
 
    GLfloat color[4];
 
    /** Bitmap's Z position */
    GLfloat zpos;
 
+   /** Vertex data for the pending quads */
+   GLfloat vertices[BITMAP_CACHE_MAX_QUADS * 4][3][4];
+
+   /** The atlas texture and its image in system memory */
    struct pipe_resource *texture;
-   struct pipe_transfer *trans;
+   struct pipe_sampler_view *sampler_view;
+   ubyte *image;
+
+   /** Rows of the image not yet uploaded to the texture */
+   GLint dirty_ymin, dirty_ymax;
 
-   GLboolean empty;
+   /** Shelf allocator: current shelf position and height */
+   GLuint shelf_x, shelf_y, shelf_height;
 
-   /** An I8 texture image: */
-   ubyte *buffer;
+   struct bitmap_atlas_entry entries[BITMAP_ATLAS_MAX_ENTRIES];
+   GLuint num_entries;
+   GLint buckets[BITMAP_ATLAS_HASH_SIZE];
+
+   /** Statistics for ST_DEBUG=bitmap, reset on each st_flush_bitmap() */
+   GLuint num_bitmaps, num_draws, num_uploads;
 };
 
 
@@ -185,12 +227,13 @@ find_free_bit(uint bitfield)
 
 /**
  * Combine basic bitmap fragment program with the user-defined program.
+ * The result is kept with the user program.
  */
-static struct st_fragment_program *
-combined_bitmap_fragment_program(struct gl_context *ctx)
+struct st_fragment_program *
+st_get_bitmap_fragment_program(struct st_context *st,
+                               struct st_fragment_program *stfp)
 {
-   struct st_context *st = st_context(ctx);
-   struct st_fragment_program *stfp = st->fp;
+   struct gl_context *ctx = st->ctx;
 
    if (!stfp->bitmap_program) {
       /*
@@ -200,7 +243,7 @@ combined_bitmap_fragment_program(struct gl_context *ctx)
       struct st_fragment_program *bitmap_prog;
       uint sampler;
 
-      sampler = find_free_bit(st->fp->Base.Base.SamplersUsed);
+      sampler = find_free_bit(stfp->Base.Base.SamplersUsed);
       bitmap_prog = make_bitmap_fragment_program(ctx, sampler);
 
       stfp->bitmap_program = (struct st_fragment_program *)
@@ -224,12 +267,23 @@ combined_bitmap_fragment_program(struct gl_context *ctx)
 
       /* translate to TGSI tokens */
       st_translate_fragment_program(st, stfp->bitmap_program);
+
+      st_record_program_variant(st, &stfp->tgsi, ST_VARIANT_FP_BITMAP);
    }
 
    return stfp->bitmap_program;
 }
 
 
+static struct st_fragment_program *
+combined_bitmap_fragment_program(struct gl_context *ctx)
+{
+   struct st_context *st = st_context(ctx);
+
+   return st_get_bitmap_fragment_program(st, st->fp);
+}
+
+
 /**
  * Copy user-provide bitmap bits into texture buffer, expanding
  * bits into texels.
@@ -400,20 +454,17 @@ setup_bitmap_vertex_data(struct st_context *st, bool normalized,
 
 
 /**
- * Render a glBitmap by drawing a textured quad
+ * Bind the state for drawing bitmaps with the given texture and color.
+ * Must be followed by end_bitmap_draw().
  */
 static void
-draw_bitmap_quad(struct gl_context *ctx, GLint x, GLint y, GLfloat z,
-                 GLsizei width, GLsizei height,
-                 struct pipe_sampler_view *sv,
-                 const GLfloat *color)
+begin_bitmap_draw(struct gl_context *ctx,
+                  struct pipe_sampler_view *sv,
+                  const GLfloat *color)
 {
    struct st_context *st = st_context(ctx);
-   struct pipe_context *pipe = st->pipe;
    struct cso_context *cso = st->cso_context;
    struct st_fragment_program *stfp;
-   GLuint maxSize;
-   GLuint offset;
 
    stfp = combined_bitmap_fragment_program(ctx);
 
@@ -432,15 +483,6 @@ draw_bitmap_quad(struct gl_context *ctx, GLint x, GLint y, GLfloat z,
       COPY_4V(ctx->Current.Attrib[VERT_ATTRIB_COLOR0], colorSave);
    }
 
-
-   /* limit checks */
-   /* XXX if the bitmap is larger than the max texture size, break
-    * it up into chunks.
-    */
-   maxSize = 1 << (pipe->screen->get_param(pipe->screen, PIPE_CAP_MAX_TEXTURE_2D_LEVELS) - 1);
-   assert(width <= (GLsizei)maxSize);
-   assert(height <= (GLsizei)maxSize);
-
    cso_save_rasterizer(cso);
    cso_save_samplers(cso);
    cso_save_fragment_sampler_views(cso);
@@ -499,18 +541,13 @@ draw_bitmap_quad(struct gl_context *ctx, GLint x, GLint y, GLfloat z,
    }
 
    cso_set_vertex_elements(cso, 3, st->velems_util_draw);
+}
 
-   /* convert Z from [0,1] to [-1,-1] to match viewport Z scale/bias */
-   z = z * 2.0 - 1.0;
-
-   /* draw textured quad */
-   offset = setup_bitmap_vertex_data(st, sv->texture->target != PIPE_TEXTURE_RECT, x, y, width, height, z, color);
-
-   util_draw_vertex_buffer(pipe, st->bitmap.vbuf, offset,
-                           PIPE_PRIM_TRIANGLE_FAN,
-                           4,  /* verts */
-                           3); /* attribs/vert */
 
+static void
+end_bitmap_draw(struct st_context *st)
+{
+   struct cso_context *cso = st->cso_context;
 
    /* restore state */
    cso_restore_rasterizer(cso);
@@ -523,76 +560,242 @@ draw_bitmap_quad(struct gl_context *ctx, GLint x, GLint y, GLfloat z,
 }
 
 
+/**
+ * Render a glBitmap by drawing a textured quad
+ */
 static void
-reset_cache(struct st_context *st)
+draw_bitmap_quad(struct gl_context *ctx, GLint x, GLint y, GLfloat z,
+                 GLsizei width, GLsizei height,
+                 struct pipe_sampler_view *sv,
+                 const GLfloat *color)
 {
+   struct st_context *st = st_context(ctx);
    struct pipe_context *pipe = st->pipe;
+   GLuint maxSize;
+   GLuint offset;
+
+   /* limit checks */
+   /* XXX if the bitmap is larger than the max texture size, break
+    * it up into chunks.
+    */
+   maxSize = 1 << (pipe->screen->get_param(pipe->screen, PIPE_CAP_MAX_TEXTURE_2D_LEVELS) - 1);
+   assert(width <= (GLsizei)maxSize);
+   assert(height <= (GLsizei)maxSize);
+
+   begin_bitmap_draw(ctx, sv, color);
+
+   /* convert Z from [0,1] to [-1,-1] to match viewport Z scale/bias */
+   z = z * 2.0 - 1.0;
+
+   /* draw textured quad */
+   offset = setup_bitmap_vertex_data(st, sv->texture->target != PIPE_TEXTURE_RECT, x, y, width, height, z, color);
+
+   util_draw_vertex_buffer(pipe, st->bitmap.vbuf, offset,
+                           PIPE_PRIM_TRIANGLE_FAN,
+                           4,  /* verts */
+                           3); /* attribs/vert */
+
+   end_bitmap_draw(st);
+}
+
+
+/**
+ * Empty the atlas.  Only called when nothing is pending.
+ */
+static void
+reset_atlas(struct st_context *st)
+{
    struct bitmap_cache *cache = st->bitmap.cache;
+   GLuint i;
+
+   assert(cache->num_quads == 0);
 
-   /*memset(cache->buffer, 0xff, sizeof(cache->buffer));*/
-   cache->empty = GL_TRUE;
+   cache->num_entries = 0;
+   for (i = 0; i < BITMAP_ATLAS_HASH_SIZE; i++)
+      cache->buckets[i] = -1;
 
-   cache->xmin = 1000000;
-   cache->xmax = -1000000;
-   cache->ymin = 1000000;
-   cache->ymax = -1000000;
+   cache->shelf_x = 0;
+   cache->shelf_y = 0;
+   cache->shelf_height = 0;
 
-   if (cache->trans) {
-      pipe->transfer_destroy(pipe, cache->trans);
-      cache->trans = NULL;
+   /* Unused texels must be "off" too, glyphs are padded with them */
+   memset(cache->image, 0xff, BITMAP_ATLAS_WIDTH * BITMAP_ATLAS_HEIGHT);
+   cache->dirty_ymin = 0;
+   cache->dirty_ymax = BITMAP_ATLAS_HEIGHT;
+}
+
+
+/**
+ * Find room for a width x height image in the atlas, leaving a one
+ * texel border so that neighbours never bleed in.
+ * \return  GL_FALSE if the atlas is full.
+ */
+static GLboolean
+alloc_atlas_space(struct bitmap_cache *cache, GLuint width, GLuint height,
+                  GLuint *x, GLuint *y)
+{
+   width += 1;
+   height += 1;
+
+   if (cache->shelf_x + width > BITMAP_ATLAS_WIDTH) {
+      /* start a new shelf */
+      cache->shelf_y += cache->shelf_height;
+      cache->shelf_x = 0;
+      cache->shelf_height = 0;
    }
 
-   assert(!cache->texture);
+   if (cache->shelf_y + height > BITMAP_ATLAS_HEIGHT)
+      return GL_FALSE;
+
+   *x = cache->shelf_x;
+   *y = cache->shelf_y;
 
-   /* allocate a new texture */
-   cache->texture = st_texture_create(st, PIPE_TEXTURE_2D,
-                                      st->bitmap.tex_format, 0,
-                                      BITMAP_CACHE_WIDTH, BITMAP_CACHE_HEIGHT,
-                                      1,
-				      PIPE_BIND_SAMPLER_VIEW);
+   cache->shelf_x += width;
+   if (height > cache->shelf_height)
+      cache->shelf_height = height;
+
+   return GL_TRUE;
 }
 
 
-/** Print bitmap image to stdout (debug) */
-static void
-print_cache(const struct bitmap_cache *cache)
+/**
+ * Look up an expanded bitmap image in the atlas, adding it if needed.
+ * \return  entry index, or -1 if the atlas is full.
+ */
+static GLint
+atlas_lookup(struct st_context *st, const ubyte *image,
+             GLsizei width, GLsizei height)
 {
-   int i, j, k;
-
-   for (i = 0; i < BITMAP_CACHE_HEIGHT; i++) {
-      k = BITMAP_CACHE_WIDTH * (BITMAP_CACHE_HEIGHT - i - 1);
-      for (j = 0; j < BITMAP_CACHE_WIDTH; j++) {
-         if (cache->buffer[k])
-            printf("X");
-         else
-            printf(" ");
-         k++;
+   struct bitmap_cache *cache = st->bitmap.cache;
+   const unsigned hash = util_hash_crc32(image, width * height) ^
+                         (width << 16) ^ height;
+   struct bitmap_atlas_entry *entry;
+   GLint i, row;
+   GLuint x, y;
+
+   for (i = cache->buckets[hash & (BITMAP_ATLAS_HASH_SIZE - 1)];
+        i >= 0; i = entry->next) {
+      entry = &cache->entries[i];
+      if (entry->hash == hash &&
+          entry->width == width &&
+          entry->height == height) {
+         const ubyte *src = image;
+         const ubyte *dst = cache->image +
+                            entry->y * BITMAP_ATLAS_WIDTH + entry->x;
+         for (row = 0; row < height; row++) {
+            if (memcmp(src, dst, width) != 0)
+               break;
+            src += width;
+            dst += BITMAP_ATLAS_WIDTH;
+         }
+         if (row == height)
+            return i;
       }
-      printf("\n");
    }
+
+   if (cache->num_entries == BITMAP_ATLAS_MAX_ENTRIES ||
+       !alloc_atlas_space(cache, width, height, &x, &y))
+      return -1;
+
+   i = cache->num_entries++;
+   entry = &cache->entries[i];
+   entry->hash = hash;
+   entry->width = width;
+   entry->height = height;
+   entry->x = x;
+   entry->y = y;
+   entry->next = cache->buckets[hash & (BITMAP_ATLAS_HASH_SIZE - 1)];
+   cache->buckets[hash & (BITMAP_ATLAS_HASH_SIZE - 1)] = i;
+
+   for (row = 0; row < height; row++) {
+      memcpy(cache->image + (y + row) * BITMAP_ATLAS_WIDTH + x,
+             image + row * width, width);
+   }
+
+   cache->dirty_ymin = MIN2(cache->dirty_ymin, (GLint) y);
+   cache->dirty_ymax = MAX2(cache->dirty_ymax, (GLint) (y + height));
+
+   return i;
 }
 
 
+/**
+ * Upload the rows of the atlas image which changed since the last flush.
+ */
 static void
-create_cache_trans(struct st_context *st)
+upload_atlas(struct st_context *st)
 {
    struct pipe_context *pipe = st->pipe;
    struct bitmap_cache *cache = st->bitmap.cache;
+   struct pipe_box box;
 
-   if (cache->trans)
+   if (cache->dirty_ymin >= cache->dirty_ymax)
       return;
 
-   /* Map the texture transfer.
-    * Subsequent glBitmap calls will write into the texture image.
-    */
-   cache->trans = pipe_get_transfer(st->pipe, cache->texture, 0, 0,
-                                    PIPE_TRANSFER_WRITE, 0, 0,
-                                    BITMAP_CACHE_WIDTH,
-                                    BITMAP_CACHE_HEIGHT);
-   cache->buffer = pipe_transfer_map(pipe, cache->trans);
-
-   /* init image to all 0xff */
-   memset(cache->buffer, 0xff, cache->trans->stride * BITMAP_CACHE_HEIGHT);
+   u_box_2d(0, cache->dirty_ymin,
+            BITMAP_ATLAS_WIDTH, cache->dirty_ymax - cache->dirty_ymin,
+            &box);
+
+   pipe->transfer_inline_write(pipe, cache->texture, 0,
+                               PIPE_TRANSFER_WRITE, &box,
+                               cache->image +
+                               cache->dirty_ymin * BITMAP_ATLAS_WIDTH,
+                               BITMAP_ATLAS_WIDTH, 0);
+
+   cache->dirty_ymin = BITMAP_ATLAS_HEIGHT;
+   cache->dirty_ymax = 0;
+   cache->num_uploads++;
+}
+
+
+/**
+ * Fill in the vertex data for the pending quads.
+ */
+static void
+setup_cache_vertex_data(struct st_context *st)
+{
+   struct bitmap_cache *cache = st->bitmap.cache;
+   const struct gl_framebuffer *fb = st->ctx->DrawBuffer;
+   const GLfloat xscale = 2.0f / (GLfloat) fb->Width;
+   const GLfloat yscale = 2.0f / (GLfloat) fb->Height;
+   const GLfloat sscale = 1.0f / BITMAP_ATLAS_WIDTH;
+   const GLfloat tscale = 1.0f / BITMAP_ATLAS_HEIGHT;
+   /* convert Z from [0,1] to [-1,-1] to match viewport Z scale/bias */
+   const GLfloat z = cache->zpos * 2.0f - 1.0f;
+   GLfloat (*v)[3][4] = cache->vertices;
+   GLuint i, j;
+
+   for (i = 0; i < cache->num_quads; i++) {
+      const struct bitmap_quad *quad = &cache->quads[i];
+      const struct bitmap_atlas_entry *entry = &cache->entries[quad->entry];
+      /* Positions are in clip coords since we need to do clipping in
+       * case the bitmap quad goes beyond the window bounds.
+       */
+      const GLfloat x0 = quad->x * xscale - 1.0f;
+      const GLfloat y0 = quad->y * yscale - 1.0f;
+      const GLfloat x1 = (quad->x + entry->width) * xscale - 1.0f;
+      const GLfloat y1 = (quad->y + entry->height) * yscale - 1.0f;
+      const GLfloat s0 = entry->x * sscale;
+      const GLfloat t0 = entry->y * tscale;
+      const GLfloat s1 = (entry->x + entry->width) * sscale;
+      const GLfloat t1 = (entry->y + entry->height) * tscale;
+
+      v[0][0][0] = x0;  v[0][0][1] = y0;  v[0][2][0] = s0;  v[0][2][1] = t0;
+      v[1][0][0] = x1;  v[1][0][1] = y0;  v[1][2][0] = s1;  v[1][2][1] = t0;
+      v[2][0][0] = x1;  v[2][0][1] = y1;  v[2][2][0] = s1;  v[2][2][1] = t1;
+      v[3][0][0] = x0;  v[3][0][1] = y1;  v[3][2][0] = s0;  v[3][2][1] = t1;
+
+      /* same for all verts: */
+      for (j = 0; j < 4; j++) {
+         v[j][0][2] = z;
+         v[j][0][3] = 1.0f;
+         COPY_4V(v[j][1], cache->color);
+         v[j][2][2] = 0.0f; /*R*/
+         v[j][2][3] = 1.0f; /*Q*/
+      }
+
+      v += 4;
+   }
 }
 
 
@@ -602,53 +805,38 @@ create_cache_trans(struct st_context *st)
 void
 st_flush_bitmap_cache(struct st_context *st)
 {
-   if (!st->bitmap.cache->empty) {
-      struct bitmap_cache *cache = st->bitmap.cache;
-
-      if (st->ctx->DrawBuffer) {
-         struct pipe_context *pipe = st->pipe;
-         struct pipe_sampler_view *sv;
-
-         assert(cache->xmin <= cache->xmax);
- 
-/*         printf("flush size %d x %d  at %d, %d\n",
-                cache->xmax - cache->xmin,
-                cache->ymax - cache->ymin,
-                cache->xpos, cache->ypos);
-*/
-
-         /* The texture transfer has been mapped until now.
-          * So unmap and release the texture transfer before drawing.
-          */
-         if (cache->trans) {
-            if (0)
-               print_cache(cache);
-            pipe_transfer_unmap(pipe, cache->trans);
-            cache->buffer = NULL;
-
-            pipe->transfer_destroy(pipe, cache->trans);
-            cache->trans = NULL;
-         }
+   struct bitmap_cache *cache = st->bitmap.cache;
 
-         sv = st_create_texture_sampler_view(st->pipe, cache->texture);
-         if (sv) {
-            draw_bitmap_quad(st->ctx,
-                             cache->xpos,
-                             cache->ypos,
-                             cache->zpos,
-                             BITMAP_CACHE_WIDTH, BITMAP_CACHE_HEIGHT,
-                             sv,
-                             cache->color);
-
-            pipe_sampler_view_reference(&sv, NULL);
-         }
-      }
+   if (!cache || cache->num_quads == 0)
+      return;
 
-      /* release/free the texture */
-      pipe_resource_reference(&cache->texture, NULL);
+   if (st->ctx->DrawBuffer) {
+      struct pipe_context *pipe = st->pipe;
+      struct pipe_resource *vbuf;
+
+      upload_atlas(st);
+      setup_cache_vertex_data(st);
+
+      vbuf = pipe_user_buffer_create(pipe->screen, cache->vertices,
+                                     cache->num_quads * 4 *
+                                     sizeof(cache->vertices[0]),
+                                     PIPE_BIND_VERTEX_BUFFER);
+      if (vbuf) {
+         begin_bitmap_draw(st->ctx, cache->sampler_view, cache->color);
+
+         util_draw_vertex_buffer(pipe, vbuf, 0,
+                                 PIPE_PRIM_QUADS,
+                                 cache->num_quads * 4,  /* verts */
+                                 3);                    /* attribs/vert */
 
-      reset_cache(st);
+         end_bitmap_draw(st);
+
+         pipe_resource_reference(&vbuf, NULL);
+         cache->num_draws++;
+      }
    }
+
+   cache->num_quads = 0;
 }
 
 /* Flush bitmap cache and release vertex buffer.
@@ -656,8 +844,19 @@ st_flush_bitmap_cache(struct st_context *st)
 void
 st_flush_bitmap( struct st_context *st )
 {
+   struct bitmap_cache *cache = st->bitmap.cache;
+
    st_flush_bitmap_cache(st);
 
+   if (cache && cache->num_bitmaps) {
+      ST_DBG(DEBUG_BITMAP, "st/bitmap: %u bitmaps, %u draws, %u uploads, "
+             "%u atlas entries\n", cache->num_bitmaps, cache->num_draws,
+             cache->num_uploads, cache->num_entries);
+      cache->num_bitmaps = 0;
+      cache->num_draws = 0;
+      cache->num_uploads = 0;
+   }
+
    /* Release vertex buffer to avoid synchronous rendering if we were
     * to map it in the next frame.
     */
@@ -677,56 +876,55 @@ accum_bitmap(struct st_context *st,
              const GLubyte *bitmap )
 {
    struct bitmap_cache *cache = st->bitmap.cache;
-   int px = -999, py = -999;
    const GLfloat z = st->ctx->Current.RasterPos[2];
-
-   if (width > BITMAP_CACHE_WIDTH ||
-       height > BITMAP_CACHE_HEIGHT)
+   ubyte image[BITMAP_ATLAS_MAX_SIZE * BITMAP_ATLAS_MAX_SIZE];
+   struct bitmap_quad *quad;
+   GLint entry;
+
+   if (!cache ||
+       !cache->texture ||
+       width > BITMAP_ATLAS_MAX_SIZE ||
+       height > BITMAP_ATLAS_MAX_SIZE)
       return GL_FALSE; /* too big to cache */
 
-   if (!cache->empty) {
-      px = x - cache->xpos;  /* pos in buffer */
-      py = y - cache->ypos;
-      if (px < 0 || px + width > BITMAP_CACHE_WIDTH ||
-          py < 0 || py + height > BITMAP_CACHE_HEIGHT ||
-          !TEST_EQ_4V(st->ctx->Current.RasterColor, cache->color) ||
-          ((fabs(z - cache->zpos) > Z_EPSILON))) {
-         /* This bitmap would extend beyond cache bounds, or the bitmap
-          * color is changing
-          * so flush and continue.
-          */
-         st_flush_bitmap_cache(st);
-      }
+   if (cache->num_quads &&
+       (cache->num_quads == BITMAP_CACHE_MAX_QUADS ||
+        !TEST_EQ_4V(st->ctx->Current.RasterColor, cache->color) ||
+        fabs(z - cache->zpos) > Z_EPSILON)) {
+      /* The bitmap color is changing, etc. so flush and continue. */
+      st_flush_bitmap_cache(st);
    }
 
-   if (cache->empty) {
-      /* Initialize.  Center bitmap vertically in the buffer. */
-      px = 0;
-      py = (BITMAP_CACHE_HEIGHT - height) / 2;
-      cache->xpos = x;
-      cache->ypos = y - py;
+   /* PBO source... */
+   bitmap = _mesa_map_pbo_source(st->ctx, unpack, bitmap);
+   if (!bitmap)
+      return GL_TRUE; /* error already recorded */
+
+   memset(image, 0xff, width * height);
+   unpack_bitmap(st, 0, 0, width, height, unpack, bitmap, image, width);
+
+   _mesa_unmap_pbo_source(st->ctx, unpack);
+
+   entry = atlas_lookup(st, image, width, height);
+   if (entry < 0) {
+      /* Atlas is full: draw what refers to it and start over */
+      st_flush_bitmap_cache(st);
+      reset_atlas(st);
+      entry = atlas_lookup(st, image, width, height);
+      assert(entry >= 0);
+   }
+
+   if (cache->num_quads == 0) {
       cache->zpos = z;
-      cache->empty = GL_FALSE;
       COPY_4FV(cache->color, st->ctx->Current.RasterColor);
    }
 
-   assert(px != -999);
-   assert(py != -999);
-
-   if (x < cache->xmin)
-      cache->xmin = x;
-   if (y < cache->ymin)
-      cache->ymin = y;
-   if (x + width > cache->xmax)
-      cache->xmax = x + width;
-   if (y + height > cache->ymax)
-      cache->ymax = y + height;
-
-   /* create the transfer if needed */
-   create_cache_trans(st);
+   quad = &cache->quads[cache->num_quads++];
+   quad->x = x;
+   quad->y = y;
+   quad->entry = entry;
 
-   unpack_bitmap(st, px, py, width, height, unpack, bitmap,
-                 cache->buffer, BITMAP_CACHE_WIDTH);
+   cache->num_bitmaps++;
 
    return GL_TRUE; /* accumulated */
 }
@@ -831,10 +1029,30 @@ st_init_bitmap(struct st_context *st)
       assert(0);
    }
 
-   /* alloc bitmap cache object */
+   /* alloc bitmap cache object and its atlas */
    st->bitmap.cache = ST_CALLOC_STRUCT(bitmap_cache);
+   if (!st->bitmap.cache)
+      return;
 
-   reset_cache(st);
+   st->bitmap.cache->image = malloc(BITMAP_ATLAS_WIDTH * BITMAP_ATLAS_HEIGHT);
+   st->bitmap.cache->texture = st_texture_create(st, PIPE_TEXTURE_2D,
+                                                 st->bitmap.tex_format, 0,
+                                                 BITMAP_ATLAS_WIDTH,
+                                                 BITMAP_ATLAS_HEIGHT, 1,
+                                                 PIPE_BIND_SAMPLER_VIEW);
+   if (st->bitmap.cache->texture) {
+      st->bitmap.cache->sampler_view =
+         st_create_texture_sampler_view(pipe, st->bitmap.cache->texture);
+   }
+   if (!st->bitmap.cache->image || !st->bitmap.cache->sampler_view) {
+      /* draw each bitmap on its own */
+      pipe_resource_reference(&st->bitmap.cache->texture, NULL);
+      free(st->bitmap.cache->image);
+      st->bitmap.cache->image = NULL;
+   }
+   else {
+      reset_atlas(st);
+   }
 }
 
 
@@ -842,11 +1060,8 @@ st_init_bitmap(struct st_context *st)
 void
 st_destroy_bitmap(struct st_context *st)
 {
-   struct pipe_context *pipe = st->pipe;
    struct bitmap_cache *cache = st->bitmap.cache;
 
-
-
    if (st->bitmap.vs) {
       cso_delete_vertex_shader(st->cso_context, st->bitmap.vs);
       st->bitmap.vs = NULL;
@@ -858,11 +1073,9 @@ st_destroy_bitmap(struct st_context *st)
    }
 
    if (cache) {
-      if (cache->trans) {
-         pipe_transfer_unmap(pipe, cache->trans);
-         pipe->transfer_destroy(pipe, cache->trans);
-      }
-      pipe_resource_reference(&st->bitmap.cache->texture, NULL);
+      pipe_sampler_view_reference(&cache->sampler_view, NULL);
+      pipe_resource_reference(&cache->texture, NULL);
+      free(cache->image);
       free(st->bitmap.cache);
       st->bitmap.cache = NULL;
    }
@@ -34,6 +34,7 @@
 
 struct dd_function_table;
 struct st_context;
+struct st_fragment_program;
 
 #if FEATURE_drawpix
 
@@ -55,6 +56,10 @@ st_flush_bitmap_cache(struct st_context *st);
 extern void
 st_flush_bitmap(struct st_context *st);
 
+extern struct st_fragment_program *
+st_get_bitmap_fragment_program(struct st_context *st,
+                               struct st_fragment_program *stfp);
+
 #else
 
 static INLINE void
@@ -82,6 +87,13 @@ st_flush_bitmap(struct st_context *st)
 {
 }
 
+static INLINE struct st_fragment_program *
+st_get_bitmap_fragment_program(struct st_context *st,
+                               struct st_fragment_program *stfp)
+{
+   return NULL;
+}
+
 #endif /* FEATURE_drawpix */
 
 #endif /* ST_CB_BITMAP_H */
@@ -31,6 +31,7 @@
   */
 
 #include "main/imports.h"
+#include "main/fbobject.h"
 #include "main/image.h"
 #include "main/macros.h"
 
@@ -39,6 +40,7 @@
 #include "st_cb_blit.h"
 #include "st_cb_fbo.h"
 #include "st_atom.h"
+#include "st_debug.h"
 
 #include "util/u_blit.h"
 #include "util/u_inlines.h"
@@ -54,11 +56,109 @@ st_init_blit(struct st_context *st)
 void
 st_destroy_blit(struct st_context *st)
 {
+   if ((ST_DEBUG & DEBUG_FALLBACK) && st->blit_fallbacks)
+      debug_printf("%s: %u CopyTexSubImage fallbacks\n",
+                   __FUNCTION__, st->blit_fallbacks);
+
    util_destroy_blit(st->blit);
    st->blit = NULL;
 }
 
 
+/**
+ * Get the swizzle which returns the logical RGBA value of a pixel of the
+ * given base format from its RGBA storage, i.e. the way the value is seen
+ * when sampled or read back.
+ * \return GL_FALSE if the base format is not a color format.
+ */
+static GLboolean
+base_format_swizzle(GLenum baseFormat, unsigned char swizzle[4])
+{
+   switch (baseFormat) {
+   case GL_RGBA:
+      swizzle[0] = PIPE_SWIZZLE_RED;
+      swizzle[1] = PIPE_SWIZZLE_GREEN;
+      swizzle[2] = PIPE_SWIZZLE_BLUE;
+      swizzle[3] = PIPE_SWIZZLE_ALPHA;
+      return GL_TRUE;
+   case GL_RGB:
+      swizzle[0] = PIPE_SWIZZLE_RED;
+      swizzle[1] = PIPE_SWIZZLE_GREEN;
+      swizzle[2] = PIPE_SWIZZLE_BLUE;
+      swizzle[3] = PIPE_SWIZZLE_ONE;
+      return GL_TRUE;
+   case GL_RG:
+      swizzle[0] = PIPE_SWIZZLE_RED;
+      swizzle[1] = PIPE_SWIZZLE_GREEN;
+      swizzle[2] = PIPE_SWIZZLE_ZERO;
+      swizzle[3] = PIPE_SWIZZLE_ONE;
+      return GL_TRUE;
+   case GL_RED:
+      swizzle[0] = PIPE_SWIZZLE_RED;
+      swizzle[1] = PIPE_SWIZZLE_ZERO;
+      swizzle[2] = PIPE_SWIZZLE_ZERO;
+      swizzle[3] = PIPE_SWIZZLE_ONE;
+      return GL_TRUE;
+   case GL_ALPHA:
+      swizzle[0] = PIPE_SWIZZLE_ZERO;
+      swizzle[1] = PIPE_SWIZZLE_ZERO;
+      swizzle[2] = PIPE_SWIZZLE_ZERO;
+      swizzle[3] = PIPE_SWIZZLE_ALPHA;
+      return GL_TRUE;
+   case GL_LUMINANCE:
+      swizzle[0] = PIPE_SWIZZLE_RED;
+      swizzle[1] = PIPE_SWIZZLE_RED;
+      swizzle[2] = PIPE_SWIZZLE_RED;
+      swizzle[3] = PIPE_SWIZZLE_ONE;
+      return GL_TRUE;
+   case GL_LUMINANCE_ALPHA:
+      swizzle[0] = PIPE_SWIZZLE_RED;
+      swizzle[1] = PIPE_SWIZZLE_RED;
+      swizzle[2] = PIPE_SWIZZLE_RED;
+      swizzle[3] = PIPE_SWIZZLE_ALPHA;
+      return GL_TRUE;
+   case GL_INTENSITY:
+      swizzle[0] = PIPE_SWIZZLE_RED;
+      swizzle[1] = PIPE_SWIZZLE_RED;
+      swizzle[2] = PIPE_SWIZZLE_RED;
+      swizzle[3] = PIPE_SWIZZLE_RED;
+      return GL_TRUE;
+   default:
+      return GL_FALSE;
+   }
+}
+
+
+/**
+ * Compute the swizzle for a shader blit from a buffer of base format
+ * srcBase to one of base format dstBase, following the usual GL rules
+ * (e.g. L = R, missing alpha = 1).  Since the user-requested base formats
+ * are used rather than the actual pipe formats, channels the driver added
+ * (like A in an RGBA texture holding GL_RGB data) get proper values too.
+ * \return GL_FALSE if either format isn't a color format.
+ */
+GLboolean
+st_get_blit_swizzle(GLenum srcBase, GLenum dstBase, unsigned char swizzle[4])
+{
+   unsigned char src[4], dst[4];
+   unsigned i;
+
+   if (!base_format_swizzle(srcBase, src) ||
+       !base_format_swizzle(dstBase, dst))
+      return GL_FALSE;
+
+   /* The dest format picks channels out of the logical src value */
+   for (i = 0; i < 4; i++) {
+      if (dst[i] <= PIPE_SWIZZLE_ALPHA)
+         swizzle[i] = src[dst[i]];
+      else
+         swizzle[i] = dst[i];
+   }
+
+   return GL_TRUE;
+}
+
+
 #if FEATURE_EXT_framebuffer_blit
 
 static void
@@ -109,40 +209,65 @@ st_BlitFramebuffer(struct gl_context *ctx,
       dstY1 = tmp;
    }
 
-   if (mask & GL_COLOR_BUFFER_BIT) {
+   if ((mask & GL_COLOR_BUFFER_BIT) && readFB->_ColorReadBuffer) {
       struct gl_renderbuffer_attachment *srcAtt =
          &readFB->Attachment[readFB->_ColorReadBufferIndex];
+      struct pipe_resource *srcTex;
+      unsigned srcLevel, srcLayer;
+      GLenum srcBase;
+      GLuint i;
 
-      if(srcAtt->Type == GL_TEXTURE) {
+      if (srcAtt->Type == GL_TEXTURE) {
          struct st_texture_object *srcObj =
             st_texture_object(srcAtt->Texture);
-         struct st_renderbuffer *dstRb =
-            st_renderbuffer(drawFB->_ColorDrawBuffers[0]);
-         struct pipe_surface *dstSurf = dstRb->surface;
 
          if (!srcObj->pt)
             return;
 
-         util_blit_pixels(st->blit, srcObj->pt, srcAtt->TextureLevel,
-                          srcX0, srcY0, srcX1, srcY1,
-                          srcAtt->Zoffset + srcAtt->CubeMapFace,
-                          dstSurf, dstX0, dstY0, dstX1, dstY1,
-                          0.0, pFilter);
+         srcTex = srcObj->pt;
+         srcLevel = srcAtt->TextureLevel;
+         srcLayer = srcAtt->Zoffset + srcAtt->CubeMapFace;
       }
       else {
          struct st_renderbuffer *srcRb =
             st_renderbuffer(readFB->_ColorReadBuffer);
-         struct st_renderbuffer *dstRb =
-            st_renderbuffer(drawFB->_ColorDrawBuffers[0]);
          struct pipe_surface *srcSurf = srcRb->surface;
-         struct pipe_surface *dstSurf = dstRb->surface;
 
-         util_blit_pixels(st->blit,
-                          srcRb->texture, srcSurf->u.tex.level,
-                          srcX0, srcY0, srcX1, srcY1,
-                          srcSurf->u.tex.first_layer,
-                          dstSurf, dstX0, dstY0, dstX1, dstY1,
-                          0.0, pFilter);
+         srcTex = srcRb->texture;
+         srcLevel = srcSurf->u.tex.level;
+         srcLayer = srcSurf->u.tex.first_layer;
+      }
+
+      srcBase = _mesa_base_fbo_format(ctx,
+                                      readFB->_ColorReadBuffer->InternalFormat);
+
+      /* blit to each of the color draw buffers, converting formats */
+      for (i = 0; i < drawFB->_NumColorDrawBuffers; i++) {
+         struct st_renderbuffer *dstRb =
+            st_renderbuffer(drawFB->_ColorDrawBuffers[i]);
+         struct pipe_surface *dstSurf;
+         unsigned char swizzle[4];
+
+         if (!dstRb || !dstRb->surface)
+            continue;
+
+         dstSurf = dstRb->surface;
+
+         if (st_get_blit_swizzle(srcBase,
+                                 _mesa_base_fbo_format(ctx,
+                                             dstRb->Base.InternalFormat),
+                                 swizzle)) {
+            util_blit_pixels_swizzle(st->blit, srcTex, srcLevel,
+                                     srcX0, srcY0, srcX1, srcY1, srcLayer,
+                                     dstSurf, dstX0, dstY0, dstX1, dstY1,
+                                     0.0, pFilter, swizzle);
+         }
+         else {
+            util_blit_pixels(st->blit, srcTex, srcLevel,
+                             srcX0, srcY0, srcX1, srcY1, srcLayer,
+                             dstSurf, dstX0, dstY0, dstX1, dstY1,
+                             0.0, pFilter);
+         }
       }
    }
 
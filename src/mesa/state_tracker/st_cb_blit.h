@@ -30,6 +30,7 @@
 
 
 #include "main/compiler.h"
+#include "main/glheader.h"
 
 struct dd_function_table;
 struct st_context;
@@ -41,6 +42,9 @@ st_init_blit(struct st_context *st);
 extern void
 st_destroy_blit(struct st_context *st);
 
+extern GLboolean
+st_get_blit_swizzle(GLenum srcBase, GLenum dstBase, unsigned char swizzle[4]);
+
 #if FEATURE_EXT_framebuffer_blit
 
 extern void
@@ -42,6 +42,7 @@
 
 #include "st_context.h"
 #include "st_program.h"
+#include "st_precompile.h"
 #include "st_mesa_to_tgsi.h"
 #include "st_cb_program.h"
 
@@ -256,6 +257,9 @@ static GLboolean st_program_string_notify( struct gl_context *ctx,
 	 st->dirty.st |= ST_NEW_VERTEX_PROGRAM;
    }
 
+   /* translate now rather than on first draw */
+   st_precompile_program(st, target, prog);
+
    /* XXX check if program is legal, within limits */
    return GL_TRUE;
 }
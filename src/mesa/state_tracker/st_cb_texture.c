@@ -45,6 +45,7 @@
 
 #include "state_tracker/st_debug.h"
 #include "state_tracker/st_context.h"
+#include "state_tracker/st_cb_blit.h"
 #include "state_tracker/st_cb_fbo.h"
 #include "state_tracker/st_cb_flush.h"
 #include "state_tracker/st_cb_texture.h"
@@ -64,6 +65,8 @@
 #include "util/u_sampler.h"
 #include "util/u_math.h"
 #include "util/u_box.h"
+#include "util/u_cpu_detect.h"
+#include "os/os_thread.h"
 
 #define DBG if (0) printf
 
@@ -850,6 +853,234 @@ st_CompressedTexImage2D(struct gl_context *ctx, GLenum target, GLint level,
 
 
 
+/**
+ * Least number of pixels converted by each thread, so that creating and
+ * joining it is small next to the conversion.  Smaller images are done
+ * by the calling thread alone.
+ */
+#define GET_TEX_IMAGE_THREAD_PIXELS (256 * 1024)
+#define GET_TEX_IMAGE_MAX_THREADS 8
+
+
+struct get_tex_image_job
+{
+   enum pipe_format dst_format;
+   ubyte *dst;
+   unsigned dst_stride;
+   enum pipe_format src_format;
+   const ubyte *src;
+   unsigned src_stride;
+   unsigned width, height;
+};
+
+
+static void
+run_get_tex_image_job(const struct get_tex_image_job *job)
+{
+   util_format_translate(job->dst_format, job->dst, job->dst_stride, 0, 0,
+                         job->src_format, job->src, job->src_stride, 0, 0,
+                         job->width, job->height);
+}
+
+
+static PIPE_THREAD_ROUTINE(get_tex_image_thread, param)
+{
+   run_get_tex_image_job((const struct get_tex_image_job *) param);
+   return NULL;
+}
+
+
+/**
+ * Convert a mapped image with the u_format row functions straight into
+ * the destination.  Images of several times GET_TEX_IMAGE_THREAD_PIXELS
+ * are split into bands of rows which are converted in parallel.
+ */
+static void
+convert_tex_image(enum pipe_format dst_format, ubyte *dst, unsigned dst_stride,
+                  enum pipe_format src_format, const ubyte *src,
+                  unsigned src_stride, unsigned width, unsigned height)
+{
+   struct get_tex_image_job jobs[GET_TEX_IMAGE_MAX_THREADS];
+   pipe_thread threads[GET_TEX_IMAGE_MAX_THREADS];
+   unsigned num_jobs = 1, rows, i;
+
+   if (width * height >= 2 * GET_TEX_IMAGE_THREAD_PIXELS) {
+      util_cpu_detect();
+      num_jobs = MIN2(util_cpu_caps.nr_cpus, GET_TEX_IMAGE_MAX_THREADS);
+      num_jobs = MIN2(num_jobs, width * height / GET_TEX_IMAGE_THREAD_PIXELS);
+      num_jobs = MAX2(num_jobs, 1);
+   }
+
+   rows = (height + num_jobs - 1) / num_jobs;
+
+   for (i = 0; i < num_jobs; i++) {
+      const unsigned y = i * rows;
+      jobs[i].dst_format = dst_format;
+      jobs[i].dst = dst + y * dst_stride;
+      jobs[i].dst_stride = dst_stride;
+      jobs[i].src_format = src_format;
+      jobs[i].src = src + y * src_stride;
+      jobs[i].src_stride = src_stride;
+      jobs[i].width = width;
+      jobs[i].height = y < height ? MIN2(rows, height - y) : 0;
+   }
+
+   /* the calling thread does the first band itself */
+   for (i = 1; i < num_jobs; i++) {
+      threads[i] = 0;
+      if (jobs[i].height)
+         threads[i] = pipe_thread_create(get_tex_image_thread, &jobs[i]);
+   }
+
+   run_get_tex_image_job(&jobs[0]);
+
+   for (i = 1; i < num_jobs; i++) {
+      if (threads[i])
+         pipe_thread_wait(threads[i]);
+      else if (jobs[i].height)
+         run_get_tex_image_job(&jobs[i]);
+   }
+}
+
+
+/**
+ * Is converting from src to dst with util_format_translate() exact, i.e.
+ * the same as core Mesa's float unpack/pack?  Mesa truncates when packing
+ * to unorm while u_format rounds and bit-replicates, so this is only the
+ * case when all channels of both formats have the same type and size
+ * (e.g. 8-bit unorm to 8-bit unorm, float to float).
+ */
+static boolean
+is_exact_get_tex_image_conversion(const struct util_format_description *src,
+                                  const struct util_format_description *dst)
+{
+   const struct util_format_channel_description *chan = NULL;
+   unsigned i;
+
+   if (src->format == dst->format)
+      return TRUE;
+
+   for (i = 0; i < src->nr_channels; i++) {
+      if (src->channel[i].type == UTIL_FORMAT_TYPE_VOID)
+         continue;
+      if (!chan)
+         chan = &src->channel[i];
+      else if (src->channel[i].type != chan->type ||
+               src->channel[i].normalized != chan->normalized ||
+               src->channel[i].size != chan->size)
+         return FALSE;
+   }
+
+   if (!chan)
+      return FALSE;
+
+   for (i = 0; i < dst->nr_channels; i++) {
+      if (dst->channel[i].type == UTIL_FORMAT_TYPE_VOID)
+         continue;
+      if (dst->channel[i].type != chan->type ||
+          dst->channel[i].normalized != chan->normalized ||
+          dst->channel[i].size != chan->size)
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+
+/**
+ * Find the format to use for converting a texture image with
+ * convert_tex_image() for glGetTexImage(format, type).
+ * Core Mesa rebases luminance/alpha/intensity textures in ways the
+ * u_format conversions don't, so those only qualify when the user asks
+ * for the same base format.
+ * convert_tex_image() walks the rows with an unsigned stride, so
+ * GL_PACK_INVERT_MESA isn't handled either.
+ * \return PIPE_FORMAT_NONE if the slow path must be used
+ */
+static enum pipe_format
+choose_get_tex_image_format(struct gl_context *ctx,
+                            const struct gl_texture_image *texImage,
+                            enum pipe_format src_format,
+                            GLenum format, GLenum type)
+{
+   const struct util_format_description *desc =
+      util_format_description(src_format);
+   enum pipe_format dst_format;
+
+   if (ctx->Pack.Invert ||
+       !desc ||
+       desc->layout != UTIL_FORMAT_LAYOUT_PLAIN ||
+       desc->colorspace != UTIL_FORMAT_COLORSPACE_RGB)
+      return PIPE_FORMAT_NONE;
+
+   dst_format = st_choose_matching_format(format, type, ctx->Pack.SwapBytes);
+   if (dst_format == PIPE_FORMAT_NONE ||
+       !is_exact_get_tex_image_conversion(desc,
+                                          util_format_description(dst_format)))
+      return PIPE_FORMAT_NONE;
+
+   switch (texImage->_BaseFormat) {
+   case GL_RGBA:
+   case GL_RGB:
+   case GL_RG:
+   case GL_RED:
+      if (format == GL_RGBA || format == GL_BGRA ||
+          format == GL_ABGR_EXT || format == GL_RGB)
+         return dst_format;
+      break;
+   case GL_ALPHA:
+   case GL_LUMINANCE:
+   case GL_LUMINANCE_ALPHA:
+      if (format == texImage->_BaseFormat)
+         return dst_format;
+      break;
+   }
+
+   return PIPE_FORMAT_NONE;
+}
+
+
+/**
+ * glGetTexImage() fast path: convert each slice of the texture image
+ * straight into the user's buffer or PBO.
+ */
+static void
+get_tex_image_direct(struct gl_context *ctx, GLenum format, GLenum type,
+                     GLvoid *pixels, enum pipe_format dst_format,
+                     struct gl_texture_image *texImage)
+{
+   struct st_context *st = st_context(ctx);
+   struct st_texture_image *stImage = st_texture_image(texImage);
+   const GLuint width = texImage->Width;
+   const GLuint height = texImage->Height;
+   const GLint dstRowStride =
+      _mesa_image_row_stride(&ctx->Pack, width, format, type);
+   GLuint i;
+
+   pixels = _mesa_map_pbo_dest(ctx, &ctx->Pack, pixels);
+   if (!pixels)
+      return;
+
+   for (i = 0; i < texImage->Depth; i++) {
+      GLubyte *dest = _mesa_image_address3d(&ctx->Pack, pixels, width, height,
+                                            format, type, i, 0, 0);
+      const GLubyte *map = st_texture_image_map(st, stImage, i,
+                                                PIPE_TRANSFER_READ, 0, 0,
+                                                width, height);
+      if (!map)
+         break;
+
+      convert_tex_image(dst_format, dest, dstRowStride,
+                        stImage->pt->format, map, stImage->transfer->stride,
+                        width, height);
+
+      st_texture_image_unmap(st, stImage);
+   }
+
+   _mesa_unmap_pbo_dest(ctx, &ctx->Pack);
+}
+
+
 /**
  * glGetTexImage() helper: decompress a compressed texture by rendering
  * a textured quad.  Store the results in the user's buffer.
@@ -873,6 +1104,7 @@ decompress_with_blit(struct gl_context * ctx, GLenum target, GLint level,
    struct pipe_transfer *tex_xfer;
    unsigned bind = (PIPE_BIND_RENDER_TARGET | /* util_blit may choose to render */
 		    PIPE_BIND_TRANSFER_READ);
+   enum pipe_format dst_format;
 
    /* create temp / dest surface */
    if (!util_create_rgba_surface(pipe, width, height, bind,
@@ -901,6 +1133,9 @@ decompress_with_blit(struct gl_context * ctx, GLenum target, GLint level,
 
    pixels = _mesa_map_pbo_dest(ctx, &ctx->Pack, pixels);
 
+   dst_format = choose_get_tex_image_format(ctx, texImage, dst_texture->format,
+                                            format, type);
+
    /* copy/pack data into user buffer */
    if (st_equal_formats(stImage->pt->format, format, type)) {
       /* memcpy */
@@ -915,6 +1150,18 @@ decompress_with_blit(struct gl_context * ctx, GLenum target, GLint level,
       }
       pipe_transfer_unmap(pipe, tex_xfer);
    }
+   else if (dst_format != PIPE_FORMAT_NONE) {
+      const GLint dstRowStride =
+         _mesa_image_row_stride(&ctx->Pack, width, format, type);
+      GLvoid *dest = _mesa_image_address2d(&ctx->Pack, pixels, width,
+                                           height, format, type, 0, 0);
+      const ubyte *map = pipe_transfer_map(pipe, tex_xfer);
+
+      convert_tex_image(dst_format, dest, dstRowStride,
+                        dst_texture->format, map, tex_xfer->stride,
+                        width, height);
+      pipe_transfer_unmap(pipe, tex_xfer);
+   }
    else {
       /* format translation via floats */
       GLuint row;
@@ -975,6 +1222,17 @@ st_get_tex_image(struct gl_context * ctx, GLenum target, GLint level,
       return;
    }
 
+   if (stImage->pt && !compressed_dst && target != GL_TEXTURE_1D_ARRAY_EXT) {
+      enum pipe_format dst_format =
+         choose_get_tex_image_format(ctx, texImage, stImage->pt->format,
+                                     format, type);
+      if (dst_format != PIPE_FORMAT_NONE) {
+         get_tex_image_direct(ctx, format, type, pixels, dst_format,
+                              texImage);
+         return;
+      }
+   }
+
    /* Map */
    if (stImage->pt) {
       /* Image is stored in hardware format in a buffer managed by the
@@ -1420,72 +1678,6 @@ fallback_copy_texsubimage(struct gl_context *ctx, GLenum target, GLint level,
 
 
 
-/**
- * If the format of the src renderbuffer and the format of the dest
- * texture are compatible (in terms of blitting), return a TGSI writemask
- * to be used during the blit.
- * If the src/dest are incompatible, return 0.
- */
-static unsigned
-compatible_src_dst_formats(struct gl_context *ctx,
-                           const struct gl_renderbuffer *src,
-                           const struct gl_texture_image *dst)
-{
-   /* Get logical base formats for the src and dest.
-    * That is, use the user-requested formats and not the actual, device-
-    * chosen formats.
-    * For example, the user may have requested an A8 texture but the
-    * driver may actually be using an RGBA texture format.  When we
-    * copy/blit to that texture, we only want to copy the Alpha channel
-    * and not the RGB channels.
-    *
-    * Similarly, when the src FBO was created an RGB format may have been
-    * requested but the driver actually chose an RGBA format.  In that case,
-    * we don't want to copy the undefined Alpha channel to the dest texture
-    * (it should be 1.0).
-    */
-   const GLenum srcFormat = _mesa_base_fbo_format(ctx, src->InternalFormat);
-   const GLenum dstFormat = _mesa_base_tex_format(ctx, dst->InternalFormat);
-
-   /**
-    * XXX when we have red-only and red/green renderbuffers we'll need
-    * to add more cases here (or implement a general-purpose routine that
-    * queries the existance of the R,G,B,A channels in the src and dest).
-    */
-   if (srcFormat == dstFormat) {
-      /* This is the same as matching_base_formats, which should
-       * always pass, as it did previously.
-       */
-      return TGSI_WRITEMASK_XYZW;
-   }
-   else if (srcFormat == GL_RGB && dstFormat == GL_RGBA) {
-      /* Make sure that A in the dest is 1.  The actual src format
-       * may be RGBA and have undefined A values.
-       */
-      return TGSI_WRITEMASK_XYZ;
-   }
-   else if (srcFormat == GL_RGBA && dstFormat == GL_RGB) {
-      /* Make sure that A in the dest is 1.  The actual dst format
-       * may be RGBA and will need A=1 to provide proper alpha values
-       * when sampled later.
-       */
-      return TGSI_WRITEMASK_XYZ;
-   }
-   else {
-      if (ST_DEBUG & DEBUG_FALLBACK)
-         debug_printf("%s failed for src %s, dst %s\n",
-                      __FUNCTION__, 
-                      _mesa_lookup_enum_by_nr(srcFormat),
-                      _mesa_lookup_enum_by_nr(dstFormat));
-
-      /* Otherwise fail.
-       */
-      return 0;
-   }
-}
-
-
-
 /**
  * Do a CopyTex[Sub]Image1/2/3D() using a hardware (blit) path if possible.
  * Note that the region to copy has already been clipped so we know we
@@ -1516,7 +1708,8 @@ st_copy_texsubimage(struct gl_context *ctx,
    enum pipe_format dest_format, src_format;
    GLboolean use_fallback = GL_TRUE;
    GLboolean matching_base_formats;
-   GLuint format_writemask, sample_count;
+   GLboolean is_depth, depth_scale_or_bias;
+   GLuint sample_count;
    struct pipe_surface *dest_surface = NULL;
    GLboolean do_flip = (st_fb_orientation(ctx->ReadBuffer) == Y_0_TOP);
 
@@ -1525,8 +1718,9 @@ st_copy_texsubimage(struct gl_context *ctx,
    if (0) st_validate_state(st);
 
    /* determine if copying depth or color data */
-   if (texBaseFormat == GL_DEPTH_COMPONENT ||
-       texBaseFormat == GL_DEPTH_STENCIL) {
+   is_depth = (texBaseFormat == GL_DEPTH_COMPONENT ||
+               texBaseFormat == GL_DEPTH_STENCIL);
+   if (is_depth) {
       strb = st_renderbuffer(fb->_DepthBuffer);
       if (strb->Base.Wrapped) {
          strb = st_renderbuffer(strb->Base.Wrapped);
@@ -1594,9 +1788,11 @@ st_copy_texsubimage(struct gl_context *ctx,
    matching_base_formats =
       (_mesa_get_format_base_format(strb->Base.Format) ==
        _mesa_get_format_base_format(texImage->TexFormat));
-   format_writemask = compatible_src_dst_formats(ctx, &strb->Base, texImage);
+   depth_scale_or_bias = (is_depth &&
+                          (ctx->Pixel.DepthScale != 1.0F ||
+                           ctx->Pixel.DepthBias != 0.0F));
 
-   if (ctx->_ImageTransferState == 0x0) {
+   if (ctx->_ImageTransferState == 0x0 && !depth_scale_or_bias) {
 
       if (matching_base_formats &&
           src_format == dest_format &&
@@ -1619,51 +1815,77 @@ st_copy_texsubimage(struct gl_context *ctx,
                                     &src_box);
          use_fallback = GL_FALSE;
       }
-      else if (format_writemask &&
-               texBaseFormat != GL_DEPTH_COMPONENT &&
-               texBaseFormat != GL_DEPTH_STENCIL &&
-               screen->is_format_supported(screen, src_format,
-                                           PIPE_TEXTURE_2D, sample_count,
-                                           PIPE_BIND_SAMPLER_VIEW,
-                                           0) &&
-               screen->is_format_supported(screen, dest_format,
-                                           PIPE_TEXTURE_2D, 0,
-                                           PIPE_BIND_RENDER_TARGET,
-                                           0)) {
-         /* draw textured quad to do the copy */
-         GLint srcY0, srcY1;
-         struct pipe_surface surf_tmpl;
-         memset(&surf_tmpl, 0, sizeof(surf_tmpl));
-         surf_tmpl.format = stImage->pt->format;
-         surf_tmpl.usage = PIPE_BIND_RENDER_TARGET;
-         surf_tmpl.u.tex.level = stImage->level;
-         surf_tmpl.u.tex.first_layer = stImage->face + destZ;
-         surf_tmpl.u.tex.last_layer = stImage->face + destZ;
-
-         dest_surface = pipe->create_surface(pipe, stImage->pt,
-                                             &surf_tmpl);
-
-         if (do_flip) {
-            srcY1 = strb->Base.Height - srcY - height;
-            srcY0 = srcY1 + height;
+      else if (texBaseFormat != GL_DEPTH_STENCIL) {
+         /* Draw textured quad to do the copy.  Color format conversions
+          * between the logical src and dest base formats are done with a
+          * swizzle.  The depth shader only writes Z so depth/stencil
+          * textures still need the fallback (or an exact copy, above).
+          */
+         unsigned char swizzle[4];
+         unsigned dest_bind;
+         GLboolean can_blit;
+
+         if (is_depth) {
+            dest_bind = PIPE_BIND_DEPTH_STENCIL;
+            swizzle[0] = PIPE_SWIZZLE_RED;
+            swizzle[1] = PIPE_SWIZZLE_GREEN;
+            swizzle[2] = PIPE_SWIZZLE_BLUE;
+            swizzle[3] = PIPE_SWIZZLE_ALPHA;
+            can_blit = GL_TRUE;
          }
          else {
-            srcY0 = srcY;
-            srcY1 = srcY0 + height;
+            dest_bind = PIPE_BIND_RENDER_TARGET;
+            can_blit = st_get_blit_swizzle(
+                          _mesa_base_fbo_format(ctx, strb->Base.InternalFormat),
+                          _mesa_base_tex_format(ctx, texImage->InternalFormat),
+                          swizzle);
          }
 
-         util_blit_pixels_writemask(st->blit,
-                                    strb->texture,
-                                    strb->surface->u.tex.level,
-                                    srcX, srcY0,
-                                    srcX + width, srcY1,
-                                    strb->surface->u.tex.first_layer,
-                                    dest_surface,
-                                    destX, destY,
-                                    destX + width, destY + height,
-                                    0.0, PIPE_TEX_MIPFILTER_NEAREST,
-                                    format_writemask);
-         use_fallback = GL_FALSE;
+         if (can_blit &&
+             screen->is_format_supported(screen, src_format,
+                                         PIPE_TEXTURE_2D, sample_count,
+                                         PIPE_BIND_SAMPLER_VIEW,
+                                         0) &&
+             screen->is_format_supported(screen, dest_format,
+                                         PIPE_TEXTURE_2D, 0,
+                                         dest_bind,
+                                         0)) {
+            GLint srcY0, srcY1;
+            struct pipe_surface surf_tmpl;
+            memset(&surf_tmpl, 0, sizeof(surf_tmpl));
+            surf_tmpl.format = stImage->pt->format;
+            surf_tmpl.usage = dest_bind;
+            surf_tmpl.u.tex.level = stImage->level;
+            surf_tmpl.u.tex.first_layer = stImage->face + destZ;
+            surf_tmpl.u.tex.last_layer = stImage->face + destZ;
+
+            dest_surface = pipe->create_surface(pipe, stImage->pt,
+                                                &surf_tmpl);
+
+            if (do_flip) {
+               srcY1 = strb->Base.Height - srcY - height;
+               srcY0 = srcY1 + height;
+            }
+            else {
+               srcY0 = srcY;
+               srcY1 = srcY0 + height;
+            }
+
+            if (dest_surface) {
+               util_blit_pixels_swizzle(st->blit,
+                                        strb->texture,
+                                        strb->surface->u.tex.level,
+                                        srcX, srcY0,
+                                        srcX + width, srcY1,
+                                        strb->surface->u.tex.first_layer,
+                                        dest_surface,
+                                        destX, destY,
+                                        destX + width, destY + height,
+                                        0.0, PIPE_TEX_MIPFILTER_NEAREST,
+                                        swizzle);
+               use_fallback = GL_FALSE;
+            }
+         }
       }
 
       if (dest_surface)
@@ -1672,6 +1894,12 @@ st_copy_texsubimage(struct gl_context *ctx,
 
    if (use_fallback) {
       /* software fallback */
+      st->blit_fallbacks++;
+      if (ST_DEBUG & DEBUG_FALLBACK)
+         debug_printf("%s: fallback for src %s, dst %s\n", __FUNCTION__,
+                      util_format_name(src_format),
+                      util_format_name(dest_format));
+
       fallback_copy_texsubimage(ctx, target, level,
                                 strb, stImage, texBaseFormat,
                                 destX, destY, destZ,
@@ -57,6 +57,7 @@
 #include "st_draw.h"
 #include "st_extensions.h"
 #include "st_gen_mipmap.h"
+#include "st_precompile.h"
 #include "st_program.h"
 #include "pipe/p_context.h"
 #include "util/u_inlines.h"
@@ -124,6 +125,7 @@ st_create_context_priv( struct gl_context *ctx, struct pipe_context *pipe )
    st_init_draw( st );
    st_init_generate_mipmap(st);
    st_init_blit(st);
+   st_init_precompile(st);
 
    if(pipe->screen->get_param(pipe->screen, PIPE_CAP_NPOT_TEXTURES))
       st->internal_target = PIPE_TEXTURE_2D;
@@ -202,6 +204,7 @@ static void st_destroy_context_priv( struct st_context *st )
    st_destroy_bitmap(st);
    st_destroy_drawpix(st);
    st_destroy_drawtex(st);
+   st_destroy_precompile(st);
 
    for (i = 0; i < Elements(st->state.sampler_views); i++) {
       pipe_sampler_view_reference(&st->state.sampler_views[i], NULL);
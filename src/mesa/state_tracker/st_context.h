@@ -185,6 +185,8 @@ struct st_context
    enum pipe_texture_target internal_target;
    struct gen_mipmap_state *gen_mipmap;
    struct blit_state *blit;
+   /** Number of CopyTex[Sub]Image calls done on the CPU */
+   unsigned blit_fallbacks;
 
    struct cso_context *cso_context;
 
@@ -214,6 +216,7 @@ struct st_framebuffer
    enum st_attachment_type statts[ST_ATTACHMENT_COUNT];
    unsigned num_statts;
    int32_t revalidate;
+   boolean y_0_bottom;  /**< from st_framebuffer_iface::y_0_bottom */
 };
 
 
@@ -229,7 +232,12 @@ void st_invalidate_state(struct gl_context * ctx, GLuint new_state);
 static INLINE GLuint
 st_fb_orientation(const struct gl_framebuffer *fb)
 {
-   if (fb && fb->Name == 0) {
+   /* Window system framebuffers are always st_framebuffers (see
+    * st_ws_framebuffer()).  Some of them live in client memory which is
+    * laid out bottom-up, and are treated like FBOs below.
+    */
+   if (fb && fb->Name == 0 &&
+       !((const struct st_framebuffer *) fb)->y_0_bottom) {
       /* Drawing into a window (on-screen buffer).
        *
        * Negate Y scale to flip image vertically.
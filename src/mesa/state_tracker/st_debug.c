@@ -53,6 +53,7 @@ static const struct debug_named_value st_debug_flags[] = {
    { "fallback", DEBUG_FALLBACK, NULL },
    { "screen",   DEBUG_SCREEN, NULL },
    { "query",    DEBUG_QUERY, NULL },
+   { "bitmap",   DEBUG_BITMAP, NULL },
    DEBUG_NAMED_VALUE_END
 };
 
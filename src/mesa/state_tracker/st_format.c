@@ -975,6 +975,87 @@ st_equal_formats(enum pipe_format pFormat, GLenum format, GLenum type)
    }
 }
 
+/**
+ * Return the gallium format whose memory layout matches the given GL
+ * pixel format/type, so that pixels can be converted with the u_format
+ * routines straight into the user's buffer.
+ * \return PIPE_FORMAT_NONE if there's no such format.
+ */
+enum pipe_format
+st_choose_matching_format(GLenum format, GLenum type, GLboolean swapBytes)
+{
+   /* The u_format layouts are little-endian.  Byte arrays are the same
+    * on any host, packed 8_8_8_8 words match with the bytes reversed,
+    * and other multi-byte types only match on little-endian hosts.
+    */
+   const GLboolean littleEndian = _mesa_little_endian();
+
+   if (swapBytes)
+      return PIPE_FORMAT_NONE;
+
+   switch (type) {
+   case GL_UNSIGNED_BYTE:
+      switch (format) {
+      case GL_RGBA:            return PIPE_FORMAT_R8G8B8A8_UNORM;
+      case GL_BGRA:            return PIPE_FORMAT_B8G8R8A8_UNORM;
+      case GL_ABGR_EXT:        return PIPE_FORMAT_A8B8G8R8_UNORM;
+      case GL_RGB:             return PIPE_FORMAT_R8G8B8_UNORM;
+      case GL_ALPHA:           return PIPE_FORMAT_A8_UNORM;
+      case GL_LUMINANCE:       return PIPE_FORMAT_L8_UNORM;
+      case GL_LUMINANCE_ALPHA: return PIPE_FORMAT_L8A8_UNORM;
+      default:                 return PIPE_FORMAT_NONE;
+      }
+   case GL_UNSIGNED_INT_8_8_8_8_REV:
+      switch (format) {
+      case GL_RGBA:
+         return littleEndian ? PIPE_FORMAT_R8G8B8A8_UNORM
+                             : PIPE_FORMAT_A8B8G8R8_UNORM;
+      case GL_BGRA:
+         return littleEndian ? PIPE_FORMAT_B8G8R8A8_UNORM
+                             : PIPE_FORMAT_A8R8G8B8_UNORM;
+      default:
+         return PIPE_FORMAT_NONE;
+      }
+   case GL_UNSIGNED_INT_8_8_8_8:
+      switch (format) {
+      case GL_RGBA:
+         return littleEndian ? PIPE_FORMAT_A8B8G8R8_UNORM
+                             : PIPE_FORMAT_R8G8B8A8_UNORM;
+      case GL_BGRA:
+         return littleEndian ? PIPE_FORMAT_A8R8G8B8_UNORM
+                             : PIPE_FORMAT_B8G8R8A8_UNORM;
+      default:
+         return PIPE_FORMAT_NONE;
+      }
+   }
+
+   if (!littleEndian)
+      return PIPE_FORMAT_NONE;
+
+   switch (type) {
+   case GL_UNSIGNED_SHORT:
+      switch (format) {
+      case GL_RGBA:            return PIPE_FORMAT_R16G16B16A16_UNORM;
+      case GL_LUMINANCE:       return PIPE_FORMAT_L16_UNORM;
+      default:                 return PIPE_FORMAT_NONE;
+      }
+   case GL_UNSIGNED_SHORT_5_6_5:
+      return format == GL_RGB ? PIPE_FORMAT_B5G6R5_UNORM : PIPE_FORMAT_NONE;
+   case GL_UNSIGNED_SHORT_4_4_4_4_REV:
+      return format == GL_BGRA ? PIPE_FORMAT_B4G4R4A4_UNORM : PIPE_FORMAT_NONE;
+   case GL_UNSIGNED_SHORT_1_5_5_5_REV:
+      return format == GL_BGRA ? PIPE_FORMAT_B5G5R5A1_UNORM : PIPE_FORMAT_NONE;
+   case GL_FLOAT:
+      switch (format) {
+      case GL_RGBA:            return PIPE_FORMAT_R32G32B32A32_FLOAT;
+      case GL_RGB:             return PIPE_FORMAT_R32G32B32_FLOAT;
+      default:                 return PIPE_FORMAT_NONE;
+      }
+   default:
+      return PIPE_FORMAT_NONE;
+   }
+}
+
 GLboolean
 st_sampler_compat_formats(enum pipe_format format1, enum pipe_format format2)
 {
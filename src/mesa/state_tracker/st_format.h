@@ -71,6 +71,9 @@ st_ChooseTextureFormat(struct gl_context * ctx, GLint internalFormat,
 extern GLboolean
 st_equal_formats(enum pipe_format pFormat, GLenum format, GLenum type);
 
+extern enum pipe_format
+st_choose_matching_format(GLenum format, GLenum type, GLboolean swapBytes);
+
 /* can we use a sampler view to translate these formats
    only used to make TFP so far */
 extern GLboolean
@@ -51,6 +51,7 @@
 #include "st_format.h"
 #include "st_cb_fbo.h"
 #include "st_cb_flush.h"
+#include "st_cb_texture.h"
 #include "st_manager.h"
 
 /**
@@ -448,6 +449,7 @@ st_framebuffer_create(struct st_framebuffer_iface *stfbi)
          &stfb->Base._ColorReadBufferIndex);
 
    stfb->iface = stfbi;
+   stfb->y_0_bottom = stfbi->y_0_bottom;
 
    /* add the color buffer */
    idx = stfb->Base._ColorDrawBufferIndexes[0];
@@ -636,6 +638,71 @@ st_context_share(struct st_context_iface *stctxi,
    return _mesa_share_state(st->ctx, src->ctx);
 }
 
+static boolean
+st_context_get_resource_for_egl_image(struct st_context_iface *stctxi,
+                                      struct st_context_resource *stres)
+{
+   struct st_context *st = (struct st_context *) stctxi;
+   struct gl_context *ctx = st->ctx;
+   GLuint name = (GLuint) pointer_to_uintptr(stres->resource);
+   GET_CURRENT_CONTEXT(cur);
+   struct pipe_resource *ptex = NULL;
+   GLenum target;
+
+   switch (stres->type) {
+   case ST_CONTEXT_RESOURCE_OPENGL_TEXTURE_2D:
+      target = GL_TEXTURE_2D;
+      break;
+   case ST_CONTEXT_RESOURCE_OPENGL_TEXTURE_3D:
+      target = GL_TEXTURE_3D;
+      break;
+   case ST_CONTEXT_RESOURCE_OPENGL_TEXTURE_CUBE_MAP_POSITIVE_X:
+   case ST_CONTEXT_RESOURCE_OPENGL_TEXTURE_CUBE_MAP_NEGATIVE_X:
+   case ST_CONTEXT_RESOURCE_OPENGL_TEXTURE_CUBE_MAP_POSITIVE_Y:
+   case ST_CONTEXT_RESOURCE_OPENGL_TEXTURE_CUBE_MAP_NEGATIVE_Y:
+   case ST_CONTEXT_RESOURCE_OPENGL_TEXTURE_CUBE_MAP_POSITIVE_Z:
+   case ST_CONTEXT_RESOURCE_OPENGL_TEXTURE_CUBE_MAP_NEGATIVE_Z:
+      target = GL_TEXTURE_CUBE_MAP;
+      break;
+   case ST_CONTEXT_RESOURCE_OPENGL_RENDERBUFFER:
+      target = GL_RENDERBUFFER;
+      break;
+   default:
+      return FALSE;
+   }
+
+   /* st_finalize_texture() and st_flush() use the context */
+   if (!name || cur != ctx)
+      return FALSE;
+
+   if (target == GL_RENDERBUFFER) {
+      struct gl_renderbuffer *rb = _mesa_lookup_renderbuffer(ctx, name);
+      if (!rb)
+         return FALSE;
+      ptex = st_renderbuffer(rb)->texture;
+   }
+   else {
+      struct gl_texture_object *texObj = _mesa_lookup_texture(ctx, name);
+      if (!texObj || texObj->Target != target)
+         return FALSE;
+      /* gather the images into a single resource the image can alias */
+      if (!st_finalize_texture(ctx, st->pipe, texObj))
+         return FALSE;
+      ptex = st_texture_object(texObj)->pt;
+   }
+
+   if (!ptex)
+      return FALSE;
+
+   /* make pending rendering to the resource visible to the siblings */
+   st_flush(st, PIPE_FLUSH_RENDER_CACHE, NULL);
+
+   stres->texture = NULL;
+   pipe_resource_reference(&stres->texture, ptex);
+
+   return TRUE;
+}
+
 static void
 st_context_destroy(struct st_context_iface *stctxi)
 {
@@ -705,7 +772,10 @@ st_api_create_context(struct st_api *stapi, struct st_manager *smapi,
    st->iface.teximage = st_context_teximage;
    st->iface.copy = st_context_copy;
    st->iface.share = st_context_share;
+   st->iface.get_resource_for_egl_image =
+      st_context_get_resource_for_egl_image;
    st->iface.st_context_private = (void *) smapi;
+   st->iface.pipe = st->pipe;
 
    return &st->iface;
 }
@@ -0,0 +1,296 @@
+/**************************************************************************
+ *
+ * Copyright 2011 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * Shader variant warm-up.
+ *
+ * Programs used to be translated to TGSI and handed to the driver the
+ * first time a draw used them, and the extra variants (edgeflag
+ * passthrough, the glBitmap prologue) the first time a draw needed
+ * those.  That is where the first-use stutter came from.
+ *
+ * With ST_PRECOMPILE (on by default) programs are translated as soon as
+ * the driver is told about them, i.e. from glProgramStringARB and
+ * glLinkProgram, for the variant which is used by ordinary draws.
+ *
+ * If ST_SHADER_MANIFEST names a file, the other variants created during
+ * the run are recorded there, keyed by a hash of the program's TGSI, and
+ * later runs build them together with the program.  The file is plain
+ * text with one "<hash> <variant mask>" line per program.
+ */
+
+
+#include <stdio.h>
+
+#include "main/imports.h"
+#include "main/mtypes.h"
+
+#include "pipe/p_state.h"
+#include "os/os_thread.h"
+#include "tgsi/tgsi_parse.h"
+#include "util/u_debug.h"
+#include "util/u_hash.h"
+
+#include "st_context.h"
+#include "st_cb_bitmap.h"
+#include "st_program.h"
+#include "st_precompile.h"
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(st_precompile, "ST_PRECOMPILE", TRUE)
+
+
+struct manifest_entry
+{
+   uint32_t hash;
+   unsigned variants;
+};
+
+
+/**
+ * The manifest is shared by all contexts in the process.
+ */
+static struct
+{
+   const char *filename;
+   boolean loaded;
+   boolean dirty;
+   unsigned count, size;
+   struct manifest_entry *entries;
+} Manifest;
+
+pipe_static_mutex(ManifestMutex);
+
+
+static uint32_t
+shader_hash(const struct pipe_shader_state *shader)
+{
+   return util_hash_crc32(shader->tokens,
+                          tgsi_num_tokens(shader->tokens) *
+                          sizeof(struct tgsi_token));
+}
+
+
+static struct manifest_entry *
+find_entry(uint32_t hash)
+{
+   unsigned i;
+   for (i = 0; i < Manifest.count; i++) {
+      if (Manifest.entries[i].hash == hash)
+         return &Manifest.entries[i];
+   }
+   return NULL;
+}
+
+
+static struct manifest_entry *
+add_entry(uint32_t hash)
+{
+   struct manifest_entry *entry;
+
+   if (Manifest.count == Manifest.size) {
+      unsigned size = Manifest.size ? Manifest.size * 2 : 64;
+      entry = (struct manifest_entry *)
+         realloc(Manifest.entries, size * sizeof *entry);
+      if (!entry)
+         return NULL;
+      Manifest.entries = entry;
+      Manifest.size = size;
+   }
+
+   entry = &Manifest.entries[Manifest.count++];
+   entry->hash = hash;
+   entry->variants = 0;
+   return entry;
+}
+
+
+static void
+load_manifest(void)
+{
+   FILE *f;
+   unsigned hash, variants;
+
+   Manifest.filename = debug_get_option("ST_SHADER_MANIFEST", NULL);
+   if (!Manifest.filename)
+      return;
+
+   f = fopen(Manifest.filename, "r");
+   if (!f)
+      return;
+
+   while (fscanf(f, "%x %x", &hash, &variants) == 2) {
+      struct manifest_entry *entry = find_entry(hash);
+      if (!entry)
+         entry = add_entry(hash);
+      if (entry)
+         entry->variants |= variants;
+   }
+
+   fclose(f);
+}
+
+
+static void
+save_manifest(void)
+{
+   FILE *f;
+   unsigned i;
+
+   f = fopen(Manifest.filename, "w");
+   if (!f) {
+      _mesa_warning(NULL, "couldn't write shader manifest %s",
+                    Manifest.filename);
+      return;
+   }
+
+   for (i = 0; i < Manifest.count; i++)
+      fprintf(f, "%08x %x\n", Manifest.entries[i].hash,
+              Manifest.entries[i].variants);
+
+   fclose(f);
+}
+
+
+/**
+ * Return the ST_VARIANT_x flags recorded for the given program.
+ */
+static unsigned
+lookup_variants(const struct pipe_shader_state *base)
+{
+   struct manifest_entry *entry;
+   unsigned variants = 0;
+
+   if (!Manifest.filename || !base->tokens)
+      return 0;
+
+   pipe_mutex_lock(ManifestMutex);
+   entry = find_entry(shader_hash(base));
+   if (entry)
+      variants = entry->variants;
+   pipe_mutex_unlock(ManifestMutex);
+
+   return variants;
+}
+
+
+/**
+ * Note that a non-default variant of a program was needed.
+ * \param base  the default variant's shader, which identifies the program
+ */
+void
+st_record_program_variant(struct st_context *st,
+                          const struct pipe_shader_state *base,
+                          unsigned variant)
+{
+   struct manifest_entry *entry;
+   uint32_t hash;
+
+   if (!Manifest.filename || !base->tokens)
+      return;
+
+   hash = shader_hash(base);
+
+   pipe_mutex_lock(ManifestMutex);
+   entry = find_entry(hash);
+   if (!entry)
+      entry = add_entry(hash);
+   if (entry && !(entry->variants & variant)) {
+      entry->variants |= variant;
+      Manifest.dirty = TRUE;
+   }
+   pipe_mutex_unlock(ManifestMutex);
+}
+
+
+/**
+ * Translate a program, and the variants the manifest lists for it, ahead
+ * of the first draw.  Called when the program string changes.
+ */
+void
+st_precompile_program(struct st_context *st, GLenum target,
+                      struct gl_program *prog)
+{
+   if (!debug_get_option_st_precompile())
+      return;
+
+   if (target == GL_FRAGMENT_PROGRAM_ARB) {
+      struct st_fragment_program *stfp = (struct st_fragment_program *) prog;
+
+      if (prog->NumInstructions == 0)
+         return;
+
+      if (!stfp->tgsi.tokens)
+         st_translate_fragment_program(st, stfp);
+
+      if (lookup_variants(&stfp->tgsi) & ST_VARIANT_FP_BITMAP)
+         st_get_bitmap_fragment_program(st, stfp);
+   }
+   else if (target == GL_VERTEX_PROGRAM_ARB) {
+      struct st_vertex_program *stvp = (struct st_vertex_program *) prog;
+      struct st_vp_varient_key key;
+      struct st_vp_varient *vpv;
+
+      memset(&key, 0, sizeof key);
+      vpv = st_get_vp_varient(st, stvp, &key);
+
+      if (vpv && (lookup_variants(&vpv->tgsi) & ST_VARIANT_VP_EDGEFLAGS)) {
+         key.passthrough_edgeflags = TRUE;
+         st_get_vp_varient(st, stvp, &key);
+      }
+   }
+   else if (target == MESA_GEOMETRY_PROGRAM) {
+      struct st_geometry_program *stgp = (struct st_geometry_program *) prog;
+
+      if (prog->NumInstructions > 1 && !stgp->tgsi.tokens)
+         st_translate_geometry_program(st, stgp);
+   }
+}
+
+
+void
+st_init_precompile(struct st_context *st)
+{
+   pipe_mutex_lock(ManifestMutex);
+   if (!Manifest.loaded) {
+      load_manifest();
+      Manifest.loaded = TRUE;
+   }
+   pipe_mutex_unlock(ManifestMutex);
+}
+
+
+void
+st_destroy_precompile(struct st_context *st)
+{
+   pipe_mutex_lock(ManifestMutex);
+   if (Manifest.filename && Manifest.dirty) {
+      save_manifest();
+      Manifest.dirty = FALSE;
+   }
+   pipe_mutex_unlock(ManifestMutex);
+}
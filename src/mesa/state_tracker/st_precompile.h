@@ -0,0 +1,60 @@
+/**************************************************************************
+ *
+ * Copyright 2011 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+#ifndef ST_PRECOMPILE_H
+#define ST_PRECOMPILE_H
+
+#include "main/glheader.h"
+#include "pipe/p_compiler.h"
+
+struct gl_program;
+struct pipe_shader_state;
+struct st_context;
+
+
+/** Non-default program variants, as recorded in the shader manifest */
+#define ST_VARIANT_VP_EDGEFLAGS  0x1  /**< vertex program with edgeflags */
+#define ST_VARIANT_FP_BITMAP     0x2  /**< fragment program with glBitmap prologue */
+
+
+extern void
+st_init_precompile(struct st_context *st);
+
+extern void
+st_destroy_precompile(struct st_context *st);
+
+extern void
+st_precompile_program(struct st_context *st, GLenum target,
+                      struct gl_program *prog);
+
+extern void
+st_record_program_variant(struct st_context *st,
+                          const struct pipe_shader_state *base,
+                          unsigned variant);
+
+
+#endif /* ST_PRECOMPILE_H */
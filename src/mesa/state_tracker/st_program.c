@@ -46,6 +46,7 @@
 #include "st_debug.h"
 #include "st_context.h"
 #include "st_program.h"
+#include "st_precompile.h"
 #include "st_mesa_to_tgsi.h"
 #include "cso_cache/cso_context.h"
 
@@ -278,6 +279,64 @@ fail:
 
 
 
+
+/**
+ * Find the translated variant of a vertex program for the given key,
+ * translating it first if needed.
+ */
+struct st_vp_varient *
+st_get_vp_varient(struct st_context *st,
+                  struct st_vertex_program *stvp,
+                  const struct st_vp_varient_key *key)
+{
+   struct st_vp_varient *vpv;
+
+   /* Do we need to throw away old translations after a change in the
+    * GL program string?
+    */
+   if (stvp->serialNo != stvp->lastSerialNo) {
+      /* These may have changed if the program string changed.
+       */
+      st_prepare_vertex_program( st, stvp );
+
+      /* We are now up-to-date:
+       */
+      stvp->lastSerialNo = stvp->serialNo;
+   }
+
+   /* See if we've got a translated vertex program whose outputs match
+    * the fragment program's inputs.
+    */
+   for (vpv = stvp->varients; vpv; vpv = vpv->next) {
+      if (memcmp(&vpv->key, key, sizeof *key) == 0) {
+         return vpv;
+      }
+   }
+
+   /* No?  Perform new translation here. */
+   vpv = st_translate_vertex_program(st, stvp, key);
+   if (!vpv)
+      return NULL;
+
+   vpv->next = stvp->varients;
+   stvp->varients = vpv;
+
+   if (key->passthrough_edgeflags) {
+      /* remember that this program needs the edgeflag variant */
+      struct st_vp_varient *base;
+      for (base = stvp->varients; base; base = base->next) {
+         if (!base->key.passthrough_edgeflags) {
+            st_record_program_variant(st, &base->tgsi,
+                                      ST_VARIANT_VP_EDGEFLAGS);
+            break;
+         }
+      }
+   }
+
+   return vpv;
+}
+
+
 /**
  * Translate a Mesa fragment shader into a TGSI shader.
  * \return  pointer to cached pipe_shader object.
@@ -218,6 +218,11 @@ st_translate_vertex_program(struct st_context *st,
                             struct st_vertex_program *stvp,
                             const struct st_vp_varient_key *key);
 
+extern struct st_vp_varient *
+st_get_vp_varient(struct st_context *st,
+                  struct st_vertex_program *stvp,
+                  const struct st_vp_varient_key *key);
+
 void
 st_vp_release_varients( struct st_context *st,
                         struct st_vertex_program *stvp );
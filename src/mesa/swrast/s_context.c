@@ -36,6 +36,7 @@
 #include "swrast.h"
 #include "s_blend.h"
 #include "s_context.h"
+#include "s_fragprog_soa.h"
 #include "s_lines.h"
 #include "s_points.h"
 #include "s_span.h"
@@ -274,6 +275,10 @@ _swrast_update_fragment_program(struct gl_context *ctx, GLbitfield newState)
    if (fp) {
       _mesa_load_state_parameters(ctx, fp->Base.Parameters);
    }
+
+   /* the program may have been replaced or recompiled in place */
+   if (newState & _NEW_PROGRAM)
+      _swrast_free_fragment_program_soa(ctx);
 }
 
 
@@ -860,6 +865,7 @@ _swrast_DestroyContext( struct gl_context *ctx )
    if (swrast->ZoomedArrays)
       FREE( swrast->ZoomedArrays );
    FREE( swrast->TexelBuffer );
+   _swrast_free_fragment_program_soa(ctx);
    FREE( swrast );
 
    ctx->swrast_context = 0;
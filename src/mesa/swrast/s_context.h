@@ -230,6 +230,9 @@ typedef struct
    /** State used during execution of fragment programs */
    struct gl_program_machine FragProgMachine;
 
+   /** Current fragment program, decoded for span-at-a-time execution */
+   struct swrast_soa_program *FragProgSoa;
+
 } SWcontext;
 
 
@@ -28,6 +28,7 @@
 
 #include "s_context.h"
 #include "s_fragprog.h"
+#include "s_fragprog_soa.h"
 #include "s_span.h"
 
 
@@ -262,7 +263,9 @@ _swrast_exec_fragment_program( struct gl_context *ctx, SWspan *span )
       ASSERT(span->array->ChanType == GL_FLOAT);
    }
 
-   run_program(ctx, span, 0, span->end);
+   /* Run simple programs on the whole span at once, else per fragment */
+   if (!_swrast_exec_fragment_program_soa(ctx, span))
+      run_program(ctx, span, 0, span->end);
 
    if (program->Base.OutputsWritten & BITFIELD64_BIT(FRAG_RESULT_COLOR)) {
       span->interpMask &= ~SPAN_RGBA;
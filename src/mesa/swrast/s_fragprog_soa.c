@@ -0,0 +1,1306 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.11
+ *
+ * Copyright (C) 2011  VMware, Inc.   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * VMWARE BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file s_fragprog_soa.c
+ * Span-at-a-time execution of fragment programs.
+ *
+ * The Mesa IR program is decoded once into a compact form in which all
+ * register lookups, swizzles and modifiers are resolved.  Then each
+ * instruction is run across a whole chunk of the span, with registers
+ * stored as one array of values per channel (SoA).  Texture instructions
+ * sample all fragments of the chunk with a single call.
+ *
+ * The results match _mesa_execute_program().  Programs using features
+ * which don't map to this (loops, subroutines, address registers,
+ * condition codes, etc) are run with the per-fragment interpreter.
+ */
+
+#include "main/glheader.h"
+#include "main/colormac.h"
+#include "main/imports.h"
+#include "main/macros.h"
+#include "program/prog_instruction.h"
+#include "program/prog_parameter.h"
+
+#include "s_context.h"
+#include "s_fragprog_soa.h"
+#include "s_span.h"
+#include "s_texfilter.h"
+
+
+/** Number of fragments processed per pass over the program */
+#define SOA_WIDTH 64
+
+/** Max nesting of IF/ELSE/ENDIF */
+#define SOA_MAX_IF_DEPTH 16
+
+
+enum soa_file
+{
+   SOA_FILE_NONE,      /**< write-only dest register */
+   SOA_FILE_TEMP,
+   SOA_FILE_OUTPUT,
+   SOA_FILE_INPUT,
+   SOA_FILE_CONST      /**< same value for all fragments */
+};
+
+
+struct soa_src_register
+{
+   GLubyte File;          /**< SOA_FILE_x */
+   GLubyte Swizzle[4];    /**< SWIZZLE_X/Y/Z/W/ZERO/ONE */
+   GLubyte Negate;        /**< per-channel bitmask */
+   GLboolean Abs;
+   GLuint Index;
+   const GLfloat *Values; /**< for SOA_FILE_CONST */
+};
+
+
+struct soa_dst_register
+{
+   GLubyte File;          /**< SOA_FILE_NONE, TEMP or OUTPUT */
+   GLubyte WriteMask;
+   GLboolean Saturate;
+   GLuint Index;
+};
+
+
+struct soa_instruction
+{
+   gl_inst_opcode Opcode;
+   struct soa_dst_register DstReg;
+   struct soa_src_register SrcReg[3];
+   GLint BranchTarget;
+   GLuint TexSrcUnit;
+   GLboolean TexDeriv;    /**< use the input attrib's derivatives for LOD */
+};
+
+
+struct swrast_soa_program
+{
+   /** The program this was decoded from, and whether it can be run here */
+   const struct gl_fragment_program *Program;
+   GLboolean Supported;
+
+   struct soa_instruction *Instructions;
+   GLuint NumInstructions;
+
+   /** Registers, one array of SOA_WIDTH values per channel */
+   GLfloat (*Temps)[4][SOA_WIDTH];
+   GLuint NumTemps;
+   GLfloat Outputs[FRAG_RESULT_MAX][4][SOA_WIDTH];
+
+   /** Scratch space for source operands and instruction results */
+   GLfloat Src[3][4][SOA_WIDTH];
+   GLfloat Result[4][SOA_WIDTH];
+
+   /** Scratch space for texture sampling */
+   GLfloat TexCoords[SOA_WIDTH][4];
+   GLfloat Lambda[SOA_WIDTH];
+   GLfloat Texels[SOA_WIDTH][4];
+};
+
+
+static const GLfloat ZeroVec[4] = { 0.0F, 0.0F, 0.0F, 0.0F };
+
+
+/**
+ * Number of source operands read by each supported opcode, or -1 if the
+ * opcode isn't supported by the span interpreter.
+ */
+static GLint
+soa_num_src(gl_inst_opcode opcode)
+{
+   switch (opcode) {
+   case OPCODE_NOP:
+   case OPCODE_END:
+   case OPCODE_ELSE:
+   case OPCODE_ENDIF:
+   case OPCODE_KIL_NV:
+   case OPCODE_SFL:
+   case OPCODE_STR:
+      return 0;
+   case OPCODE_ABS:
+   case OPCODE_COS:
+   case OPCODE_DDX:
+   case OPCODE_DDY:
+   case OPCODE_EX2:
+   case OPCODE_FLR:
+   case OPCODE_FRC:
+   case OPCODE_IF:
+   case OPCODE_KIL:
+   case OPCODE_LG2:
+   case OPCODE_LIT:
+   case OPCODE_MOV:
+   case OPCODE_RCP:
+   case OPCODE_RSQ:
+   case OPCODE_SCS:
+   case OPCODE_SIN:
+   case OPCODE_SSG:
+   case OPCODE_SWZ:
+   case OPCODE_TEX:
+   case OPCODE_TXB:
+   case OPCODE_TXL:
+   case OPCODE_TXP:
+   case OPCODE_TRUNC:
+      return 1;
+   case OPCODE_ADD:
+   case OPCODE_DP2:
+   case OPCODE_DP3:
+   case OPCODE_DP4:
+   case OPCODE_DPH:
+   case OPCODE_DST:
+   case OPCODE_MAX:
+   case OPCODE_MIN:
+   case OPCODE_MUL:
+   case OPCODE_POW:
+   case OPCODE_SEQ:
+   case OPCODE_SGE:
+   case OPCODE_SGT:
+   case OPCODE_SLE:
+   case OPCODE_SLT:
+   case OPCODE_SNE:
+   case OPCODE_SUB:
+   case OPCODE_XPD:
+      return 2;
+   case OPCODE_CMP:
+   case OPCODE_LRP:
+   case OPCODE_MAD:
+      return 3;
+   default:
+      return -1;
+   }
+}
+
+
+/**
+ * Decode a source register.
+ * \return GL_FALSE if it can't be handled here.
+ */
+static GLboolean
+decode_src(struct gl_context *ctx, const struct gl_program *prog,
+           const struct prog_instruction *inst,
+           const struct prog_src_register *src,
+           const GLint *tempMap, struct soa_src_register *dst)
+{
+   const GLint reg = src->Index;
+   GLuint i;
+
+   if (src->RelAddr)
+      return GL_FALSE;
+
+   for (i = 0; i < 4; i++)
+      dst->Swizzle[i] = GET_SWZ(src->Swizzle, i);
+
+   if (inst->Opcode == OPCODE_SWZ) {
+      /* extended swizzle: per-channel negation, no abs */
+      dst->Negate = src->Negate;
+      dst->Abs = GL_FALSE;
+   }
+   else {
+      /* as in fetch_vector4(), negation applies to all channels */
+      dst->Negate = src->Negate ? NEGATE_XYZW : NEGATE_NONE;
+      dst->Abs = src->Abs;
+   }
+
+   dst->Index = 0;
+   dst->Values = NULL;
+
+   switch (src->File) {
+   case PROGRAM_TEMPORARY:
+      if (reg < 0 || reg >= MAX_PROGRAM_TEMPS) {
+         dst->File = SOA_FILE_CONST;
+         dst->Values = ZeroVec;
+      }
+      else {
+         dst->File = SOA_FILE_TEMP;
+         dst->Index = tempMap[reg];
+      }
+      return GL_TRUE;
+   case PROGRAM_INPUT:
+      if (reg < 0 || reg >= FRAG_ATTRIB_MAX) {
+         dst->File = SOA_FILE_CONST;
+         dst->Values = ZeroVec;
+      }
+      else {
+         dst->File = SOA_FILE_INPUT;
+         dst->Index = reg;
+      }
+      return GL_TRUE;
+   case PROGRAM_OUTPUT:
+      if (reg < 0 || reg >= FRAG_RESULT_MAX) {
+         dst->File = SOA_FILE_CONST;
+         dst->Values = ZeroVec;
+      }
+      else {
+         dst->File = SOA_FILE_OUTPUT;
+         dst->Index = reg;
+      }
+      return GL_TRUE;
+   case PROGRAM_LOCAL_PARAM:
+      dst->File = SOA_FILE_CONST;
+      dst->Values = (reg < 0 || reg >= MAX_PROGRAM_LOCAL_PARAMS)
+         ? ZeroVec : prog->LocalParams[reg];
+      return GL_TRUE;
+   case PROGRAM_ENV_PARAM:
+      dst->File = SOA_FILE_CONST;
+      dst->Values = (reg < 0 || reg >= MAX_PROGRAM_ENV_PARAMS)
+         ? ZeroVec : ctx->FragmentProgram.Parameters[reg];
+      return GL_TRUE;
+   case PROGRAM_STATE_VAR:
+   case PROGRAM_CONSTANT:
+   case PROGRAM_UNIFORM:
+   case PROGRAM_NAMED_PARAM:
+      dst->File = SOA_FILE_CONST;
+      dst->Values = (reg < 0 || reg >= (GLint) prog->Parameters->NumParameters)
+         ? ZeroVec : prog->Parameters->ParameterValues[reg];
+      return GL_TRUE;
+   default:
+      return GL_FALSE;
+   }
+}
+
+
+/**
+ * Decode the given fragment program into p.
+ * \return GL_FALSE if the program can't be run by the span interpreter
+ *         (or out of memory).
+ */
+static GLboolean
+decode_program(struct gl_context *ctx, struct swrast_soa_program *p,
+               const struct gl_fragment_program *fp)
+{
+   const struct gl_program *prog = &fp->Base;
+   GLint tempMap[MAX_PROGRAM_TEMPS];
+   GLuint pc, i, depth = 0;
+
+   /* assign a compact register slot to each temp used */
+   for (i = 0; i < MAX_PROGRAM_TEMPS; i++)
+      tempMap[i] = -1;
+   p->NumTemps = 0;
+   for (pc = 0; pc < prog->NumInstructions; pc++) {
+      const struct prog_instruction *inst = prog->Instructions + pc;
+      const GLint numSrc = soa_num_src(inst->Opcode);
+
+      if (numSrc < 0)
+         return GL_FALSE;
+
+      for (i = 0; i < (GLuint) numSrc; i++) {
+         const struct prog_src_register *src = &inst->SrcReg[i];
+         if (src->File == PROGRAM_TEMPORARY &&
+             src->Index >= 0 && src->Index < MAX_PROGRAM_TEMPS &&
+             tempMap[src->Index] < 0)
+            tempMap[src->Index] = p->NumTemps++;
+      }
+      if (inst->DstReg.File == PROGRAM_TEMPORARY &&
+          inst->DstReg.Index < MAX_PROGRAM_TEMPS &&
+          tempMap[inst->DstReg.Index] < 0)
+         tempMap[inst->DstReg.Index] = p->NumTemps++;
+   }
+
+   p->Instructions = (struct soa_instruction *)
+      calloc(MAX2(prog->NumInstructions, 1), sizeof(struct soa_instruction));
+   p->Temps = (GLfloat (*)[4][SOA_WIDTH])
+      calloc(MAX2(p->NumTemps, 1), sizeof(*p->Temps));
+   if (!p->Instructions || !p->Temps)
+      return GL_FALSE;
+
+   for (pc = 0; pc < prog->NumInstructions; pc++) {
+      const struct prog_instruction *inst = prog->Instructions + pc;
+      struct soa_instruction *soa = p->Instructions + pc;
+      const GLint numSrc = soa_num_src(inst->Opcode);
+
+      /* no condition codes (NV_fragment_program) */
+      if (inst->CondUpdate ||
+          (inst->DstReg.CondMask != COND_TR && inst->Opcode != OPCODE_IF))
+         return GL_FALSE;
+
+      soa->Opcode = inst->Opcode;
+
+      for (i = 0; i < (GLuint) numSrc; i++) {
+         if (!decode_src(ctx, prog, inst, &inst->SrcReg[i], tempMap,
+                         &soa->SrcReg[i]))
+            return GL_FALSE;
+      }
+
+      if (inst->DstReg.RelAddr)
+         return GL_FALSE;
+
+      switch (inst->DstReg.File) {
+      case PROGRAM_TEMPORARY:
+         if (inst->DstReg.Index < MAX_PROGRAM_TEMPS) {
+            soa->DstReg.File = SOA_FILE_TEMP;
+            soa->DstReg.Index = tempMap[inst->DstReg.Index];
+         }
+         else {
+            soa->DstReg.File = SOA_FILE_NONE;
+         }
+         break;
+      case PROGRAM_OUTPUT:
+         if (inst->DstReg.Index < FRAG_RESULT_MAX) {
+            soa->DstReg.File = SOA_FILE_OUTPUT;
+            soa->DstReg.Index = inst->DstReg.Index;
+         }
+         else {
+            soa->DstReg.File = SOA_FILE_NONE;
+         }
+         break;
+      default:
+         soa->DstReg.File = SOA_FILE_NONE;
+         break;
+      }
+      soa->DstReg.WriteMask = inst->DstReg.WriteMask;
+      soa->DstReg.Saturate = inst->SaturateMode == SATURATE_ZERO_ONE;
+
+      soa->BranchTarget = inst->BranchTarget;
+      soa->TexSrcUnit = inst->TexSrcUnit;
+      /* as in fetch_texel() */
+      soa->TexDeriv = (inst->Opcode != OPCODE_TXL &&
+                       inst->SrcReg[0].File == PROGRAM_INPUT &&
+                       inst->SrcReg[0].Index ==
+                       (GLint) (FRAG_ATTRIB_TEX0 + inst->TexSrcUnit));
+
+      switch (inst->Opcode) {
+      case OPCODE_IF:
+         /* only the GLSL form, which tests src[0].x */
+         if (inst->SrcReg[0].File == PROGRAM_UNDEFINED)
+            return GL_FALSE;
+         if (++depth > SOA_MAX_IF_DEPTH)
+            return GL_FALSE;
+         break;
+      case OPCODE_ENDIF:
+         if (depth == 0)
+            return GL_FALSE;
+         depth--;
+         break;
+      default:
+         ;
+      }
+   }
+
+   p->NumInstructions = prog->NumInstructions;
+   return GL_TRUE;
+}
+
+
+/**
+ * Get the given decoded program, decoding it if needed.
+ */
+static struct swrast_soa_program *
+get_soa_program(struct gl_context *ctx, const struct gl_fragment_program *fp)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_soa_program *p = swrast->FragProgSoa;
+
+   if (p && p->Program == fp)
+      return p;
+
+   _swrast_free_fragment_program_soa(ctx);
+
+   p = CALLOC_STRUCT(swrast_soa_program);
+   if (!p)
+      return NULL;
+
+   p->Program = fp;
+   p->Supported = decode_program(ctx, p, fp);
+   if (!p->Supported) {
+      /* keep the (empty) object so that we don't try again for each span */
+      free(p->Instructions);
+      free(p->Temps);
+      p->Instructions = NULL;
+      p->Temps = NULL;
+      p->NumInstructions = 0;
+   }
+
+   swrast->FragProgSoa = p;
+   return p;
+}
+
+
+/**
+ * Free the decoded program.  Called when the fragment program changes.
+ */
+void
+_swrast_free_fragment_program_soa(struct gl_context *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_soa_program *p = swrast->FragProgSoa;
+
+   if (p) {
+      free(p->Instructions);
+      free(p->Temps);
+      FREE(p);
+      swrast->FragProgSoa = NULL;
+   }
+}
+
+
+/**
+ * Per-chunk execution state.
+ */
+struct soa_machine
+{
+   struct gl_context *ctx;
+   struct swrast_soa_program *p;
+   const SWspan *span;
+   GLuint start;             /**< first fragment of chunk in the span */
+   GLuint n;                 /**< number of fragments in chunk */
+   GLboolean predicate;      /**< inside IF: writes are masked by Exec[] */
+   GLubyte Live[SOA_WIDTH];  /**< fragments not masked out or killed */
+   GLubyte Exec[SOA_WIDTH];  /**< fragments executing current instruction */
+};
+
+
+/**
+ * Return an array with channel 'chan' of the source operand, after
+ * swizzling and abs/negation, for all fragments in the chunk.
+ */
+static const GLfloat *
+fetch_channel(const struct soa_machine *m, const struct soa_src_register *src,
+              GLuint chan, GLfloat *scratch)
+{
+   struct swrast_soa_program *p = m->p;
+   const GLuint swz = src->Swizzle[chan];
+   const GLboolean negate = (src->Negate >> chan) & 1;
+   const GLuint n = m->n;
+   const GLfloat *values;
+   GLuint i;
+
+   if (src->File == SOA_FILE_CONST || swz > SWIZZLE_W) {
+      GLfloat v;
+      if (swz == SWIZZLE_ZERO)
+         v = 0.0F;
+      else if (swz == SWIZZLE_ONE)
+         v = 1.0F;
+      else
+         v = src->Values[swz];
+      if (src->Abs)
+         v = FABSF(v);
+      if (negate)
+         v = -v;
+      for (i = 0; i < n; i++)
+         scratch[i] = v;
+      return scratch;
+   }
+
+   switch (src->File) {
+   case SOA_FILE_TEMP:
+      values = p->Temps[src->Index][swz];
+      break;
+   case SOA_FILE_OUTPUT:
+      values = p->Outputs[src->Index][swz];
+      break;
+   default:
+      {
+         /* input attributes are stored as 4-vectors per fragment */
+         const GLfloat (*attr)[4] = (const GLfloat (*)[4])
+            m->span->array->attribs[src->Index] + m->start;
+         for (i = 0; i < n; i++)
+            scratch[i] = attr[i][swz];
+         values = scratch;
+      }
+      break;
+   }
+
+   if (src->Abs) {
+      for (i = 0; i < n; i++)
+         scratch[i] = FABSF(values[i]);
+      values = scratch;
+   }
+   if (negate) {
+      for (i = 0; i < n; i++)
+         scratch[i] = -values[i];
+      values = scratch;
+   }
+
+   return values;
+}
+
+
+/**
+ * Return the derivative of a source operand, as in fetch_vector4_deriv().
+ */
+static const GLfloat *
+fetch_channel_deriv(const struct soa_machine *m,
+                    const struct soa_src_register *src, GLuint chan,
+                    GLboolean dy, GLfloat *scratch)
+{
+   const GLuint swz = src->Swizzle[chan];
+   const GLuint n = m->n;
+   GLuint i;
+
+   if (src->File == SOA_FILE_INPUT && swz <= SWIZZLE_W) {
+      const GLfloat (*wpos)[4] = (const GLfloat (*)[4])
+         m->span->array->attribs[FRAG_ATTRIB_WPOS] + m->start;
+      const GLfloat d = dy ? m->span->attrStepY[src->Index][swz]
+                           : m->span->attrStepX[src->Index][swz];
+      for (i = 0; i < n; i++) {
+         const GLfloat invQ = 1.0f / wpos[i][3];
+         GLfloat v = d * invQ;
+         if (src->Abs)
+            v = FABSF(v);
+         if (src->Negate)
+            v = -v;
+         scratch[i] = v;
+      }
+   }
+   else {
+      for (i = 0; i < n; i++)
+         scratch[i] = 0.0F;
+   }
+
+   return scratch;
+}
+
+
+/**
+ * Store the instruction result, observing the write mask, saturation
+ * and, inside IF blocks, the execution mask.
+ */
+static void
+store_result(struct soa_machine *m, const struct soa_instruction *inst,
+             const GLfloat *result[4])
+{
+   struct swrast_soa_program *p = m->p;
+   const struct soa_dst_register *dstReg = &inst->DstReg;
+   const GLuint n = m->n;
+   GLfloat (*dst)[SOA_WIDTH];
+   GLuint chan, i;
+
+   if (dstReg->File == SOA_FILE_TEMP)
+      dst = p->Temps[dstReg->Index];
+   else if (dstReg->File == SOA_FILE_OUTPUT)
+      dst = p->Outputs[dstReg->Index];
+   else
+      return;
+
+   for (chan = 0; chan < 4; chan++) {
+      const GLfloat *r = result[chan];
+      GLfloat *d = dst[chan];
+
+      if (!(dstReg->WriteMask & (1 << chan)))
+         continue;
+
+      if (m->predicate) {
+         if (dstReg->Saturate) {
+            for (i = 0; i < n; i++)
+               if (m->Exec[i])
+                  d[i] = CLAMP(r[i], 0.0F, 1.0F);
+         }
+         else {
+            for (i = 0; i < n; i++)
+               if (m->Exec[i])
+                  d[i] = r[i];
+         }
+      }
+      else {
+         if (dstReg->Saturate) {
+            for (i = 0; i < n; i++)
+               d[i] = CLAMP(r[i], 0.0F, 1.0F);
+         }
+         else {
+            memcpy(d, r, n * sizeof(GLfloat));
+         }
+      }
+   }
+}
+
+
+/**
+ * Store a scalar result to all enabled channels of the dest register.
+ */
+static void
+store_scalar(struct soa_machine *m, const struct soa_instruction *inst,
+             const GLfloat *result)
+{
+   const GLfloat *res[4];
+   res[0] = res[1] = res[2] = res[3] = result;
+   store_result(m, inst, res);
+}
+
+
+/**
+ * Apply texture object's swizzle (X/Y/Z/W/0/1) to the sampled texels.
+ */
+static void
+swizzle_texels(struct soa_machine *m, const struct gl_texture_object *texObj,
+               GLuint count, const GLuint index[])
+{
+   struct swrast_soa_program *p = m->p;
+   const GLuint swizzle = texObj->_Swizzle;
+   GLuint chan, k;
+
+   for (chan = 0; chan < 4; chan++) {
+      const GLuint swz = GET_SWZ(swizzle, chan);
+      GLfloat *r = p->Result[chan];
+      if (swz <= SWIZZLE_W) {
+         for (k = 0; k < count; k++)
+            r[index[k]] = p->Texels[k][swz];
+      }
+      else {
+         const GLfloat v = (swz == SWIZZLE_ONE) ? 1.0F : 0.0F;
+         for (k = 0; k < count; k++)
+            r[index[k]] = v;
+      }
+   }
+}
+
+
+/**
+ * TEX, TXB, TXL and TXP: sample the texture for the executing fragments
+ * of the chunk with as few calls as possible.  The LOD is computed per
+ * fragment as in fetch_texel_lod() / fetch_texel_deriv() in s_fragprog.c.
+ */
+static void
+exec_tex(struct soa_machine *m, const struct soa_instruction *inst)
+{
+   struct gl_context *ctx = m->ctx;
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_soa_program *p = m->p;
+   const GLuint unit = p->Program->Base.SamplerUnits[inst->TexSrcUnit];
+   const struct gl_texture_unit *texUnit = &ctx->Texture.Unit[unit];
+   const struct gl_texture_object *texObj = texUnit->_Current;
+   const GLuint n = m->n;
+   const GLfloat *coord[4];
+   const GLfloat *res[4];
+   GLuint index[SOA_WIDTH];
+   GLuint chan, i, count = 0;
+
+   for (chan = 0; chan < 4; chan++) {
+      res[chan] = p->Result[chan];
+      if (!texObj) {
+         const GLfloat v = (chan == 3) ? 1.0F : 0.0F;
+         for (i = 0; i < n; i++)
+            p->Result[chan][i] = v;
+      }
+   }
+
+   if (!texObj) {
+      store_result(m, inst, res);
+      return;
+   }
+
+   for (chan = 0; chan < 4; chan++)
+      coord[chan] = fetch_channel(m, &inst->SrcReg[0], chan, p->Src[0][chan]);
+
+   /* Gather the coordinates of the executing fragments */
+   for (i = 0; i < n; i++) {
+      GLfloat *texcoord;
+      GLfloat lodBias = 0.0F, lambda;
+
+      if (!m->Exec[i])
+         continue;
+
+      texcoord = p->TexCoords[count];
+      texcoord[0] = coord[0][i];
+      texcoord[1] = coord[1][i];
+      texcoord[2] = coord[2][i];
+      texcoord[3] = coord[3][i];
+
+      if (inst->Opcode == OPCODE_TXP) {
+         if (texcoord[3] != 0.0) {
+            texcoord[0] /= texcoord[3];
+            texcoord[1] /= texcoord[3];
+            texcoord[2] /= texcoord[3];
+         }
+      }
+      else if (inst->Opcode == OPCODE_TXB ||
+               inst->Opcode == OPCODE_TXL) {
+         lodBias = texcoord[3];
+      }
+
+      if (inst->TexDeriv) {
+         const GLuint attr = FRAG_ATTRIB_TEX0 + inst->TexSrcUnit;
+         const GLfloat *texdx = m->span->attrStepX[attr];
+         const GLfloat *texdy = m->span->attrStepY[attr];
+         const struct gl_texture_image *texImg =
+            texObj->Image[0][texObj->BaseLevel];
+         const GLfloat texW = (GLfloat) texImg->WidthScale;
+         const GLfloat texH = (GLfloat) texImg->HeightScale;
+
+         lambda = _swrast_compute_lambda(texdx[0], texdy[0],
+                                         texdx[1], texdy[1],
+                                         texdx[3], texdy[3],
+                                         texW, texH,
+                                         texcoord[0], texcoord[1],
+                                         texcoord[3],
+                                         1.0F / texcoord[3]);
+
+         lambda += lodBias + texUnit->LodBias + texObj->LodBias;
+      }
+      else {
+         lambda = lodBias;
+      }
+
+      p->Lambda[count] = CLAMP(lambda, texObj->MinLod, texObj->MaxLod);
+      index[count++] = i;
+   }
+
+   if (count > 0) {
+      /* The samplers choose between the min and mag filters from the
+       * first and last lambda only, assuming lambda is monotonic.  With
+       * TXB/TXL it can go up and down along the chunk, so sample each
+       * run of fragments that are all minified or all magnified with
+       * its own call.
+       */
+      const GLboolean split = texObj->MinFilter != texObj->MagFilter;
+      const GLfloat thresh = split ? _swrast_min_mag_threshold(texObj) : 0.0F;
+      GLuint start = 0;
+
+      for (i = 1; i <= count; i++) {
+         if (i == count ||
+             (split && ((p->Lambda[i] > thresh) !=
+                        (p->Lambda[start] > thresh)))) {
+            swrast->TextureSample[unit](ctx, texObj, i - start,
+                               (const GLfloat (*)[4]) (p->TexCoords + start),
+                               p->Lambda + start, p->Texels + start);
+            start = i;
+         }
+      }
+
+      swizzle_texels(m, texObj, count, index);
+   }
+
+   store_result(m, inst, res);
+}
+
+
+/** Helpers for the component-wise instructions */
+#define FOR_EACH_DST_CHANNEL(inst, chan)                           \
+   for (chan = 0; chan < 4; chan++)                                \
+      if ((inst)->DstReg.WriteMask & (1 << chan))
+
+#define UNARY_OP(EXPR)                                                   \
+   do {                                                                  \
+      FOR_EACH_DST_CHANNEL(inst, chan) {                                 \
+         const GLfloat *a = fetch_channel(m, &inst->SrcReg[0], chan,     \
+                                          p->Src[0][chan]);              \
+         GLfloat *r = p->Result[chan];                                   \
+         for (i = 0; i < n; i++)                                         \
+            r[i] = (EXPR);                                               \
+      }                                                                  \
+      store_result(m, inst, res);                                        \
+   } while (0)
+
+#define BINARY_OP(EXPR)                                                  \
+   do {                                                                  \
+      FOR_EACH_DST_CHANNEL(inst, chan) {                                 \
+         const GLfloat *a = fetch_channel(m, &inst->SrcReg[0], chan,     \
+                                          p->Src[0][chan]);              \
+         const GLfloat *b = fetch_channel(m, &inst->SrcReg[1], chan,     \
+                                          p->Src[1][chan]);              \
+         GLfloat *r = p->Result[chan];                                   \
+         for (i = 0; i < n; i++)                                         \
+            r[i] = (EXPR);                                               \
+      }                                                                  \
+      store_result(m, inst, res);                                        \
+   } while (0)
+
+#define TERNARY_OP(EXPR)                                                 \
+   do {                                                                  \
+      FOR_EACH_DST_CHANNEL(inst, chan) {                                 \
+         const GLfloat *a = fetch_channel(m, &inst->SrcReg[0], chan,     \
+                                          p->Src[0][chan]);              \
+         const GLfloat *b = fetch_channel(m, &inst->SrcReg[1], chan,     \
+                                          p->Src[1][chan]);              \
+         const GLfloat *c = fetch_channel(m, &inst->SrcReg[2], chan,     \
+                                          p->Src[2][chan]);              \
+         GLfloat *r = p->Result[chan];                                   \
+         for (i = 0; i < n; i++)                                         \
+            r[i] = (EXPR);                                               \
+      }                                                                  \
+      store_result(m, inst, res);                                        \
+   } while (0)
+
+/** Scalar instructions: compute from src[0].x (and src[1].x) */
+#define SCALAR_OP(EXPR)                                                  \
+   do {                                                                  \
+      const GLfloat *a = fetch_channel(m, &inst->SrcReg[0], 0,           \
+                                       p->Src[0][0]);                    \
+      GLfloat *r = p->Result[0];                                         \
+      for (i = 0; i < n; i++)                                            \
+         r[i] = (EXPR);                                                  \
+      store_scalar(m, inst, r);                                          \
+   } while (0)
+
+
+/**
+ * Run the decoded program on one chunk of the span.
+ */
+static void
+run_chunk(struct soa_machine *m)
+{
+   struct swrast_soa_program *p = m->p;
+   const GLuint n = m->n;
+   const GLfloat *res[4];
+   GLubyte condStack[SOA_MAX_IF_DEPTH][SOA_WIDTH];
+   GLubyte execStack[SOA_MAX_IF_DEPTH][SOA_WIDTH];
+   GLuint depth = 0;
+   GLuint pc, chan, i;
+
+   res[0] = p->Result[0];
+   res[1] = p->Result[1];
+   res[2] = p->Result[2];
+   res[3] = p->Result[3];
+
+   memcpy(m->Exec, m->Live, n);
+   m->predicate = GL_FALSE;
+
+   for (pc = 0; pc < p->NumInstructions; pc++) {
+      const struct soa_instruction *inst = p->Instructions + pc;
+
+      switch (inst->Opcode) {
+      case OPCODE_NOP:
+         break;
+      case OPCODE_END:
+         return;
+
+      case OPCODE_ABS:
+         UNARY_OP(FABSF(a[i]));
+         break;
+      case OPCODE_ADD:
+         BINARY_OP(a[i] + b[i]);
+         break;
+      case OPCODE_CMP:
+         TERNARY_OP(a[i] < 0.0F ? b[i] : c[i]);
+         break;
+      case OPCODE_COS:
+         SCALAR_OP((GLfloat) cos(a[i]));
+         break;
+      case OPCODE_DDX:
+      case OPCODE_DDY:
+         FOR_EACH_DST_CHANNEL(inst, chan) {
+            fetch_channel_deriv(m, &inst->SrcReg[0], chan,
+                                inst->Opcode == OPCODE_DDY,
+                                p->Result[chan]);
+         }
+         store_result(m, inst, res);
+         break;
+      case OPCODE_DP2:
+      case OPCODE_DP3:
+      case OPCODE_DP4:
+      case OPCODE_DPH:
+         {
+            const GLuint num = (inst->Opcode == OPCODE_DP2) ? 2 :
+                               (inst->Opcode == OPCODE_DP4) ? 4 : 3;
+            const GLfloat *a[4], *b[4];
+            GLfloat *r = p->Result[0];
+
+            for (chan = 0; chan < num; chan++) {
+               a[chan] = fetch_channel(m, &inst->SrcReg[0], chan,
+                                       p->Src[0][chan]);
+               b[chan] = fetch_channel(m, &inst->SrcReg[1], chan,
+                                       p->Src[1][chan]);
+            }
+            if (num == 2) {
+               for (i = 0; i < n; i++)
+                  r[i] = a[0][i] * b[0][i] + a[1][i] * b[1][i];
+            }
+            else if (num == 3) {
+               for (i = 0; i < n; i++)
+                  r[i] = a[0][i] * b[0][i] + a[1][i] * b[1][i] +
+                         a[2][i] * b[2][i];
+            }
+            else {
+               for (i = 0; i < n; i++)
+                  r[i] = a[0][i] * b[0][i] + a[1][i] * b[1][i] +
+                         a[2][i] * b[2][i] + a[3][i] * b[3][i];
+            }
+            if (inst->Opcode == OPCODE_DPH) {
+               const GLfloat *bw = fetch_channel(m, &inst->SrcReg[1], 3,
+                                                 p->Src[1][3]);
+               for (i = 0; i < n; i++)
+                  r[i] = r[i] + bw[i];
+            }
+            store_scalar(m, inst, r);
+         }
+         break;
+      case OPCODE_DST:
+         {
+            const GLfloat *a1 = fetch_channel(m, &inst->SrcReg[0], 1,
+                                              p->Src[0][1]);
+            const GLfloat *a2 = fetch_channel(m, &inst->SrcReg[0], 2,
+                                              p->Src[0][2]);
+            const GLfloat *b1 = fetch_channel(m, &inst->SrcReg[1], 1,
+                                              p->Src[1][1]);
+            const GLfloat *b3 = fetch_channel(m, &inst->SrcReg[1], 3,
+                                              p->Src[1][3]);
+            for (i = 0; i < n; i++) {
+               p->Result[0][i] = 1.0F;
+               p->Result[1][i] = a1[i] * b1[i];
+               p->Result[2][i] = a2[i];
+               p->Result[3][i] = b3[i];
+            }
+            store_result(m, inst, res);
+         }
+         break;
+      case OPCODE_EX2:
+         SCALAR_OP((GLfloat) pow(2.0, a[i]));
+         break;
+      case OPCODE_FLR:
+         UNARY_OP(FLOORF(a[i]));
+         break;
+      case OPCODE_FRC:
+         UNARY_OP(a[i] - FLOORF(a[i]));
+         break;
+      case OPCODE_KIL:
+         {
+            const GLfloat *a[4];
+            for (chan = 0; chan < 4; chan++)
+               a[chan] = fetch_channel(m, &inst->SrcReg[0], chan,
+                                       p->Src[0][chan]);
+            for (i = 0; i < n; i++) {
+               if (m->Exec[i] &&
+                   (a[0][i] < 0.0F || a[1][i] < 0.0F ||
+                    a[2][i] < 0.0F || a[3][i] < 0.0F)) {
+                  m->Exec[i] = m->Live[i] = GL_FALSE;
+               }
+            }
+         }
+         break;
+      case OPCODE_KIL_NV:
+         /* condition codes aren't supported, so this is unconditional */
+         for (i = 0; i < n; i++) {
+            if (m->Exec[i])
+               m->Exec[i] = m->Live[i] = GL_FALSE;
+         }
+         break;
+      case OPCODE_LG2:
+         /* The fast LOG2 macro doesn't meet the precision requirements. */
+         SCALAR_OP(a[i] == 0.0F ? -FLT_MAX
+                                : (GLfloat) (log(a[i]) * 1.442695F));
+         break;
+      case OPCODE_LIT:
+         {
+            const GLfloat epsilon = 1.0F / 256.0F;      /* from NV VP spec */
+            const GLfloat *a[4];
+            for (chan = 0; chan < 4; chan++)
+               a[chan] = fetch_channel(m, &inst->SrcReg[0], chan,
+                                       p->Src[0][chan]);
+            for (i = 0; i < n; i++) {
+               const GLfloat a0 = MAX2(a[0][i], 0.0F);
+               const GLfloat a1 = MAX2(a[1][i], 0.0F);
+               const GLfloat a3 = CLAMP(a[3][i], -(128.0F - epsilon),
+                                        (128.0F - epsilon));
+               p->Result[0][i] = 1.0F;
+               p->Result[1][i] = a0;
+               if (a0 > 0.0F) {
+                  if (a1 == 0.0 && a3 == 0.0)
+                     p->Result[2][i] = 1.0F;
+                  else
+                     p->Result[2][i] = (GLfloat) pow(a1, a3);
+               }
+               else {
+                  p->Result[2][i] = 0.0F;
+               }
+               p->Result[3][i] = 1.0F;
+            }
+            store_result(m, inst, res);
+         }
+         break;
+      case OPCODE_LRP:
+         TERNARY_OP(a[i] * b[i] + (1.0F - a[i]) * c[i]);
+         break;
+      case OPCODE_MAD:
+         TERNARY_OP(a[i] * b[i] + c[i]);
+         break;
+      case OPCODE_MAX:
+         BINARY_OP(MAX2(a[i], b[i]));
+         break;
+      case OPCODE_MIN:
+         BINARY_OP(MIN2(a[i], b[i]));
+         break;
+      case OPCODE_MOV:
+      case OPCODE_SWZ:
+         /* copy through Result in case src and dst are the same register */
+         UNARY_OP(a[i]);
+         break;
+      case OPCODE_MUL:
+         BINARY_OP(a[i] * b[i]);
+         break;
+      case OPCODE_POW:
+         {
+            const GLfloat *a = fetch_channel(m, &inst->SrcReg[0], 0,
+                                             p->Src[0][0]);
+            const GLfloat *b = fetch_channel(m, &inst->SrcReg[1], 0,
+                                             p->Src[1][0]);
+            GLfloat *r = p->Result[0];
+            for (i = 0; i < n; i++)
+               r[i] = (GLfloat) pow(a[i], b[i]);
+            store_scalar(m, inst, r);
+         }
+         break;
+      case OPCODE_RCP:
+         SCALAR_OP(1.0F / a[i]);
+         break;
+      case OPCODE_RSQ:
+         SCALAR_OP(INV_SQRTF(FABSF(a[i])));
+         break;
+      case OPCODE_SCS:
+         {
+            const GLfloat *a = fetch_channel(m, &inst->SrcReg[0], 0,
+                                             p->Src[0][0]);
+            for (i = 0; i < n; i++) {
+               p->Result[0][i] = (GLfloat) cos(a[i]);
+               p->Result[1][i] = (GLfloat) sin(a[i]);
+               p->Result[2][i] = 0.0F;    /* undefined! */
+               p->Result[3][i] = 0.0F;    /* undefined! */
+            }
+            store_result(m, inst, res);
+         }
+         break;
+      case OPCODE_SEQ:
+         BINARY_OP((a[i] == b[i]) ? 1.0F : 0.0F);
+         break;
+      case OPCODE_SFL:
+      case OPCODE_STR:
+         {
+            const GLfloat v = (inst->Opcode == OPCODE_STR) ? 1.0F : 0.0F;
+            for (i = 0; i < n; i++)
+               p->Result[0][i] = v;
+            store_scalar(m, inst, p->Result[0]);
+         }
+         break;
+      case OPCODE_SGE:
+         BINARY_OP((a[i] >= b[i]) ? 1.0F : 0.0F);
+         break;
+      case OPCODE_SGT:
+         BINARY_OP((a[i] > b[i]) ? 1.0F : 0.0F);
+         break;
+      case OPCODE_SIN:
+         SCALAR_OP((GLfloat) sin(a[i]));
+         break;
+      case OPCODE_SLE:
+         BINARY_OP((a[i] <= b[i]) ? 1.0F : 0.0F);
+         break;
+      case OPCODE_SLT:
+         BINARY_OP((a[i] < b[i]) ? 1.0F : 0.0F);
+         break;
+      case OPCODE_SNE:
+         BINARY_OP((a[i] != b[i]) ? 1.0F : 0.0F);
+         break;
+      case OPCODE_SSG:
+         UNARY_OP((GLfloat) ((a[i] > 0.0F) - (a[i] < 0.0F)));
+         break;
+      case OPCODE_SUB:
+         BINARY_OP(a[i] - b[i]);
+         break;
+      case OPCODE_TEX:
+      case OPCODE_TXB:
+      case OPCODE_TXL:
+      case OPCODE_TXP:
+         exec_tex(m, inst);
+         break;
+      case OPCODE_TRUNC:
+         UNARY_OP((GLfloat) (GLint) a[i]);
+         break;
+      case OPCODE_XPD:
+         {
+            const GLfloat *a[3], *b[3];
+            for (chan = 0; chan < 3; chan++) {
+               a[chan] = fetch_channel(m, &inst->SrcReg[0], chan,
+                                       p->Src[0][chan]);
+               b[chan] = fetch_channel(m, &inst->SrcReg[1], chan,
+                                       p->Src[1][chan]);
+            }
+            for (i = 0; i < n; i++) {
+               p->Result[0][i] = a[1][i] * b[2][i] - a[2][i] * b[1][i];
+               p->Result[1][i] = a[2][i] * b[0][i] - a[0][i] * b[2][i];
+               p->Result[2][i] = a[0][i] * b[1][i] - a[1][i] * b[0][i];
+               p->Result[3][i] = 1.0F;
+            }
+            store_result(m, inst, res);
+         }
+         break;
+
+      case OPCODE_IF:
+         {
+            const GLfloat *a = fetch_channel(m, &inst->SrcReg[0], 0,
+                                             p->Src[0][0]);
+            GLboolean any = GL_FALSE;
+
+            memcpy(execStack[depth], m->Exec, n);
+            for (i = 0; i < n; i++) {
+               condStack[depth][i] = (a[i] != 0.0);
+               m->Exec[i] = m->Exec[i] && condStack[depth][i];
+               any |= m->Exec[i];
+            }
+            depth++;
+            m->predicate = GL_TRUE;
+
+            if (!any) {
+               /* go to the ELSE or ENDIF */
+               pc = inst->BranchTarget - 1;
+            }
+         }
+         break;
+      case OPCODE_ELSE:
+         {
+            const GLubyte *cond = condStack[depth - 1];
+            const GLubyte *exec = execStack[depth - 1];
+            GLboolean any = GL_FALSE;
+
+            for (i = 0; i < n; i++) {
+               m->Exec[i] = exec[i] && !cond[i] && m->Live[i];
+               any |= m->Exec[i];
+            }
+
+            if (!any) {
+               /* go to the ENDIF */
+               pc = inst->BranchTarget - 1;
+            }
+         }
+         break;
+      case OPCODE_ENDIF:
+         depth--;
+         for (i = 0; i < n; i++)
+            m->Exec[i] = execStack[depth][i] && m->Live[i];
+         m->predicate = (depth > 0);
+         break;
+
+      default:
+         _mesa_problem(m->ctx, "Bad opcode %d in run_chunk()",
+                       inst->Opcode);
+         return;
+      }
+   }
+}
+
+
+/**
+ * Execute the current fragment program for all the fragments in the span
+ * with the span interpreter.
+ * \return GL_FALSE if the program can't be run this way, in which case
+ *         nothing was done.
+ */
+GLboolean
+_swrast_exec_fragment_program_soa(struct gl_context *ctx, SWspan *span)
+{
+   const struct gl_fragment_program *program = ctx->FragmentProgram._Current;
+   const GLbitfield64 outputsWritten = program->Base.OutputsWritten;
+   struct swrast_soa_program *p = get_soa_program(ctx, program);
+   struct soa_machine m;
+   GLuint start;
+
+   if (!p || !p->Supported)
+      return GL_FALSE;
+
+   m.ctx = ctx;
+   m.p = p;
+   m.span = span;
+
+   for (start = 0; start < span->end; start += SOA_WIDTH) {
+      const GLuint n = MIN2(span->end - start, SOA_WIDTH);
+      GLboolean any = GL_FALSE;
+      GLuint i;
+
+      m.start = start;
+      m.n = n;
+
+      /* per-fragment setup, as in init_machine() */
+      for (i = 0; i < n; i++) {
+         const GLuint col = start + i;
+         m.Live[i] = span->array->mask[col];
+         if (m.Live[i]) {
+            GLfloat *wpos = span->array->attribs[FRAG_ATTRIB_WPOS][col];
+
+            /* ARB_fragment_coord_conventions */
+            if (program->OriginUpperLeft)
+               wpos[1] = ctx->DrawBuffer->Height - 1 - wpos[1];
+            if (!program->PixelCenterInteger) {
+               wpos[0] += 0.5F;
+               wpos[1] += 0.5F;
+            }
+
+            /* if running a GLSL program (not ARB_fragment_program) */
+            if (ctx->Shader.CurrentFragmentProgram) {
+               /* Store front/back facing value */
+               span->array->attribs[FRAG_ATTRIB_FACE][col][0] =
+                  1.0F - span->facing;
+            }
+
+            any = GL_TRUE;
+         }
+      }
+
+      if (!any)
+         continue;
+
+      if (program->Base.Target == GL_FRAGMENT_PROGRAM_NV) {
+         /* Clear temporary registers (undefined for ARB_f_p) */
+         memset(p->Temps, 0, p->NumTemps * sizeof(*p->Temps));
+      }
+
+      run_chunk(&m);
+
+      /* store results, as in run_program() */
+      for (i = 0; i < n; i++) {
+         const GLuint col = start + i;
+
+         if (!span->array->mask[col])
+            continue;
+
+         if (!m.Live[i]) {
+            /* killed fragment */
+            span->array->mask[col] = GL_FALSE;
+            span->writeAll = GL_FALSE;
+            continue;
+         }
+
+         if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_COLOR)) {
+            GLfloat *color = span->array->attribs[FRAG_ATTRIB_COL0][col];
+            color[0] = p->Outputs[FRAG_RESULT_COLOR][0][i];
+            color[1] = p->Outputs[FRAG_RESULT_COLOR][1][i];
+            color[2] = p->Outputs[FRAG_RESULT_COLOR][2][i];
+            color[3] = p->Outputs[FRAG_RESULT_COLOR][3][i];
+         }
+         else {
+            GLuint buf;
+            for (buf = 0; buf < ctx->DrawBuffer->_NumColorDrawBuffers; buf++) {
+               if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_DATA0 + buf)) {
+                  GLfloat *color =
+                     span->array->attribs[FRAG_ATTRIB_COL0 + buf][col];
+                  color[0] = p->Outputs[FRAG_RESULT_DATA0 + buf][0][i];
+                  color[1] = p->Outputs[FRAG_RESULT_DATA0 + buf][1][i];
+                  color[2] = p->Outputs[FRAG_RESULT_DATA0 + buf][2][i];
+                  color[3] = p->Outputs[FRAG_RESULT_DATA0 + buf][3][i];
+               }
+            }
+         }
+
+         if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_DEPTH)) {
+            const GLfloat depth = p->Outputs[FRAG_RESULT_DEPTH][2][i];
+            if (depth <= 0.0)
+               span->array->z[col] = 0;
+            else if (depth >= 1.0)
+               span->array->z[col] = ctx->DrawBuffer->_DepthMax;
+            else
+               span->array->z[col] = IROUND(depth * ctx->DrawBuffer->_DepthMaxF);
+         }
+      }
+   }
+
+   return GL_TRUE;
+}
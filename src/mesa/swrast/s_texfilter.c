@@ -643,6 +643,25 @@ nearest_mipmap_level(const struct gl_texture_object *tObj, GLfloat lambda)
 
 
 
+/**
+ * Return the lambda above which the texture is minified rather than
+ * magnified.
+ */
+GLfloat
+_swrast_min_mag_threshold(const struct gl_texture_object *tObj)
+{
+   /* This bit comes from the OpenGL spec: */
+   if (tObj->MagFilter == GL_LINEAR
+       && (tObj->MinFilter == GL_NEAREST_MIPMAP_NEAREST ||
+           tObj->MinFilter == GL_NEAREST_MIPMAP_LINEAR)) {
+      return 0.5F;
+   }
+   else {
+      return 0.0F;
+   }
+}
+
+
 /**
  * The lambda[] array values are always monotonic.  Either the whole span
  * will be minified, magnified, or split between the two.  This function
@@ -654,21 +673,11 @@ compute_min_mag_ranges(const struct gl_texture_object *tObj,
                        GLuint *minStart, GLuint *minEnd,
                        GLuint *magStart, GLuint *magEnd)
 {
-   GLfloat minMagThresh;
+   const GLfloat minMagThresh = _swrast_min_mag_threshold(tObj);
 
    /* we shouldn't be here if minfilter == magfilter */
    ASSERT(tObj->MinFilter != tObj->MagFilter);
 
-   /* This bit comes from the OpenGL spec: */
-   if (tObj->MagFilter == GL_LINEAR
-       && (tObj->MinFilter == GL_NEAREST_MIPMAP_NEAREST ||
-           tObj->MinFilter == GL_NEAREST_MIPMAP_LINEAR)) {
-      minMagThresh = 0.5F;
-   }
-   else {
-      minMagThresh = 0.0F;
-   }
-
 #if 0
    /* DEBUG CODE: Verify that lambda[] is monotonic.
     * We can't really use this because the inaccuracy in the LOG2 function
@@ -226,6 +226,17 @@ void _vbo_DestroyContext( struct gl_context *ctx )
    if (vbo) {
       GLuint i;
 
+      if ((MESA_VERBOSE & VERBOSE_DRAW) &&
+          (vbo->split_stats.inplace ||
+           vbo->split_stats.rebased ||
+           vbo->split_stats.copied)) {
+         _mesa_debug(ctx, "vbo split: %u inplace, %u rebased, "
+                     "%u vbo_split_copy() calls\n",
+                     vbo->split_stats.inplace,
+                     vbo->split_stats.rebased,
+                     vbo->split_stats.copied);
+      }
+
       for (i = 0; i < VBO_ATTRIB_MAX; i++) {
          _mesa_reference_buffer_object(ctx, &vbo->currval[i].BufferObj, NULL);
       }
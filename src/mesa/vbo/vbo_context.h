@@ -82,6 +82,15 @@ struct vbo_context {
     * is responsible for initiating any fallback actions required:
     */
    vbo_draw_func draw_prims;
+
+   /* How often vbo_split_prims() had to break up draws, reported at
+    * context destruction with MESA_VERBOSE=draw:
+    */
+   struct {
+      GLuint inplace;		/**< split without copying */
+      GLuint rebased;		/**< sub-draws of too large index ranges */
+      GLuint copied;		/**< vbo_split_copy() calls */
+   } split_stats;
 };
 
 
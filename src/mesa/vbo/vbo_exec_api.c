@@ -584,6 +584,72 @@ static void GLAPIENTRY vbo_exec_End( void )
 }
 
 
+#if FEATURE_arrayelt
+
+/**
+ * Called via glArrayElement().  Between glBegin/glEnd, when the enabled
+ * arrays are plain float arrays, copy the element straight into the
+ * current vertex rather than issuing a glNormal, glColor, ..., glVertex
+ * call per array like _ae_ArrayElement() does.  The attribute sizes and
+ * the order of the updates are the same as with those calls.
+ */
+static void GLAPIENTRY vbo_exec_ArrayElement( GLint elt )
+{
+   GET_CURRENT_CONTEXT( ctx );
+   struct vbo_exec_context *exec = &vbo_context(ctx)->exec;
+   const struct _ae_direct_array *da;
+   GLuint i;
+
+   if (ctx->Driver.CurrentExecPrimitive == PRIM_OUTSIDE_BEGIN_END ||
+       !(da = _ae_get_direct_arrays(ctx))) {
+      _ae_ArrayElement(elt);
+      return;
+   }
+
+   if (unlikely(!(ctx->Driver.NeedFlush & FLUSH_UPDATE_CURRENT)))
+      ctx->Driver.BeginVertices( ctx );
+
+   for ( ; da->size; da++) {
+      const GLubyte *src = da->ptr + elt * da->stride;
+      GLfloat *dest;
+
+      if (unlikely(exec->vtx.active_sz[da->attr] != da->size))
+	 vbo_exec_fixup_vertex(ctx, da->attr, da->size);
+
+      dest = exec->vtx.attrptr[da->attr];
+
+      if (da->type == GL_FLOAT) {
+	 const GLfloat *f = (const GLfloat *) src;
+
+	 switch (da->size) {
+	 case 4: dest[3] = f[3];
+	 case 3: dest[2] = f[2];
+	 case 2: dest[1] = f[1];
+	 case 1: dest[0] = f[0];
+	 }
+      }
+      else {
+	 dest[0] = UBYTE_TO_FLOAT(src[0]);
+	 dest[1] = UBYTE_TO_FLOAT(src[1]);
+	 dest[2] = UBYTE_TO_FLOAT(src[2]);
+	 dest[3] = da->comps == 4 ? UBYTE_TO_FLOAT(src[3]) : 1.0F;
+      }
+   }
+
+   /* The position came last, emit the vertex as in ATTR() */
+   for (i = 0; i < exec->vtx.vertex_size; i++)
+      exec->vtx.buffer_ptr[i] = exec->vtx.vertex[i];
+
+   exec->vtx.buffer_ptr += exec->vtx.vertex_size;
+   ctx->Driver.NeedFlush |= FLUSH_STORED_VERTICES;
+
+   if (++exec->vtx.vert_count >= exec->vtx.max_vert)
+      vbo_exec_vtx_wrap( exec );
+}
+
+#endif /* FEATURE_arrayelt */
+
+
 /**
  * Called via glPrimitiveRestartNV()
  */
@@ -610,7 +676,7 @@ static void vbo_exec_vtxfmt_init( struct vbo_exec_context *exec )
 {
    GLvertexformat *vfmt = &exec->vtxfmt;
 
-   _MESA_INIT_ARRAYELT_VTXFMT(vfmt, _ae_);
+   _MESA_INIT_ARRAYELT_VTXFMT(vfmt, vbo_exec_);
 
    vfmt->Begin = vbo_exec_Begin;
    vfmt->End = vbo_exec_End;
@@ -131,12 +131,15 @@ void vbo_split_prims( struct gl_context *ctx,
       }
       else if (max_index - min_index >= limits->max_verts) {
 	 /* The vertex buffers are too large for hardware (or the
-	  * swtnl module).  Traverse the indices, re-emitting vertices
-	  * in turn.  Use a vertex cache to preserve some of the
-	  * sharing from the original index list.
+	  * swtnl module).  Split the indices into runs which each
+	  * reference a small enough range of vertices, and draw those
+	  * from the original buffers.  Where the indices are too
+	  * scattered for that, traverse them, re-emitting vertices in
+	  * turn, using a vertex cache to preserve some of the sharing
+	  * from the original index list.
 	  */
-	 vbo_split_copy(ctx, arrays, prim, nr_prims, ib,
-			draw, limits );
+	 vbo_split_rebase(ctx, arrays, prim, nr_prims, ib,
+			  draw, limits );
       }
       else if (ib->count > limits->max_indices) {
 	 /* The index buffer is too large for hardware.  Try to split
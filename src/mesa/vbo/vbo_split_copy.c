@@ -37,7 +37,7 @@
 #include "main/mtypes.h"
 
 #include "vbo_split.h"
-#include "vbo.h"
+#include "vbo_context.h"
 
 
 #define ELT_TABLE_SIZE 16
@@ -588,6 +588,8 @@ void vbo_split_copy( struct gl_context *ctx,
    struct copy_context copy;
    GLuint i, this_nr_prims;
 
+   vbo_context(ctx)->split_stats.copied++;
+
    for (i = 0; i < nr_prims;) {
       /* Our SW TNL pipeline doesn't handle basevertex yet, so bind_indices
        * will rebase the elements to the basevertex, and we'll only
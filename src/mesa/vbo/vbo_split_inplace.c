@@ -28,17 +28,18 @@
 
 
 #include "main/mtypes.h"
+#include "main/bufferobj.h"
 #include "main/macros.h"
 #include "main/enums.h"
 #include "main/image.h"
 #include "vbo_split.h"
+#include "vbo_context.h"
 
 
 #define MAX_PRIM 32
 
-/* Used for splitting without copying. No attempt is made to handle
- * too large indexed vertex buffers: In general you need to copy to do
- * that.
+/* Used for splitting without copying. Too large indexed vertex buffers
+ * are handled by vbo_split_rebase() below where the indices allow it.
  */
 struct split_context {
    struct gl_context *ctx;
@@ -277,7 +278,251 @@ void vbo_split_inplace( struct gl_context *ctx,
    split.limits = limits;
    split.limit = ib ? limits->max_indices : limits->max_verts;
 
+   vbo_context(ctx)->split_stats.inplace++;
+
    split_prims( &split );
 }
 
 
+
+/* Splitting of indexed primitives which reference too large a range of
+ * vertices.  Most meshes have good locality: a run of consecutive
+ * elements only references vertices in a small range.  So instead of
+ * copying every vertex, break the element list into runs whose vertex
+ * range fits the limits, and draw each run directly from the original
+ * arrays with its own min_index/max_index.  The driver then rebases the
+ * run (see vbo_rebase_prims()), which just offsets the array pointers.
+ *
+ * Only runs which come out much smaller than the vertex limit, i.e. the
+ * elements are scattered over the arrays, are passed to vbo_split_copy().
+ */
+
+/* Runs shorter than 1/MIN_RUN_FRACTION of the vertex limit are copied */
+#define MIN_RUN_FRACTION 8
+
+struct split_run {
+   GLuint prim;                 /**< index into the incoming prims */
+   GLuint start, count;         /**< elements, relative to the prim */
+   GLuint min_index, max_index;
+   GLboolean copy;
+};
+
+struct rebase_context {
+   const struct _mesa_prim *prim;
+   const struct split_limits *limits;
+   const void *elts;
+   GLenum type;
+
+   struct split_run *run;
+   GLuint nr_runs, max_runs;
+};
+
+
+static INLINE GLuint get_elt( const struct rebase_context *rebase, GLuint i )
+{
+   switch (rebase->type) {
+   case GL_UNSIGNED_INT:
+      return ((const GLuint *) rebase->elts)[i];
+   case GL_UNSIGNED_SHORT:
+      return ((const GLushort *) rebase->elts)[i];
+   default:
+      return ((const GLubyte *) rebase->elts)[i];
+   }
+}
+
+
+static GLboolean add_run( struct rebase_context *rebase, GLuint prim,
+			  GLuint start, GLuint count,
+			  GLuint min_index, GLuint max_index,
+			  GLboolean copy )
+{
+   struct split_run *run;
+
+   if (rebase->nr_runs == rebase->max_runs) {
+      GLuint max_runs = MAX2(16, rebase->max_runs * 2);
+      run = realloc(rebase->run, max_runs * sizeof(*run));
+      if (!run)
+	 return GL_FALSE;
+      rebase->run = run;
+      rebase->max_runs = max_runs;
+   }
+
+   run = &rebase->run[rebase->nr_runs++];
+   run->prim = prim;
+   run->start = start;
+   run->count = count;
+   run->min_index = min_index;
+   run->max_index = max_index;
+   run->copy = copy;
+   return GL_TRUE;
+}
+
+
+/* Break one primitive into runs of elements, as large as the limits
+ * allow.  The runs overlap where needed to keep strips connected, like
+ * in split_prims() above.
+ */
+static GLboolean find_runs( struct rebase_context *rebase, GLuint nr )
+{
+   const struct _mesa_prim *prim = &rebase->prim[nr];
+   const struct split_limits *limits = rebase->limits;
+   const GLuint min_run = limits->max_verts / MIN_RUN_FRACTION;
+   GLuint first, incr, count, j;
+
+   if (!split_prim_inplace(prim->mode, &first, &incr))
+      return add_run(rebase, nr, 0, prim->count, 0, 0, GL_TRUE);
+
+   if (prim->count < first)
+      return GL_TRUE;
+
+   count = prim->count - (prim->count - first) % incr;
+
+   for (j = 0; j < count; ) {
+      GLuint lo = ~0, hi = 0;
+      GLuint len = 0, step = first;
+
+      /* Grow the run one primitive at a time while the range fits */
+      while (j + len + step <= count && len + step <= limits->max_indices) {
+	 GLuint newlo = lo, newhi = hi, k;
+
+	 for (k = j + len; k < j + len + step; k++) {
+	    GLuint elt = get_elt(rebase, prim->start + k);
+	    newlo = MIN2(newlo, elt);
+	    newhi = MAX2(newhi, elt);
+	 }
+
+	 if (newhi - newlo >= limits->max_verts)
+	    break;
+
+	 lo = newlo;
+	 hi = newhi;
+	 len += step;
+	 step = incr;
+      }
+
+      /* Keep the winding of split triangle strips: the next run must
+       * start on an even triangle.
+       */
+      if (prim->mode == GL_TRIANGLE_STRIP && j + len < count &&
+	  len > first && (len - (first - incr)) % 2)
+	 len--;
+
+      if (len < first ||
+	  (j + len < count && len < min_run)) {
+	 /* Scattered elements: copy the rest of the primitive */
+	 return add_run(rebase, nr, j, prim->count - j, 0, 0, GL_TRUE);
+      }
+
+      if (!add_run(rebase, nr, j, len, lo, hi, GL_FALSE))
+	 return GL_FALSE;
+
+      if (j + len == count)
+	 break;
+
+      j += len - (first - incr);
+   }
+
+   return GL_TRUE;
+}
+
+
+static void draw_runs( struct gl_context *ctx,
+		       const struct gl_client_array *arrays[],
+		       const struct _mesa_index_buffer *ib,
+		       const struct rebase_context *rebase,
+		       vbo_draw_func draw )
+{
+   const GLuint elt_size = _mesa_sizeof_type(ib->type);
+   GLuint i;
+
+   for (i = 0; i < rebase->nr_runs; i++) {
+      const struct split_run *run = &rebase->run[i];
+      const struct _mesa_prim *prim = &rebase->prim[run->prim];
+      struct _mesa_index_buffer run_ib;
+      struct _mesa_prim run_prim;
+
+      run_prim = *prim;
+      run_prim.begin = (run->start == 0 && prim->begin);
+      run_prim.end = (run->start + run->count == prim->count && prim->end);
+      run_prim.count = run->count;
+
+      if (run->copy) {
+	 run_prim.start = prim->start + run->start;
+	 vbo_split_copy(ctx, arrays, &run_prim, 1, ib, draw,
+			rebase->limits);
+	 continue;
+      }
+
+      /* Point the index buffer at the run so that only its elements
+       * need rebasing.
+       */
+      run_ib = *ib;
+      run_ib.count = run->count;
+      run_ib.ptr = (const GLubyte *) ib->ptr +
+	 (prim->start + run->start) * elt_size;
+      run_prim.start = 0;
+
+      vbo_context(ctx)->split_stats.rebased++;
+
+      draw(ctx, arrays, &run_prim, 1, &run_ib, GL_TRUE,
+	   run->min_index, run->max_index);
+   }
+}
+
+
+/* Requires ib != NULL.  Falls back to vbo_split_copy() for all prims if
+ * they use basevertex, or on out of memory.
+ */
+void vbo_split_rebase( struct gl_context *ctx,
+		       const struct gl_client_array *arrays[],
+		       const struct _mesa_prim *prim,
+		       GLuint nr_prims,
+		       const struct _mesa_index_buffer *ib,
+		       vbo_draw_func draw,
+		       const struct split_limits *limits )
+{
+   struct rebase_context rebase;
+   GLboolean mapped = GL_FALSE;
+   GLboolean ok = GL_TRUE;
+   GLuint i;
+
+   assert(ib);
+
+   for (i = 0; i < nr_prims; i++) {
+      if (prim[i].basevertex != 0) {
+	 vbo_split_copy(ctx, arrays, prim, nr_prims, ib, draw, limits);
+	 return;
+      }
+   }
+
+   memset(&rebase, 0, sizeof(rebase));
+   rebase.prim = prim;
+   rebase.limits = limits;
+   rebase.type = ib->type;
+
+   /* Find the runs first, then draw them: vbo_split_copy() will unmap
+    * the index buffer when it is done.
+    */
+   if (_mesa_is_bufferobj(ib->obj) && !_mesa_bufferobj_mapped(ib->obj)) {
+      ctx->Driver.MapBuffer(ctx, GL_ELEMENT_ARRAY_BUFFER, GL_READ_ONLY,
+			    ib->obj);
+      mapped = GL_TRUE;
+   }
+
+   rebase.elts = ADD_POINTERS(ib->obj->Pointer, ib->ptr);
+
+   for (i = 0; i < nr_prims && ok; i++)
+      ok = find_runs(&rebase, i);
+
+   if (mapped)
+      ctx->Driver.UnmapBuffer(ctx, GL_ELEMENT_ARRAY_BUFFER, ib->obj);
+
+   if (ok)
+      draw_runs(ctx, arrays, ib, &rebase, draw);
+   else
+      vbo_split_copy(ctx, arrays, prim, nr_prims, ib, draw, limits);
+
+   free(rebase.run);
+}
+
+